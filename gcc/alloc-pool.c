@@ -22,6 +22,8 @@ along with GCC; see the file COPYING3.  If not see
 #include "system.h"
 #include "coretypes.h"
 #include "alloc-pool.h"
+#include "obstack.h"
+#include "selftest.h"
 
 ALLOC_POOL_ID_TYPE last_id;
 mem_alloc_description<pool_usage> pool_allocator_usage;
@@ -36,3 +38,86 @@ dump_alloc_pool_statistics (void)
 
   pool_allocator_usage.dump (ALLOC_POOL_ORIGIN);
 }
+
+#if CHECKING_P
+
+namespace selftest {
+
+/* The number of objects allocated at once by the benchmarks below.  */
+
+static const unsigned int bench_batch_size = 256;
+
+/* A typical small object allocated from a pool.  */
+
+struct bench_object
+{
+  void *link;
+  int data[6];
+};
+
+/* Benchmark: allocating objects from a pool and returning them, in
+   batches, so that the free list is exercised.  */
+
+static void
+bench_pool_allocate_remove (unsigned int iterations)
+{
+  object_allocator <bench_object> pool ("benchmark pool");
+  bench_object *batch[bench_batch_size];
+  unsigned int n = 0;
+  size_t sum = 0;
+
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      batch[n++] = pool.allocate ();
+      if (n == bench_batch_size)
+	{
+	  /* Return every other object first, to shuffle the free list.  */
+	  for (unsigned int j = 0; j < n; j += 2)
+	    pool.remove (batch[j]);
+	  for (unsigned int j = 1; j < n; j += 2)
+	    pool.remove (batch[j]);
+	  sum += (size_t) batch[0];
+	  n = 0;
+	}
+    }
+  for (unsigned int j = 0; j < n; j++)
+    pool.remove (batch[j]);
+  benchmark_consume (sum);
+}
+
+/* Benchmark: small allocations from an obstack, freed in batches.  */
+
+static void
+bench_obstack_alloc (unsigned int iterations)
+{
+  struct obstack ob;
+  gcc_obstack_init (&ob);
+  void *base = obstack_alloc (&ob, 0);
+  size_t sum = 0;
+
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      void *p = obstack_alloc (&ob, 8 + (i & 7) * 4);
+      if ((i + 1) % bench_batch_size == 0)
+	{
+	  sum += (size_t) p;
+	  obstack_free (&ob, base);
+	  base = obstack_alloc (&ob, 0);
+	}
+    }
+  obstack_free (&ob, NULL);
+  benchmark_consume (sum);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+alloc_pool_c_benchmarks ()
+{
+  run_benchmark ("alloc_pool/allocate_remove", bench_pool_allocate_remove);
+  run_benchmark ("obstack/alloc", bench_obstack_alloc);
+}
+
+} // namespace selftest
+
+#endif /* CHECKING_P */
@@ -57,6 +57,11 @@ static void bitmap_element_link (bitmap, bitmap_element *);
 static bitmap_element *bitmap_elt_insert_after (bitmap, bitmap_element *, unsigned int);
 static void bitmap_elt_clear_from (bitmap, bitmap_element *);
 static bitmap_element *bitmap_find_bit (bitmap, unsigned int);
+static void bitmap_index_release (bitmap);
+
+/* Number of elements that bitmap_find_bit may step over before it
+   decides that the bitmap needs an element index.  */
+#define BITMAP_INDEX_WALK_LIMIT 32
 
 
 /* Add ELEM to the appropriate freelist.  */
@@ -78,6 +83,69 @@ bitmap_elem_to_freelist (bitmap head, bitmap_element *elt)
     }
 }
 
+/* Return the slot of INDEX that covers element index INDX.  */
+
+static inline unsigned int
+bitmap_index_slot (const bitmap_elt_index *index, unsigned int indx)
+{
+  unsigned int slot = indx >> index->shift;
+  unsigned int last = (1u << index->log2_slots) - 1;
+
+  return slot < last ? slot : last;
+}
+
+/* Note that ELT has been added to bitmap HEAD, or has had its element
+   index changed.  */
+
+static inline void
+bitmap_index_add (bitmap head, bitmap_element *elt)
+{
+  bitmap_elt_index *index = head->index;
+
+  if (!index)
+    return;
+
+  index->n_elements++;
+  if (elt->indx > index->max_indx)
+    index->max_indx = elt->indx;
+  index->slots[bitmap_index_slot (index, elt->indx)] = elt;
+}
+
+/* Note that ELT is about to be unlinked from bitmap HEAD, or to have
+   its element index changed.  If the slot covering ELT points to it,
+   point it to a neighbor of ELT covered by the same slot, if any.  */
+
+static inline void
+bitmap_index_remove (bitmap head, bitmap_element *elt)
+{
+  bitmap_elt_index *index = head->index;
+
+  if (!index)
+    return;
+
+  index->n_elements--;
+  unsigned int slot = bitmap_index_slot (index, elt->indx);
+  if (index->slots[slot] != elt)
+    return;
+
+  if (elt->next && bitmap_index_slot (index, elt->next->indx) == slot)
+    index->slots[slot] = elt->next;
+  else if (elt->prev && bitmap_index_slot (index, elt->prev->indx) == slot)
+    index->slots[slot] = elt->prev;
+  else
+    index->slots[slot] = NULL;
+}
+
+/* Set the element index of ELT, an element of bitmap HEAD, to INDX.  */
+
+static inline void
+bitmap_elt_set_indx (bitmap head, bitmap_element *elt, unsigned int indx)
+{
+  bitmap_index_remove (head, elt);
+  elt->indx = indx;
+  bitmap_index_add (head, elt);
+}
+
 /* Free a bitmap element.  Since these are allocated off the
    bitmap_obstack, "free" actually means "put onto the freelist".  */
 
@@ -87,6 +155,8 @@ bitmap_element_free (bitmap head, bitmap_element *elt)
   bitmap_element *next = elt->next;
   bitmap_element *prev = elt->prev;
 
+  bitmap_index_remove (head, elt);
+
   if (prev)
     prev->next = next;
 
@@ -192,12 +262,26 @@ bitmap_elt_clear_from (bitmap head, bitmap_element *elt)
 	  head->current = prev;
 	  head->indx = prev->indx;
 	}
+
+      /* Clear the slots that point to the elements being removed.  */
+      if (head->index)
+	{
+	  bitmap_elt_index *index = head->index;
+	  for (bitmap_element *e = elt; e; e = e->next)
+	    {
+	      unsigned int slot = bitmap_index_slot (index, e->indx);
+	      if (index->slots[slot] == e)
+		index->slots[slot] = NULL;
+	      index->n_elements--;
+	    }
+	}
     }
   else
     {
       head->first = NULL;
       head->current = NULL;
       head->indx = 0;
+      bitmap_index_release (head);
     }
 
   /* Put the entire list onto the free list in one operation. */
@@ -220,6 +304,7 @@ bitmap_clear (bitmap head)
 {
   if (head->first)
     bitmap_elt_clear_from (head, head->first);
+  bitmap_index_release (head);
 }
 
 /* Initialize a bitmap obstack.  If BIT_OBSTACK is NULL, initialize
@@ -241,6 +326,7 @@ bitmap_obstack_initialize (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  memset (bit_obstack->indexes, 0, sizeof (bit_obstack->indexes));
   obstack_specify_allocation (&bit_obstack->obstack, OBSTACK_CHUNK_SIZE,
 			      __alignof__ (bitmap_element),
 			      obstack_chunk_alloc,
@@ -265,6 +351,7 @@ bitmap_obstack_release (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  memset (bit_obstack->indexes, 0, sizeof (bit_obstack->indexes));
   obstack_free (&bit_obstack->obstack, NULL);
 }
 
@@ -396,6 +483,7 @@ bitmap_element_link (bitmap head, bitmap_element *element)
   /* Set up so this is the first element searched.  */
   head->current = element;
   head->indx = indx;
+  bitmap_index_add (head, element);
 }
 
 /* Insert a new uninitialized element into bitmap HEAD after element
@@ -430,6 +518,7 @@ bitmap_elt_insert_after (bitmap head, bitmap_element *elt, unsigned int indx)
       elt->next = node;
       node->prev = elt;
     }
+  bitmap_index_add (head, node);
   return node;
 }
 
@@ -491,6 +580,84 @@ bitmap_move (bitmap to, bitmap from)
     }
 }
 
+/* Put the element index of bitmap HEAD, if any, back on the freelist
+   of its obstack.  */
+
+static void
+bitmap_index_release (bitmap head)
+{
+  bitmap_elt_index *index = head->index;
+
+  if (!index)
+    return;
+
+  bitmap_elt_index **freelist
+    = &head->obstack->indexes[index->log2_slots - BITMAP_INDEX_MIN_LOG2_SLOTS];
+  index->next = *freelist;
+  *freelist = index;
+  head->index = NULL;
+}
+
+/* Give obstack bitmap HEAD an element index sized for its current
+   contents, unless the one it has is already the right size.  */
+
+static void
+bitmap_index_update (bitmap head)
+{
+  bitmap_elt_index *index = head->index;
+  bitmap_element *elt;
+  unsigned int n_elements = 0, max_indx = 0;
+
+  if (index)
+    {
+      n_elements = index->n_elements;
+      max_indx = index->max_indx;
+    }
+  else
+    for (elt = head->first; elt; elt = elt->next)
+      {
+	n_elements++;
+	max_indx = MAX (max_indx, elt->indx);
+      }
+
+  /* Aim for about two elements per slot, and for the slots to cover
+     all element indices up to MAX_INDX.  */
+  unsigned int log2_slots = ceil_log2 (n_elements / 2 + 1);
+  log2_slots = MAX (log2_slots, BITMAP_INDEX_MIN_LOG2_SLOTS);
+  log2_slots = MIN (log2_slots, BITMAP_INDEX_MAX_LOG2_SLOTS);
+  unsigned int shift = 0;
+  while ((max_indx >> shift) >> log2_slots)
+    shift++;
+
+  if (index && index->log2_slots == log2_slots && index->shift == shift)
+    return;
+
+  bitmap_index_release (head);
+  bitmap_elt_index **freelist
+    = &head->obstack->indexes[log2_slots - BITMAP_INDEX_MIN_LOG2_SLOTS];
+  size_t n_slots = (size_t) 1 << log2_slots;
+  index = *freelist;
+  if (index)
+    *freelist = index->next;
+  else
+    index = XOBNEWVAR (&head->obstack->obstack, bitmap_elt_index,
+		       sizeof (bitmap_elt_index)
+		       + (n_slots - 1) * sizeof (bitmap_element *));
+
+  index->log2_slots = log2_slots;
+  index->shift = shift;
+  index->n_elements = n_elements;
+  index->max_indx = max_indx;
+  memset (index->slots, 0, n_slots * sizeof (bitmap_element *));
+  for (elt = head->first; elt; elt = elt->next)
+    {
+      unsigned int slot = bitmap_index_slot (index, elt->indx);
+      if (!index->slots[slot])
+	index->slots[slot] = elt;
+    }
+  head->index = index;
+}
+
 /* Find a bitmap element that would hold a bitmap's bit.
    Update the `current' field even if we can't find an element that
    would hold the bitmap's bit to make eventual allocation
@@ -501,6 +668,7 @@ bitmap_find_bit (bitmap head, unsigned int bit)
 {
   bitmap_element *element;
   unsigned int indx = bit / BITMAP_ELEMENT_ALL_BITS;
+  unsigned int steps = 0;
 
   if (head->current == NULL
       || head->indx == indx)
@@ -520,16 +688,39 @@ bitmap_find_bit (bitmap head, unsigned int bit)
   if (GATHER_STATISTICS && usage)
     usage->m_nsearches++;
 
-  if (head->indx < indx)
+  if (head->index)
+    {
+      /* Start from the element that the index has for INDX, or failing
+	 that from the one it has for the closest smaller element index,
+	 and search forward or backward from there.  */
+      bitmap_elt_index *index = head->index;
+      unsigned int slot = bitmap_index_slot (index, indx);
+
+      element = index->slots[slot];
+      while (!element && slot > 0)
+	element = index->slots[--slot];
+      if (!element)
+	element = head->first;
+
+      if (element->indx < indx)
+	for (;
+	     element->next != 0 && element->indx < indx;
+	     element = element->next)
+	  steps++;
+      else
+	for (;
+	     element->prev != 0 && element->indx > indx;
+	     element = element->prev)
+	  steps++;
+    }
+
+  else if (head->indx < indx)
     /* INDX is beyond head->indx.  Search from head->current
        forward.  */
     for (element = head->current;
 	 element->next != 0 && element->indx < indx;
 	 element = element->next)
-      {
-	if (GATHER_STATISTICS && usage)
-	  usage->m_search_iter++;
-      }
+      steps++;
 
   else if (head->indx / 2 < indx)
     /* INDX is less than head->indx and closer to head->indx than to
@@ -537,10 +728,7 @@ bitmap_find_bit (bitmap head, unsigned int bit)
     for (element = head->current;
 	 element->prev != 0 && element->indx > indx;
 	 element = element->prev)
-      {
-	if (GATHER_STATISTICS && usage)
-	  usage->m_search_iter++;
-      }
+      steps++;
 
   else
     /* INDX is less than head->indx and closer to 0 than to
@@ -548,15 +736,23 @@ bitmap_find_bit (bitmap head, unsigned int bit)
     for (element = head->first;
 	 element->next != 0 && element->indx < indx;
 	 element = element->next)
-      if (GATHER_STATISTICS && usage)
-	{
-	  usage->m_search_iter++;
-	}
+      steps++;
+
+  if (GATHER_STATISTICS && usage)
+    usage->m_search_iter += steps;
+
+  /* Long walks mean that the bitmap has outgrown its index, or that it
+     needs one.  GC'd bitmaps go without.  */
+  if (steps > BITMAP_INDEX_WALK_LIMIT && head->obstack)
+    bitmap_index_update (head);
 
   /* `element' is the nearest to the one we want.  If it's not the one we
      want, the one we want doesn't exist.  */
   head->current = element;
   head->indx = element->indx;
+  if (head->index)
+    head->index->slots[bitmap_index_slot (head->index, element->indx)]
+      = element;
   if (element->indx != indx)
     element = 0;
 
@@ -898,7 +1094,7 @@ bitmap_and (bitmap dst, const_bitmap a, const_bitmap b)
 	  if (!dst_elt)
 	    dst_elt = bitmap_elt_insert_after (dst, dst_prev, a_elt->indx);
 	  else
-	    dst_elt->indx = a_elt->indx;
+	    bitmap_elt_set_indx (dst, dst_elt, a_elt->indx);
 	  for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 	    {
 	      BITMAP_WORD r = a_elt->bits[ix] & b_elt->bits[ix];
@@ -1007,7 +1203,7 @@ bitmap_elt_copy (bitmap dst, bitmap_element *dst_elt, bitmap_element *dst_prev,
       if (!dst_elt)
 	dst_elt = bitmap_elt_insert_after (dst, dst_prev, src_elt->indx);
       else
-	dst_elt->indx = src_elt->indx;
+	bitmap_elt_set_indx (dst, dst_elt, src_elt->indx);
       memcpy (dst_elt->bits, src_elt->bits, sizeof (dst_elt->bits));
     }
   return changed;
@@ -1080,7 +1276,7 @@ bitmap_and_compl (bitmap dst, const_bitmap a, const_bitmap b)
 		}
 	      else
 		{
-		  dst_elt->indx = a_elt->indx;
+		  bitmap_elt_set_indx (dst, dst_elt, a_elt->indx);
 		  new_element = false;
 		}
 
@@ -1524,7 +1720,7 @@ bitmap_elt_ior (bitmap dst, bitmap_element *dst_elt, bitmap_element *dst_prev,
 	  if (!dst_elt)
 	    dst_elt = bitmap_elt_insert_after (dst, dst_prev, a_elt->indx);
 	  else
-	    dst_elt->indx = a_elt->indx;
+	    bitmap_elt_set_indx (dst, dst_elt, a_elt->indx);
 	  for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 	    {
 	      BITMAP_WORD r = a_elt->bits[ix] | b_elt->bits[ix];
@@ -1665,7 +1861,7 @@ bitmap_xor (bitmap dst, const_bitmap a, const_bitmap b)
 	  if (!dst_elt)
 	    dst_elt = bitmap_elt_insert_after (dst, dst_prev, a_elt->indx);
 	  else
-	    dst_elt->indx = a_elt->indx;
+	    bitmap_elt_set_indx (dst, dst_elt, a_elt->indx);
 	  for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 	    {
 	      BITMAP_WORD r = a_elt->bits[ix] ^ b_elt->bits[ix];
@@ -1700,7 +1896,7 @@ bitmap_xor (bitmap dst, const_bitmap a, const_bitmap b)
 	  if (!dst_elt)
 	    dst_elt = bitmap_elt_insert_after (dst, dst_prev, src->indx);
 	  else
-	    dst_elt->indx = src->indx;
+	    bitmap_elt_set_indx (dst, dst_elt, src->indx);
 	  memcpy (dst_elt->bits, src->bits, sizeof (dst_elt->bits));
 	  dst_prev = dst_elt;
 	  dst_elt = dst_elt->next;
@@ -2261,6 +2457,119 @@ test_bitmap_single_bit_set_p ()
   ASSERT_EQ (1066, bitmap_first_set_bit (b));
 }
 
+/* Verify that the element index of B, if any, is consistent with the
+   elements of B.  */
+
+static void
+assert_index_valid (bitmap b)
+{
+  bitmap_elt_index *index = b->index;
+  if (!index)
+    return;
+
+  unsigned int n_elements = 0;
+  for (bitmap_element *elt = b->first; elt; elt = elt->next)
+    {
+      n_elements++;
+      ASSERT_TRUE (elt->indx <= index->max_indx);
+    }
+  ASSERT_EQ (n_elements, index->n_elements);
+
+  for (unsigned int slot = 0; slot < (1u << index->log2_slots); slot++)
+    if (bitmap_element *elt = index->slots[slot])
+      {
+	ASSERT_EQ (slot, bitmap_index_slot (index, elt->indx));
+	bitmap_element *e = b->first;
+	while (e && e != elt)
+	  e = e->next;
+	ASSERT_TRUE (e == elt);
+      }
+}
+
+/* Verify that a large obstack bitmap, which gets an element index,
+   behaves like a plain array of bits under random updates, lookups and
+   set operations.  */
+
+static void
+test_indexed_bitmap ()
+{
+  const unsigned int n_bits = 100000;
+  bitmap_obstack ob;
+  bitmap_obstack_initialize (&ob);
+  bitmap b = BITMAP_ALLOC (&ob);
+  bitmap c = BITMAP_ALLOC (&ob);
+  bitmap d = BITMAP_ALLOC (&ob);
+  bool *ref = XCNEWVEC (bool, n_bits);
+  unsigned int seed = 12345;
+
+  for (unsigned int i = 0; i < 50000; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      unsigned int bit = (seed >> 8) % n_bits;
+      if (seed & 0x10000)
+	ASSERT_EQ (!ref[bit], bitmap_set_bit (b, bit));
+      else if (seed & 0x20000)
+	ASSERT_EQ (ref[bit], bitmap_clear_bit (b, bit));
+      else
+	{
+	  ASSERT_EQ (ref[bit], bitmap_bit_p (b, bit));
+	  continue;
+	}
+      ref[bit] = (seed & 0x10000) != 0;
+    }
+  ASSERT_TRUE (b->index != NULL);
+  assert_index_valid (b);
+
+  unsigned long count = 0;
+  for (unsigned int bit = 0; bit < n_bits; bit++)
+    {
+      ASSERT_EQ (ref[bit], bitmap_bit_p (b, bit));
+      count += ref[bit];
+    }
+  ASSERT_EQ (count, bitmap_count_bits (b));
+
+  /* Give copies of B indexes of their own, then replace their contents
+     with the upper and lower halves of B.  Rewriting the elements of C
+     and D must keep their indexes valid.  */
+  bitmap upper = BITMAP_ALLOC (&ob);
+  bitmap_set_range (upper, n_bits / 2, n_bits / 2);
+  bitmap_copy (c, b);
+  bitmap_copy (d, b);
+  for (unsigned int i = 0; i < n_bits; i += 97)
+    {
+      unsigned int bit = (i * 7919) % n_bits;
+      ASSERT_EQ (ref[bit], bitmap_bit_p (c, bit));
+      ASSERT_EQ (ref[bit], bitmap_bit_p (d, bit));
+    }
+  ASSERT_TRUE (c->index != NULL);
+  ASSERT_TRUE (d->index != NULL);
+  bitmap_and (c, b, upper);
+  bitmap_and_compl (d, b, upper);
+  bitmap_clear_range (b, n_bits / 4, n_bits / 2);
+  assert_index_valid (b);
+  assert_index_valid (c);
+  assert_index_valid (d);
+  for (unsigned int i = 0; i < n_bits; i++)
+    {
+      unsigned int bit = (i * 7919) % n_bits;
+      ASSERT_EQ (ref[bit] && bit >= n_bits / 2, bitmap_bit_p (c, bit));
+      ASSERT_EQ (ref[bit] && bit < n_bits / 2, bitmap_bit_p (d, bit));
+      ASSERT_EQ (ref[bit] && (bit < n_bits / 4 || bit >= 3 * n_bits / 4),
+		 bitmap_bit_p (b, bit));
+    }
+
+  bitmap_ior (b, c, d);
+  assert_index_valid (b);
+  for (unsigned int i = 0; i < n_bits; i++)
+    {
+      unsigned int bit = (i * 7919) % n_bits;
+      ASSERT_EQ (ref[bit], bitmap_bit_p (b, bit));
+    }
+
+  free (ref);
+  bitmap_obstack_release (&ob);
+}
+
 /* Run all of the selftests within this file.  */
 
 void
@@ -2271,6 +2580,66 @@ bitmap_c_tests ()
   test_clear_bit_in_middle ();
   test_copying ();
   test_bitmap_single_bit_set_p ();
+  test_indexed_bitmap ();
+}
+
+/* Benchmark: setting, testing and clearing bits scattered over a
+   bitmap of 64k bits, so that most accesses miss the cached
+   element.  */
+
+static void
+bench_set_bit (unsigned int iterations)
+{
+  const unsigned int n_bits = 1 << 16;
+  bitmap_obstack ob;
+  bitmap_obstack_initialize (&ob);
+  bitmap b = BITMAP_ALLOC (&ob);
+
+  size_t count = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      unsigned int bit = (i * 7919) % n_bits;
+      if (bitmap_bit_p (b, bit))
+	bitmap_clear_bit (b, bit);
+      else
+	count += bitmap_set_bit (b, bit);
+    }
+  benchmark_consume (count);
+  bitmap_obstack_release (&ob);
+}
+
+/* Benchmark: the union of two overlapping bitmaps of 64k bits with
+   alternating runs of set and clear bits.  */
+
+static void
+bench_ior (unsigned int iterations)
+{
+  const unsigned int n_bits = 1 << 16;
+  bitmap_obstack ob;
+  bitmap_obstack_initialize (&ob);
+  bitmap a = BITMAP_ALLOC (&ob);
+  bitmap b = BITMAP_ALLOC (&ob);
+  bitmap dst = BITMAP_ALLOC (&ob);
+  for (unsigned int bit = 0; bit < n_bits; bit += 1000)
+    {
+      bitmap_set_range (a, bit, 300);
+      bitmap_set_range (b, bit + 200, 400);
+    }
+
+  size_t changed = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    changed += bitmap_ior (dst, a, (i & 1) ? b : a);
+  benchmark_consume (changed);
+  bitmap_obstack_release (&ob);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+bitmap_c_benchmarks ()
+{
+  run_benchmark ("bitmap/set_bit", bench_set_bit);
+  run_benchmark ("bitmap/ior", bench_ior);
 }
 
 } // namespace selftest
@@ -205,10 +205,20 @@ typedef unsigned long BITMAP_WORD;
 
 #define BITMAP_ELEMENT_ALL_BITS (BITMAP_ELEMENT_WORDS * BITMAP_WORD_BITS)
 
+/* Range of the base 2 logarithm of the number of slots in a
+   bitmap_elt_index.  */
+
+#define BITMAP_INDEX_MIN_LOG2_SLOTS 4
+#define BITMAP_INDEX_MAX_LOG2_SLOTS 12
+#define BITMAP_INDEX_SIZES \
+  (BITMAP_INDEX_MAX_LOG2_SLOTS - BITMAP_INDEX_MIN_LOG2_SLOTS + 1)
+
 /* Obstack for allocating bitmaps and elements from.  */
 struct GTY (()) bitmap_obstack {
   struct bitmap_element *elements;
   struct bitmap_head *heads;
+  /* Freelists of element indexes, by size.  */
+  struct bitmap_elt_index * GTY ((skip)) indexes[BITMAP_INDEX_SIZES];
   struct obstack GTY ((skip)) obstack;
 };
 
@@ -231,8 +241,29 @@ struct GTY((chain_next ("%h.next"), chain_prev ("%h.prev"))) bitmap_element {
   BITMAP_WORD bits[BITMAP_ELEMENT_WORDS]; /* Bits that are set.  */
 };
 
+/* Index over the elements of a large obstack bitmap.  Walks of the
+   element list that start from 'current' are linear in the size of
+   the bitmap, so once bitmap_find_bit sees long walks it gives the
+   bitmap an index, and later walks start from the slot covering the
+   element looked for.  Element index INDX is covered by slot
+   MIN (INDX >> SHIFT, number of slots - 1).  A slot is either NULL or
+   points to an element of the bitmap that it covers.  Unused indexes
+   are chained through NEXT on the freelists of the bitmap obstack.  */
+
+struct bitmap_elt_index {
+  struct bitmap_elt_index *next; /* Next index in the freelist.  */
+  unsigned int log2_slots;	/* Base 2 logarithm of the number of slots.  */
+  unsigned int shift;		/* Element index bits ignored by the slots.  */
+  unsigned int n_elements;	/* Number of elements in the bitmap.  */
+  unsigned int max_indx;	/* Upper bound of their element indices.  */
+  bitmap_element *slots[1];	/* The slots, of which there are really
+				   1 << LOG2_SLOTS.  */
+};
+
 /* Head of bitmap linked list.  The 'current' member points to something
-   already pointed to by the chain started by first, so GTY((skip)) it.  */
+   already pointed to by the chain started by first, so GTY((skip)) it.
+   The same goes for the 'index' member, which only obstack bitmaps
+   have.  */
 
 struct GTY(()) bitmap_head {
   unsigned int indx;			/* Index of last element looked at.  */
@@ -243,6 +274,8 @@ struct GTY(()) bitmap_head {
   bitmap_element * GTY((skip(""))) current; /* Last element looked at.  */
   bitmap_obstack *obstack;		/* Obstack to allocate elements from.
 					   If NULL, then use GGC allocation.  */
+  /* Index over the elements, or NULL.  */
+  struct bitmap_elt_index * GTY((skip(""))) index;
 };
 
 /* Global data */
@@ -339,6 +372,7 @@ bitmap_initialize_stat (bitmap head, bitmap_obstack *obstack MEM_STAT_DECL)
 {
   head->first = head->current = NULL;
   head->obstack = obstack;
+  head->index = NULL;
   if (GATHER_STATISTICS)
     bitmap_register (head PASS_MEM_STAT);
 }
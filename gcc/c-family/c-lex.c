@@ -204,6 +204,8 @@ fe_file_change (const line_map_ordinary *new_map)
 
 	  input_location = new_map->start_location;
 	  (*debug_hooks->start_source_file) (line, LINEMAP_FILE (new_map));
+	  if (timevar_trace_p ())
+	    g_timer->trace_file_change (LINEMAP_FILE (new_map), true);
 #ifndef NO_IMPLICIT_EXTERN_C
 	  if (c_header_level)
 	    ++c_header_level;
@@ -228,6 +230,8 @@ fe_file_change (const line_map_ordinary *new_map)
       input_location = new_map->start_location;
 
       (*debug_hooks->end_source_file) (LINEMAP_LINE (new_map));
+      if (timevar_trace_p ())
+	g_timer->trace_file_change (NULL, false);
     }
 
   update_header_times (LINEMAP_FILE (new_map));
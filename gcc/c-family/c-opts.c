@@ -39,6 +39,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "plugin.h"		/* For PLUGIN_INCLUDE_FILE event.  */
 #include "mkdeps.h"
 #include "dumpfile.h"
+#include "timevar.h"
 
 #ifndef DOLLARS_IN_IDENTIFIERS
 # define DOLLARS_IN_IDENTIFIERS true
@@ -74,6 +75,13 @@ static bool verbose;
 /* Dependency output file.  */
 static const char *deps_file;
 
+/* Stream for the dependency output, once opened.  */
+static FILE *deps_stream;
+
+/* The number of errors seen before the current input file.  Its
+   dependencies are written only if it adds none.  */
+static int errors_before_file;
+
 /* The prefix given by -iprefix, if any.  */
 static const char *iprefix;
 
@@ -115,6 +123,7 @@ static void set_std_cxx1z (int);
 static void set_std_c89 (int, int);
 static void set_std_c99 (int);
 static void set_std_c11 (int);
+static FILE *get_deps_stream (void);
 static void check_deps_environment_vars (void);
 static void handle_deferred_opts (void);
 static void sanitize_cpp_opts (void);
@@ -457,6 +466,14 @@ c_common_handle_option (size_t scode, const char *arg, int value,
       cpp_opts->operator_names = value;
       break;
 
+    case OPT_fpch_cache_:
+      /* Handled by the driver.  */
+      break;
+
+    case OPT_fpch_cache_skip_includes_:
+      cpp_opts->skip_primary_includes = value;
+      break;
+
     case OPT_fpch_deps:
       cpp_opts->restore_pch_deps = value;
       break;
@@ -510,6 +527,10 @@ c_common_handle_option (size_t scode, const char *arg, int value,
       cpp_opts->wide_charset = arg;
       break;
 
+    case OPT_finclude_cache_:
+      cpp_opts->include_cache = arg;
+      break;
+
     case OPT_finput_charset_:
       cpp_opts->input_charset = arg;
       break;
@@ -956,7 +977,10 @@ c_common_post_options (const char **pfilename)
 	  return false;
 	}
 
-      if (num_in_fnames > 1)
+      /* Several files can only be given when just their dependencies
+	 are wanted.  */
+      if (num_in_fnames > 1
+	  && (!flag_no_output || cpp_opts->deps.style == DEPS_NONE))
 	error ("too many filenames given.  Type %s --help for usage",
 	       progname);
 
@@ -1048,8 +1072,30 @@ c_common_init (void)
 
   if (flag_preprocess_only)
     {
-      c_finish_options ();
-      preprocess_file (parse_in);
+      unsigned int i;
+
+      for (i = 0; i < num_in_fnames; i++)
+	{
+	  if (i > 0)
+	    {
+	      /* Write out the dependencies of the previous file and go on
+		 to this one, keeping what cpplib knows of the file
+		 system.  */
+	      cpp_finish (parse_in, get_deps_stream ());
+	      cpp_undef_all (parse_in);
+	      cpp_forget_included_files (parse_in);
+	      handle_deferred_opts ();
+	      done_preinclude = false;
+	      errors_before_file = errorcount + sorrycount;
+	      this_input_filename = cpp_read_main_file (parse_in,
+							in_fnames[i]);
+	      /* If the file is missing, cpplib has issued a diagnostic.  */
+	      if (!this_input_filename)
+		continue;
+	    }
+	  c_finish_options ();
+	  preprocess_file (parse_in);
+	}
       return false;
     }
 
@@ -1124,10 +1170,40 @@ get_dump_info (int phase, int *flags)
 void
 c_common_finish (void)
 {
-  FILE *deps_stream = NULL;
+  /* For performance, avoid tearing down cpplib's internal structures
+     with cpp_destroy ().  */
+  cpp_finish (parse_in, get_deps_stream ());
+
+  if (g_timer && cpp_opts->include_cache)
+    {
+      unsigned long hits, checks;
+
+      cpp_get_include_cache_stats (parse_in, &hits, &checks);
+      g_timer->add_count ("include lookups skipped by -finclude-cache",
+			  hits);
+      g_timer->add_count ("directories checked by -finclude-cache",
+			  checks);
+    }
+
+  if (deps_stream && deps_stream != out_stream
+      && (ferror (deps_stream) || fclose (deps_stream)))
+    fatal_error (input_location, "closing dependency file %s: %m", deps_file);
+
+  if (out_stream && (ferror (out_stream) || fclose (out_stream)))
+    fatal_error (input_location, "when writing output to %s: %m", out_fname);
+}
+
+/* Return the stream to write dependencies to, opening it the first
+   time, or NULL if they should not be written.  */
+static FILE *
+get_deps_stream (void)
+{
+  /* Don't write the deps of a file with errors.  */
+  if (cpp_opts->deps.style == DEPS_NONE
+      || errorcount + sorrycount > errors_before_file)
+    return NULL;
 
-  /* Don't write the deps file if there are errors.  */
-  if (cpp_opts->deps.style != DEPS_NONE && !seen_error ())
+  if (!deps_stream)
     {
       /* If -M or -MM was seen without -MF, default output to the
 	 output stream.  */
@@ -1141,17 +1217,7 @@ c_common_finish (void)
 			 deps_file);
 	}
     }
-
-  /* For performance, avoid tearing down cpplib's internal structures
-     with cpp_destroy ().  */
-  cpp_finish (parse_in, deps_stream);
-
-  if (deps_stream && deps_stream != out_stream
-      && (ferror (deps_stream) || fclose (deps_stream)))
-    fatal_error (input_location, "closing dependency file %s: %m", deps_file);
-
-  if (out_stream && (ferror (out_stream) || fclose (out_stream)))
-    fatal_error (input_location, "when writing output to %s: %m", out_fname);
+  return deps_stream;
 }
 
 /* Either of two environment variables can specify output of
@@ -1244,11 +1310,12 @@ sanitize_cpp_opts (void)
     flag_dump_macros = 'D';
 
   /* Disable -dD, -dN and -dI if normal output is suppressed.  Allow
-     -dM since at least glibc relies on -M -dM to work.  */
+     -dM since at least glibc relies on -M -dM to work, and -dU, which
+     then lists the macros the directives depended on.  */
   /* Also, flag_no_output implies flag_no_line_commands, always.  */
   if (flag_no_output)
     {
-      if (flag_dump_macros != 'M')
+      if (flag_dump_macros != 'M' && flag_dump_macros != 'U')
 	flag_dump_macros = 0;
       flag_dump_includes = 0;
       flag_no_line_commands = 1;
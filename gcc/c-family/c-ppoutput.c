@@ -87,10 +87,18 @@ preprocess_file (cpp_reader *pfile)
      cpp_scan_nooutput or cpp_get_token next.  */
   if (flag_no_output && pfile->buffer)
     {
-      /* Scan -included buffers, then the main file.  */
-      while (pfile->buffer->prev)
-	cpp_scan_nooutput (pfile);
-      cpp_scan_nooutput (pfile);
+      /* With -fdirectives-only, only the directives need looking at to
+	 find the dependencies and the macros they use.  */
+      if (cpp_get_options (pfile)->directives_only
+	  && !cpp_get_options (pfile)->preprocessed)
+	cpp_scan_directives_only (pfile);
+      else
+	{
+	  /* Scan -included buffers, then the main file.  */
+	  while (pfile->buffer->prev)
+	    cpp_scan_nooutput (pfile);
+	  cpp_scan_nooutput (pfile);
+	}
     }
   else if (cpp_get_options (pfile)->traditional)
     scan_translation_unit_trad (pfile);
@@ -104,6 +112,11 @@ preprocess_file (cpp_reader *pfile)
   if (flag_dump_macros == 'M')
     cpp_forall_identifiers (pfile, dump_macro, NULL);
 
+  /* Without output, there is no next line at which to dump the macros
+     -dU queued last.  */
+  if (define_queue || undef_queue)
+    dump_queued_macros (pfile);
+
   /* Flush any pending output.  */
   if (print.printed)
     putc ('\n', print.outf);
@@ -1400,37 +1400,19 @@ compute_idf (bitmap def_blocks, bitmap_head *dfs)
 void
 bitmap_intersection_of_succs (sbitmap dst, sbitmap *src, basic_block b)
 {
-  unsigned int set_size = dst->size;
+  auto_vec<const_sbitmap, 16> srcs;
   edge e;
-  unsigned ix;
-
-  for (e = NULL, ix = 0; ix < EDGE_COUNT (b->succs); ix++)
-    {
-      e = EDGE_SUCC (b, ix);
-      if (e->dest == EXIT_BLOCK_PTR_FOR_FN (cfun))
-	continue;
+  edge_iterator ei;
 
-      bitmap_copy (dst, src[e->dest->index]);
-      break;
-    }
+  FOR_EACH_EDGE (e, ei, b->succs)
+    if (e->dest != EXIT_BLOCK_PTR_FOR_FN (cfun))
+      srcs.safe_push (src[e->dest->index]);
 
-  if (e == 0)
+  if (!srcs.is_empty ())
+    bitmap_and_n (dst, srcs.address (), srcs.length ());
+  else if (EDGE_COUNT (b->succs) == 0)
     bitmap_ones (dst);
-  else
-    for (++ix; ix < EDGE_COUNT (b->succs); ix++)
-      {
-	unsigned int i;
-	SBITMAP_ELT_TYPE *p, *r;
-
-	e = EDGE_SUCC (b, ix);
-	if (e->dest == EXIT_BLOCK_PTR_FOR_FN (cfun))
-	  continue;
-
-	p = src[e->dest->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ &= *p++;
-      }
+  /* Otherwise every edge was to the exit block and DST is left alone.  */
 }
 
 /* Set the bitmap DST to the intersection of SRC of predecessors of
@@ -1439,37 +1421,19 @@ bitmap_intersection_of_succs (sbitmap dst, sbitmap *src, basic_block b)
 void
 bitmap_intersection_of_preds (sbitmap dst, sbitmap *src, basic_block b)
 {
-  unsigned int set_size = dst->size;
+  auto_vec<const_sbitmap, 16> srcs;
   edge e;
-  unsigned ix;
-
-  for (e = NULL, ix = 0; ix < EDGE_COUNT (b->preds); ix++)
-    {
-      e = EDGE_PRED (b, ix);
-      if (e->src == ENTRY_BLOCK_PTR_FOR_FN (cfun))
-	continue;
+  edge_iterator ei;
 
-      bitmap_copy (dst, src[e->src->index]);
-      break;
-    }
+  FOR_EACH_EDGE (e, ei, b->preds)
+    if (e->src != ENTRY_BLOCK_PTR_FOR_FN (cfun))
+      srcs.safe_push (src[e->src->index]);
 
-  if (e == 0)
+  if (!srcs.is_empty ())
+    bitmap_and_n (dst, srcs.address (), srcs.length ());
+  else if (EDGE_COUNT (b->preds) == 0)
     bitmap_ones (dst);
-  else
-    for (++ix; ix < EDGE_COUNT (b->preds); ix++)
-      {
-	unsigned int i;
-	SBITMAP_ELT_TYPE *p, *r;
-
-	e = EDGE_PRED (b, ix);
-	if (e->src == ENTRY_BLOCK_PTR_FOR_FN (cfun))
-	  continue;
-
-	p = src[e->src->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ &= *p++;
-      }
+  /* Otherwise every edge was to the entry block and DST is left alone.  */
 }
 
 /* Set the bitmap DST to the union of SRC of successors of
@@ -1478,37 +1442,18 @@ bitmap_intersection_of_preds (sbitmap dst, sbitmap *src, basic_block b)
 void
 bitmap_union_of_succs (sbitmap dst, sbitmap *src, basic_block b)
 {
-  unsigned int set_size = dst->size;
+  auto_vec<const_sbitmap, 16> srcs;
   edge e;
-  unsigned ix;
-
-  for (ix = 0; ix < EDGE_COUNT (b->succs); ix++)
-    {
-      e = EDGE_SUCC (b, ix);
-      if (e->dest == EXIT_BLOCK_PTR_FOR_FN (cfun))
-	continue;
+  edge_iterator ei;
 
-      bitmap_copy (dst, src[e->dest->index]);
-      break;
-    }
+  FOR_EACH_EDGE (e, ei, b->succs)
+    if (e->dest != EXIT_BLOCK_PTR_FOR_FN (cfun))
+      srcs.safe_push (src[e->dest->index]);
 
-  if (ix == EDGE_COUNT (b->succs))
-    bitmap_clear (dst);
+  if (!srcs.is_empty ())
+    bitmap_ior_n (dst, srcs.address (), srcs.length ());
   else
-    for (ix++; ix < EDGE_COUNT (b->succs); ix++)
-      {
-	unsigned int i;
-	SBITMAP_ELT_TYPE *p, *r;
-
-	e = EDGE_SUCC (b, ix);
-	if (e->dest == EXIT_BLOCK_PTR_FOR_FN (cfun))
-	  continue;
-
-	p = src[e->dest->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ |= *p++;
-      }
+    bitmap_clear (dst);
 }
 
 /* Set the bitmap DST to the union of SRC of predecessors of
@@ -1517,37 +1462,18 @@ bitmap_union_of_succs (sbitmap dst, sbitmap *src, basic_block b)
 void
 bitmap_union_of_preds (sbitmap dst, sbitmap *src, basic_block b)
 {
-  unsigned int set_size = dst->size;
+  auto_vec<const_sbitmap, 16> srcs;
   edge e;
-  unsigned ix;
-
-  for (ix = 0; ix < EDGE_COUNT (b->preds); ix++)
-    {
-      e = EDGE_PRED (b, ix);
-      if (e->src== ENTRY_BLOCK_PTR_FOR_FN (cfun))
-	continue;
+  edge_iterator ei;
 
-      bitmap_copy (dst, src[e->src->index]);
-      break;
-    }
+  FOR_EACH_EDGE (e, ei, b->preds)
+    if (e->src != ENTRY_BLOCK_PTR_FOR_FN (cfun))
+      srcs.safe_push (src[e->src->index]);
 
-  if (ix == EDGE_COUNT (b->preds))
-    bitmap_clear (dst);
+  if (!srcs.is_empty ())
+    bitmap_ior_n (dst, srcs.address (), srcs.length ());
   else
-    for (ix++; ix < EDGE_COUNT (b->preds); ix++)
-      {
-	unsigned int i;
-	SBITMAP_ELT_TYPE *p, *r;
-
-	e = EDGE_PRED (b, ix);
-	if (e->src == ENTRY_BLOCK_PTR_FOR_FN (cfun))
-	  continue;
-
-	p = src[e->src->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ |= *p++;
-      }
+    bitmap_clear (dst);
 }
 
 /* Returns the list of basic blocks in the function in an order that guarantees
@@ -2532,11 +2532,16 @@ symbol_table::unregister (symtab_node *node)
   node->previous = NULL;
 }
 
-/* Release a callgraph NODE with UID and put in to the list of free nodes.  */
+/* Release a callgraph NODE with UID and put in to the list of free nodes.
+   The node keeps its summary uid too, so that summary uids stay dense for
+   summaries stored in vectors; the removal hooks have already dropped the
+   summaries of the node.  */
 
 inline void
 symbol_table::release_symbol (cgraph_node *node, int uid)
 {
+  int summary_uid = node->summary_uid;
+
   cgraph_count--;
 
   /* Clear out the node to NULL all pointers and add the node to the free
@@ -2544,6 +2549,7 @@ symbol_table::release_symbol (cgraph_node *node, int uid)
   memset (node, 0, sizeof (*node));
   node->type = SYMTAB_FUNCTION;
   node->uid = uid;
+  node->summary_uid = summary_uid;
   SET_NEXT_FREE_NODE (node, free_nodes);
   free_nodes = node;
 }
@@ -2564,9 +2570,9 @@ symbol_table::allocate_cgraph_symbol (void)
     {
       node = ggc_cleared_alloc<cgraph_node> ();
       node->uid = cgraph_max_uid++;
+      node->summary_uid = cgraph_max_summary_uid++;
     }
 
-  node->summary_uid = cgraph_max_summary_uid++;
   return node;
 }
 
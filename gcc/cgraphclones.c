@@ -498,7 +498,15 @@ cgraph_node::create_clone (tree new_decl, gcov_type gcov_count, int freq,
   return new_node;
 }
 
-static GTY(()) unsigned int clone_fn_id_num;
+/* The number of clones made so far of each function, keyed by its
+   name.  Numbering the clones of each function separately keeps the
+   names of the clones of one function from changing when clones of an
+   unrelated function are added or removed, which keeps the LTRANS units
+   stable across small changes to the program.  The names are copied,
+   since identifiers that are no longer referenced may be collected and
+   made again later with the same name.  */
+
+static hash_map<nofree_string_hash, unsigned int> *clone_fn_ids;
 
 /* Return a new assembler name for a clone with SUFFIX of a decl named
    NAME.  */
@@ -509,11 +517,17 @@ clone_function_name_1 (const char *name, const char *suffix)
   size_t len = strlen (name);
   char *tmp_name, *prefix;
 
+  if (!clone_fn_ids)
+    clone_fn_ids = new hash_map<nofree_string_hash, unsigned int>;
+  unsigned int *clone_fn_id_num = clone_fn_ids->get (name);
+  if (!clone_fn_id_num)
+    clone_fn_id_num = &clone_fn_ids->get_or_insert (xstrdup (name));
+
   prefix = XALLOCAVEC (char, len + strlen (suffix) + 2);
   memcpy (prefix, name, len);
   strcpy (prefix + len + 1, suffix);
   prefix[len] = symbol_table::symbol_suffix_separator ();
-  ASM_FORMAT_PRIVATE_NAME (tmp_name, prefix, clone_fn_id_num++);
+  ASM_FORMAT_PRIVATE_NAME (tmp_name, prefix, (*clone_fn_id_num)++);
   return get_identifier (tmp_name);
 }
 
@@ -1127,5 +1141,3 @@ symbol_table::materialize_all_clones (void)
 
   symtab->remove_unreachable_nodes (symtab->dump_file);
 }
-
-#include "gt-cgraphclones.h"
@@ -10413,7 +10413,11 @@ instantiate_class_template (tree type)
 {
   tree ret;
   timevar_push (TV_TEMPLATE_INST);
+  if (timevar_trace_p ())
+    g_timer->trace_push ("template", type_as_string (type, 0));
   ret = instantiate_class_template_1 (type);
+  if (timevar_trace_p ())
+    g_timer->trace_pop ();
   timevar_pop (TV_TEMPLATE_INST);
   return ret;
 }
@@ -21859,6 +21863,8 @@ instantiate_decl (tree d, int defer_ok,
     return d;
 
   timevar_push (TV_TEMPLATE_INST);
+  if (timevar_trace_p ())
+    g_timer->trace_push ("template", decl_as_string (d, 0));
 
   /* Set TD to the template whose DECL_TEMPLATE_RESULT is the pattern
      for the instantiation.  */
@@ -22212,6 +22218,8 @@ out:
   if (nested)
     restore_omp_privatization_clauses (omp_privatization_save);
 
+  if (timevar_trace_p ())
+    g_timer->trace_pop ();
   timevar_pop (TV_TEMPLATE_INST);
 
   return d;
@@ -253,7 +253,14 @@ enum lto_partition_model {
   LTO_PARTITION_ONE = 1,
   LTO_PARTITION_BALANCED = 2,
   LTO_PARTITION_1TO1 = 3,
-  LTO_PARTITION_MAX = 4
+  LTO_PARTITION_MAX = 4,
+  LTO_PARTITION_STABLE = 5
+};
+
+/* The algorithms for compressing LTO IL.  */
+enum lto_compression_algorithm {
+  LTO_COMPRESSION_ZLIB,
+  LTO_COMPRESSION_LZ
 };
 
 /* flag_lto_linker_output initialization values.  */
@@ -265,6 +272,19 @@ enum lto_linker_output {
   LTO_LINKER_OUTPUT_EXEC
 };
 
+/* flag_time_report_format initialization values.  */
+enum time_report_format {
+  TIME_REPORT_FORMAT_TEXT,
+  TIME_REPORT_FORMAT_JSON
+};
+
+/* flag_self_test values.  -fself-test on its own is SELF_TEST_TESTS.  */
+enum self_test_mode {
+  SELF_TEST_NONE,
+  SELF_TEST_TESTS,
+  SELF_TEST_BENCH
+};
+
 /* gfortran -finit-real= values.  */
 
 enum gfc_init_local_real
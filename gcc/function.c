@@ -205,9 +205,22 @@ free_after_compilation (struct function *f)
   memset (crtl, 0, sizeof (struct rtl_data));
   f->eh = NULL;
   f->machine = NULL;
+
+  /* The basic block and label maps, and the pseudo register table
+     below, are only reachable through the pointers we are clearing.
+     They are large for big functions, so hand them back to the
+     collector now instead of leaving them for the next collection
+     to find dead.  */
+  if (f->cfg)
+    {
+      vec_free (f->cfg->x_basic_block_info);
+      vec_free (f->cfg->x_label_to_block_map);
+    }
   f->cfg = NULL;
   f->curr_properties &= ~PROP_cfg;
 
+  if (regno_reg_rtx)
+    ggc_free (regno_reg_rtx);
   regno_reg_rtx = NULL;
 }
 
@@ -43,6 +43,8 @@ compilation is specified by a string called a "spec".  */
 #include "params.h"
 #include "filenames.h"
 #include "spellcheck.h"
+#include "md5.h"
+#include "environ.h"
 
 
 
@@ -402,6 +404,7 @@ static const char *compare_debug_auxbase_opt_spec_function (int, const char **);
 static const char *pass_through_libs_spec_func (int, const char **);
 static const char *replace_extension_spec_func (int, const char **);
 static const char *greater_than_spec_func (int, const char **);
+static const char *pch_cache_spec_function (int, const char **);
 static char *convert_white_space (char *);
 
 /* The Specs Language
@@ -1310,7 +1313,8 @@ static const struct compiler default_compilers[] =
 	    cc1 -fpreprocessed %{save-temps*:%b.i} %{!save-temps*:%g.i} \
 	  %(cc1_options)}\
       %{!save-temps*:%{!traditional-cpp:%{!no-integrated-cpp:\
-	  cc1 %(cpp_unique_options) %(cc1_options)}}}\
+	  cc1 %(cpp_unique_options) %(cc1_options)\
+	      %{fpch-cache=*:%:pch-cache(c-header %{fpch-cache=*:%*})}}}}\
       %{!fsyntax-only:%(invoke_as)}}}}", 0, 0, 1},
   {"-",
    "%{!E:%e-E or -x required when input is from standard input}\
@@ -1636,6 +1640,7 @@ static const struct spec_function static_spec_functions[] =
   { "pass-through-libs",	pass_through_libs_spec_func },
   { "replace-extension",	replace_extension_spec_func },
   { "gt",			greater_than_spec_func },
+  { "pch-cache",		pch_cache_spec_function },
 #ifdef EXTRA_SPEC_FUNCTIONS
   EXTRA_SPEC_FUNCTIONS
 #endif
@@ -7960,6 +7965,37 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
   return 1;
 }
 
+/* Return true if only the dependencies of the input files are wanted,
+   because -M or -MM was given without -MD or -MMD.  */
+
+static bool
+dependencies_only_p (void)
+{
+  bool deps = false;
+  int i;
+
+  for (i = 0; i < n_switches; i++)
+    if (!strcmp (switches[i].part1, "M") || !strcmp (switches[i].part1, "MM"))
+      deps = true;
+    else if (!strcmp (switches[i].part1, "MD")
+	     || !strcmp (switches[i].part1, "MMD"))
+      return false;
+
+  return deps;
+}
+
+/* Return true if COMPILER preprocesses with cc1 or cc1plus, which can
+   scan the dependencies of several files in one go.  */
+
+static bool
+scans_dependencies_p (const struct compiler *compiler)
+{
+  return (!strcmp (compiler->suffix, "@c")
+	  || !strcmp (compiler->suffix, "@c++")
+	  || !strcmp (compiler->suffix, "@objective-c")
+	  || !strcmp (compiler->suffix, "@objective-c++"));
+}
+
 /* Figure out what to do with each input file.
    Return true if we need to exit early from "main", false otherwise.  */
 
@@ -7968,6 +8004,7 @@ driver::prepare_infiles ()
 {
   size_t i;
   int lang_n_infiles = 0;
+  bool deps_only = dependencies_only_p ();
 
   if (n_infiles == added_libraries)
     fatal_error (input_location, "no input files");
@@ -7987,7 +8024,9 @@ driver::prepare_infiles ()
 
   explicit_link_files = XCNEWVEC (char, n_infiles);
 
-  combine_inputs = have_o || flag_wpa;
+  /* When only dependencies are wanted, the files in a language are all
+     given to one compiler, which shares its file lookups among them.  */
+  combine_inputs = have_o || flag_wpa || deps_only;
 
   for (i = 0; (int) i < n_infiles; i++)
     {
@@ -7996,7 +8035,8 @@ driver::prepare_infiles ()
 						   strlen (name),
 						   infiles[i].language);
 
-      if (compiler && !(compiler->combinable))
+      if (compiler && !(compiler->combinable)
+	  && !(deps_only && scans_dependencies_p (compiler)))
 	combine_inputs = false;
 
       if (lang_n_infiles > 0 && compiler != input_file_compiler
@@ -8019,7 +8059,8 @@ driver::prepare_infiles ()
       infiles[i].preprocessed = false;
     }
 
-  if (!combine_inputs && have_c && have_o && lang_n_infiles > 1)
+  if ((!combine_inputs || deps_only)
+      && have_c && have_o && lang_n_infiles > 1)
     fatal_error (input_location,
 		 "cannot specify -o with -c, -S or -E with multiple files");
 
@@ -9832,6 +9873,548 @@ greater_than_spec_func (int argc, const char **argv)
   return NULL;
 }
 
+/* The environment variables that add to the include path, and so
+   affect what the directives in a header of %:pch-cache mean.  */
+
+static const char *const pch_cache_env_vars[] = {
+  "CPATH", "C_INCLUDE_PATH", "CPLUS_INCLUDE_PATH", "OBJC_INCLUDE_PATH",
+  NULL
+};
+
+/* Seconds after which %:pch-cache takes over the lock of a header that
+   another compilation is precompiling.  */
+
+#define PCH_CACHE_LOCK_TIMEOUT 600
+
+/* Skip the blanks and comments at P, which is inside a block comment if
+   *IN_COMMENT, and update *IN_COMMENT.  Return what follows them, which
+   is the end of the line if a comment runs on to the next one.  */
+
+static char *
+pch_cache_skip_comments (char *p, bool *in_comment)
+{
+  for (;;)
+    {
+      if (*in_comment)
+	{
+	  char *q = strstr (p, "*/");
+	  if (!q)
+	    return p + strlen (p);
+	  p = q + 2;
+	  *in_comment = false;
+	}
+      while (*p == ' ' || *p == '\t')
+	p++;
+      if (p[0] == '/' && p[1] == '/')
+	return p + strlen (p);
+      if (p[0] != '/' || p[1] != '*')
+	return p;
+      *in_comment = true;
+      p += 2;
+    }
+}
+
+/* Append to LINES the leading #include directives of source file NAME,
+   each as the header name with its delimiters, such as <vector> or
+   "foo.h".  Blank lines and comments, such as a license at the top of
+   the file, are skipped; anything else, including a directive split
+   across lines, ends the list.  */
+
+static void
+pch_cache_read_prefix (const char *name, vec<char *> *lines)
+{
+  FILE *f = fopen (name, "r");
+  char buf[4096];
+  bool in_comment = false;
+
+  if (!f)
+    return;
+
+  while (fgets (buf, sizeof (buf), f))
+    {
+      size_t len = strlen (buf);
+      char *p, *q, *directive = NULL;
+      char close;
+      bool continued;
+
+      if (len == sizeof (buf) - 1 && buf[len - 1] != '\n')
+	break;
+      while (len && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+	buf[--len] = '\0';
+      continued = len && buf[len - 1] == '\\';
+
+      p = pch_cache_skip_comments (buf, &in_comment);
+      if (*p == '#')
+	{
+	  p++;
+	  while (*p == ' ' || *p == '\t')
+	    p++;
+	  if (strncmp (p, "include", 7) != 0)
+	    break;
+	  p += 7;
+	  while (*p == ' ' || *p == '\t')
+	    p++;
+	  if (*p != '<' && *p != '"')
+	    break;
+	  close = *p == '<' ? '>' : '"';
+	  q = strchr (p + 1, close);
+	  if (!q || q == p + 1)
+	    break;
+	  directive = xstrndup (p, q + 1 - p);
+	  p = pch_cache_skip_comments (q + 1, &in_comment);
+	}
+
+      /* A backslash at the end of a line only continues it outside
+	 block comments.  */
+      if (*p || (continued && !in_comment))
+	{
+	  free (directive);
+	  break;
+	}
+      if (directive)
+	lines->safe_push (directive);
+    }
+
+  fclose (f);
+}
+
+/* Return true if the file STAMP exists and is newer than every file
+   listed in the make-style dependency file DEPS.  */
+
+static bool
+pch_cache_fresh_p (const char *stamp, const char *deps)
+{
+  struct stat st;
+  time_t stamp_time;
+  FILE *f;
+  bool in_target = true, fresh = true;
+  struct obstack ob;
+  int c;
+
+  if (stat (stamp, &st) != 0)
+    return false;
+  stamp_time = st.st_mtime;
+
+  f = fopen (deps, "r");
+  if (!f)
+    return false;
+
+  obstack_init (&ob);
+  do
+    {
+      c = getc (f);
+      if (c == '\\')
+	{
+	  int next = getc (f);
+
+	  if (next == '\n' || next == EOF)
+	    c = ' ';
+	  else if (next == ' ' || next == '\t' || next == '#' || next == '\\')
+	    {
+	      obstack_1grow (&ob, next);
+	      continue;
+	    }
+	  else
+	    {
+	      obstack_1grow (&ob, '\\');
+	      ungetc (next, f);
+	      continue;
+	    }
+	}
+      else if (c == '$')
+	{
+	  /* make escapes a dollar sign by doubling it.  */
+	  int next = getc (f);
+
+	  if (next != '$')
+	    ungetc (next, f);
+	  obstack_1grow (&ob, '$');
+	  continue;
+	}
+
+      if (c == ' ' || c == '\t' || c == '\n' || c == EOF)
+	{
+	  size_t len = obstack_object_size (&ob);
+	  char *dep;
+
+	  obstack_1grow (&ob, '\0');
+	  dep = XOBFINISH (&ob, char *);
+	  if (in_target)
+	    in_target = !(len && dep[len - 1] == ':');
+	  else if (len
+		   && (stat (dep, &st) != 0 || st.st_mtime >= stamp_time))
+	    {
+	      fresh = false;
+	      break;
+	    }
+	  obstack_free (&ob, dep);
+	}
+      else
+	obstack_1grow (&ob, c);
+    }
+  while (c != EOF);
+  obstack_free (&ob, NULL);
+
+  fclose (f);
+  return fresh && !in_target;
+}
+
+/* Return true if switch SW of this compilation should be passed on when
+   precompiling a header for %:pch-cache, and be part of its key.  */
+
+static bool
+pch_cache_option_p (const struct switchstr *sw)
+{
+  const char *p = sw->part1;
+
+  if ((sw->live_cond & (SWITCH_IGNORE | SWITCH_KEEP_FOR_GCC)) == SWITCH_IGNORE)
+    return false;
+
+  /* Options that choose what to do with the input and where the output
+     goes, and options that report on the compilation to standard error,
+     which must stay quiet when precompiling.  */
+  if (p[0] == 'M'
+      || !strcmp (p, "o") || !strcmp (p, "c") || !strcmp (p, "S")
+      || !strcmp (p, "E") || !strcmp (p, "x") || !strcmp (p, "v")
+      || !strcmp (p, "H") || !strcmp (p, "Q")
+      || !strcmp (p, "pipe")
+      || !strncmp (p, "fpch-cache", 10)
+      || !strncmp (p, "fdump-", 6)
+      || !strncmp (p, "fcompare-debug", 14)
+      || !strncmp (p, "ftime-report", 12)
+      || !strncmp (p, "fmem-report", 11)
+      || !strncmp (p, "fself-profile", 13)
+      || !strncmp (p, "save-temps", 10))
+    return false;
+
+  return true;
+}
+
+/* Run the driver to precompile the directives SOURCE as a header of
+   language LANG into GCH, with the options of this compilation, and
+   write the files it depends on to DEPS.  Return true on success.
+
+   SOURCE is read from standard input, so that a quoted header is looked
+   for relative to the current directory, like a header of the input
+   file is relative to the input file's directory, and both compilations
+   name the files they depend on in the same way.
+
+   A header that draws any diagnostic counts as a failure: the
+   compilation that goes without it then reports the diagnostic against
+   the input file, and later compilations do too, rather than the
+   diagnostic being seen once, if at all.  -Werror keeps its effect for
+   the same reason.  */
+
+static bool
+pch_cache_build (const char *lang, const char *source, const char *gch,
+		 const char *deps)
+{
+  const char *driver = env.get ("COLLECT_GCC");
+  char *tmp_gch = concat (gch, ".tmp", NULL);
+  char *tmp_deps = concat (deps, ".tmp", NULL);
+  char *tmp_in = concat (gch, ".in", NULL);
+  char *tmp_err = concat (gch, ".err", NULL);
+  auto_vec<const char *> args;
+  auto_vec<char *> envp;
+  struct pex_obj *pex;
+  const char *errmsg;
+  int err, status;
+  bool ok = false;
+  int i;
+
+  if (!driver)
+    return false;
+
+  args.safe_push (driver);
+  for (i = 0; i < n_switches; i++)
+    if (pch_cache_option_p (&switches[i]))
+      {
+	args.safe_push (concat ("-", switches[i].part1, NULL));
+	for (const char **arg = switches[i].args; arg && *arg; arg++)
+	  args.safe_push (*arg);
+      }
+  args.safe_push ("-x");
+  args.safe_push (lang);
+  args.safe_push ("-");
+  args.safe_push ("-o");
+  args.safe_push (tmp_gch);
+  args.safe_push (NULL);
+
+  /* Have the compiler list every file the header depends on, system
+     headers included, but not the header itself, which is ours.  */
+  for (char **e = environ; *e; e++)
+    if (strncmp (*e, "DEPENDENCIES_OUTPUT=", 20) != 0
+	&& strncmp (*e, "SUNPRO_DEPENDENCIES=", 20) != 0)
+      envp.safe_push (*e);
+  envp.safe_push (concat ("SUNPRO_DEPENDENCIES=", tmp_deps, NULL));
+  envp.safe_push (NULL);
+
+  if (verbose_flag)
+    {
+      fnotice (stderr, "Precompiling %s\n", gch);
+      for (i = 0; args[i]; i++)
+	fprintf (stderr, " %s", args[i]);
+      fprintf (stderr, "\n");
+    }
+
+  pex = pex_init (0, "pch-cache", NULL);
+  if (!pex)
+    fatal_error (input_location, "pex_init failed: %m");
+  FILE *in = pex_input_file (pex, 0, tmp_in);
+  if (in && fputs (source, in) != EOF)
+    errmsg = pex_run_in_environment (pex, PEX_LAST | PEX_SEARCH, driver,
+				     CONST_CAST (char **, args.address ()),
+				     envp.address (), NULL, tmp_err, &err);
+  else
+    errmsg = "writing the directives to precompile";
+  if (errmsg == NULL
+      && pex_get_status (pex, 1, &status)
+      && WIFEXITED (status)
+      && WEXITSTATUS (status) == SUCCESS_EXIT_CODE)
+    ok = true;
+  pex_free (pex);
+  remove (tmp_in);
+
+  /* Show the diagnostics with -v, since they explain why the header is
+     not used.  Otherwise the compilation that goes without it gives
+     them.  */
+  FILE *diag = fopen (tmp_err, "r");
+  if (diag)
+    {
+      char buf[256];
+      size_t n;
+
+      while ((n = fread (buf, 1, sizeof (buf), diag)) > 0)
+	{
+	  ok = false;
+	  if (verbose_flag)
+	    fwrite (buf, 1, n, stderr);
+	  else
+	    break;
+	}
+      fclose (diag);
+    }
+  remove (tmp_err);
+
+  if (ok)
+    ok = (rename (tmp_deps, deps) == 0
+	  && rename (tmp_gch, gch) == 0);
+
+  if (!ok)
+    {
+      /* Keep what is known of the dependencies of a failed build, so
+	 that it is retried when one of them changes.  */
+      rename (tmp_deps, deps);
+      remove (tmp_gch);
+    }
+
+  free (tmp_gch);
+  free (tmp_deps);
+  free (tmp_in);
+  free (tmp_err);
+  return ok;
+}
+
+/* %:pch-cache spec function.  Takes the language to precompile headers
+   as and a cache directory.  Precompiles the leading #include directives
+   of the current input file into a header in the cache directory,
+   unless that has been done already and none of the files it depends on
+   has changed since, and expands to the options that make the compiler
+   use it instead of those directives.  */
+
+static const char *
+pch_cache_spec_function (int argc, const char **argv)
+{
+  const char *lang, *dir, *env_value;
+  auto_vec<char *> lines;
+  struct obstack ob;
+  struct md5_ctx ctx;
+  unsigned char sum[16];
+  char key[2 * sizeof (sum) + 1];
+  char *text, *source, *header = NULL, *gch = NULL, *deps = NULL;
+  char *lock = NULL, *failed = NULL;
+  struct obstack source_ob;
+  const char *result = NULL;
+  struct stat st;
+  int fd, i;
+  unsigned ix;
+
+  if (argc != 2)
+    fatal_error (input_location, "wrong number of arguments to %%:pch-cache");
+  lang = argv[0];
+  dir = argv[1];
+
+  /* A precompiled header must come first, before other -include files.  */
+  for (i = 0; i < n_switches; i++)
+    if (!strcmp (switches[i].part1, "include")
+	|| !strcmp (switches[i].part1, "imacros"))
+      return NULL;
+
+  pch_cache_read_prefix (gcc_input_filename, &lines);
+  if (lines.is_empty ())
+    return NULL;
+
+  /* Write out the directives.  A quoted header found in the directory of
+     the input file is named by its absolute path in the header, since
+     that lives elsewhere.  In the source precompiled from standard input
+     it is named relative to the current directory instead, the way the
+     compiler would name it for the input file.  */
+  obstack_init (&ob);
+  obstack_init (&source_ob);
+  FOR_EACH_VEC_ELT (lines, ix, text)
+    {
+      char *path = NULL, *input_path = NULL;
+
+      if (text[0] == '"')
+	{
+	  const char *base = lbasename (gcc_input_filename);
+	  char *name = xstrndup (text + 1, strlen (text) - 2);
+	  char *input_dir = xstrndup (gcc_input_filename,
+				      base - gcc_input_filename);
+
+	  input_path = concat (input_dir, name, NULL);
+	  path = concat (IS_ABSOLUTE_PATH (gcc_input_filename) ? "" : getpwd (),
+			 IS_ABSOLUTE_PATH (gcc_input_filename)
+			 ? "" : dir_separator_str,
+			 input_path, NULL);
+	  if (access (path, R_OK) != 0)
+	    {
+	      free (path);
+	      free (input_path);
+	      path = input_path = NULL;
+	      /* Standard input would find a header in the current
+		 directory that the input file would not.  */
+	      if (*input_dir && access (name, F_OK) == 0)
+		{
+		  free (input_dir);
+		  free (name);
+		  goto out;
+		}
+	    }
+	  free (input_dir);
+	  free (name);
+	}
+
+      obstack_grow (&ob, "#include ", 9);
+      obstack_grow (&source_ob, "#include ", 9);
+      if (path)
+	{
+	  obstack_1grow (&ob, '"');
+	  obstack_grow (&ob, path, strlen (path));
+	  obstack_1grow (&ob, '"');
+	  obstack_1grow (&source_ob, '"');
+	  obstack_grow (&source_ob, input_path, strlen (input_path));
+	  obstack_1grow (&source_ob, '"');
+	  free (path);
+	  free (input_path);
+	}
+      else
+	{
+	  obstack_grow (&ob, text, strlen (text));
+	  obstack_grow (&source_ob, text, strlen (text));
+	}
+      obstack_1grow (&ob, '\n');
+      obstack_1grow (&source_ob, '\n');
+    }
+  obstack_1grow (&ob, '\0');
+  text = XOBFINISH (&ob, char *);
+  obstack_1grow (&source_ob, '\0');
+  source = XOBFINISH (&source_ob, char *);
+
+  /* The header is named after everything that affects its meaning: the
+     compiler, the options, how relative paths in them resolve, and the
+     directives themselves.  */
+  md5_init_ctx (&ctx);
+#define PCH_CACHE_KEY(STR) md5_process_bytes ((STR), strlen (STR) + 1, &ctx)
+  PCH_CACHE_KEY (version_string);
+  PCH_CACHE_KEY (spec_machine);
+  PCH_CACHE_KEY (lang);
+  PCH_CACHE_KEY (getpwd ());
+  for (i = 0; i < n_switches; i++)
+    if (pch_cache_option_p (&switches[i]))
+      {
+	PCH_CACHE_KEY (switches[i].part1);
+	for (const char **arg = switches[i].args; arg && *arg; arg++)
+	  PCH_CACHE_KEY (*arg);
+      }
+  for (const char *const *var = pch_cache_env_vars; *var; var++)
+    {
+      env_value = env.get (*var);
+      PCH_CACHE_KEY (*var);
+      PCH_CACHE_KEY (env_value ? env_value : "");
+    }
+  PCH_CACHE_KEY (text);
+#undef PCH_CACHE_KEY
+  md5_finish_ctx (&ctx, sum);
+  for (ix = 0; ix < sizeof (sum); ix++)
+    sprintf (key + 2 * ix, "%02x", sum[ix]);
+
+  header = concat (dir, dir_separator_str, key, ".h", NULL);
+  gch = concat (header, ".gch", NULL);
+  deps = concat (header, ".d", NULL);
+  lock = concat (header, ".lock", NULL);
+  failed = concat (header, ".failed", NULL);
+
+  if (pch_cache_fresh_p (gch, deps))
+    ;
+  /* Do not retry a header that failed to compile until one of the
+     files it depends on changes.  */
+  else if (pch_cache_fresh_p (failed, deps) || verbose_only_flag)
+    goto out;
+  else
+    {
+      /* Let only one compilation precompile the header; the others go
+	 without it meanwhile.  A lock left behind by a compilation that
+	 was killed is broken after a while.  */
+      mkdir (dir, 0777);
+      fd = open (lock, O_WRONLY | O_CREAT | O_EXCL, 0666);
+      if (fd < 0
+	  && errno == EEXIST
+	  && stat (lock, &st) == 0
+	  && st.st_mtime + PCH_CACHE_LOCK_TIMEOUT < time (NULL)
+	  && remove (lock) == 0)
+	fd = open (lock, O_WRONLY | O_CREAT | O_EXCL, 0666);
+      if (fd < 0)
+	goto out;
+      close (fd);
+
+      FILE *f = fopen (header, "w");
+      bool ok = (f
+		 && fputs (text, f) != EOF
+		 && fclose (f) == 0
+		 && pch_cache_build (lang, source, gch, deps));
+
+      if (ok)
+	remove (failed);
+      else if ((f = fopen (failed, "w")))
+	fclose (f);
+      remove (lock);
+      if (!ok)
+	goto out;
+    }
+
+  /* The compiler still reads the header if it cannot use the precompiled
+     one, which includes the same files, so skipping the directives is
+     right either way.  */
+  char count[32];
+  snprintf (count, sizeof (count), "%u", lines.length ());
+  result = concat ("-include ", convert_white_space (xstrdup (header)),
+		   " -fpch-cache-skip-includes=", count,
+		   " %{MD|MMD:-fpch-deps}", NULL);
+
+ out:
+  obstack_free (&ob, NULL);
+  obstack_free (&source_ob, NULL);
+  FOR_EACH_VEC_ELT (lines, ix, text)
+    free (text);
+  free (header);
+  free (gch);
+  free (deps);
+  free (lock);
+  free (failed);
+  return result;
+}
+
 /* Insert backslash before spaces in ORIG (usually a file path), to 
    avoid being broken by spec parser.
 
@@ -371,6 +371,36 @@ relocate_ptrs (void *ptr_p, void *state_p)
   *ptr = result->new_addr;
 }
 
+/* Return the size of the relocation bitmap of a PCH image of SIZE
+   bytes.  */
+
+static size_t
+pch_reloc_size (size_t size)
+{
+  return (size / sizeof (void *) + CHAR_BIT - 1) / CHAR_BIT;
+}
+
+/* Set the bits of the relocation bitmap RELOC of a PCH image written for
+   address BASE for the pointers in object D, which relocate_ptrs has
+   just changed from ORIG.  Pointers are found this way rather than in
+   relocate_ptrs because some are passed to it through a temporary.  The
+   address of an object in the image is never that of a live object, so
+   every relocated pointer changes.  */
+
+static void
+note_reloc_ptrs (unsigned char *reloc, char *base, struct ptr_data *d,
+		 const char *orig)
+{
+  const uintptr_t *words = (const uintptr_t *) d->obj;
+  const uintptr_t *orig_words = (const uintptr_t *) orig;
+  size_t first = ((char *) d->new_addr - base) / sizeof (void *);
+
+  gcc_checking_assert (((char *) d->new_addr - base) % sizeof (void *) == 0);
+  for (size_t i = 0; i < d->size / sizeof (void *); i++)
+    if (words[i] != orig_words[i])
+      reloc[(first + i) / CHAR_BIT] |= 1 << ((first + i) % CHAR_BIT);
+}
+
 /* Write out, after relocation, the pointers in TAB.  */
 static void
 write_pch_globals (const struct ggc_root_tab * const *tab,
@@ -423,6 +453,7 @@ gt_pch_save (FILE *f)
   struct traversal_state state;
   char *this_object = NULL;
   size_t this_object_size = 0;
+  unsigned char *reloc;
   struct mmap_info mmi;
   const size_t mmap_offset_alignment = host_hooks.gt_pch_alloc_granularity ();
 
@@ -491,6 +522,7 @@ gt_pch_save (FILE *f)
     fatal_error (input_location, "can%'t write padding to PCH file: %m");
 
   ggc_pch_prepare_write (state.d, state.f);
+  reloc = XCNEWVEC (unsigned char, pch_reloc_size (mmi.size));
 
 #if defined ENABLE_VALGRIND_ANNOTATIONS && defined VALGRIND_GET_VBITS
   vec<char> vbits = vNULL;
@@ -556,6 +588,8 @@ gt_pch_save (FILE *f)
       state.ptrs[i]->note_ptr_fn (state.ptrs[i]->obj,
 				  state.ptrs[i]->note_ptr_cookie,
 				  relocate_ptrs, &state);
+      note_reloc_ptrs (reloc, (char *) mmi.preferred_base, state.ptrs[i],
+		       this_object);
       ggc_pch_write_object (state.d, state.f, state.ptrs[i]->obj,
 			    state.ptrs[i]->new_addr, state.ptrs[i]->size,
 			    state.ptrs[i]->note_ptr_fn == gt_pch_p_S);
@@ -582,12 +616,83 @@ gt_pch_save (FILE *f)
   ggc_pch_finish (state.d, state.f);
   gt_pch_fixup_stringpool ();
 
+  if (fwrite (reloc, pch_reloc_size (mmi.size), 1, state.f) != 1)
+    fatal_error (input_location, "can%'t write PCH file: %m");
+
+  XDELETE (reloc);
   XDELETE (state.ptrs);
   XDELETE (this_object);
   delete saving_htab;
   saving_htab = NULL;
 }
 
+/* Allocate SIZE bytes for a PCH image that cannot be put at the address
+   it was written for, and set *BASE to their address.  Load them with
+   the data from FD at OFFSET if that is cheap.  Return 1 if done, and 0
+   if the data still has to be read in.  */
+
+static int
+gt_pch_use_any_address (void **base, size_t size, int fd ATTRIBUTE_UNUSED,
+			size_t offset ATTRIBUTE_UNUSED)
+{
+  size_t align = host_hooks.gt_pch_alloc_granularity ();
+  char *addr;
+
+#if HAVE_MMAP_FILE
+  addr = (char *) mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+			fd, offset);
+  if (addr != (char *) MAP_FAILED)
+    {
+      *base = addr;
+      return 1;
+    }
+#endif
+
+  /* The image is laid out in pages, so it has to be aligned the same
+     way wherever it goes.  */
+  addr = XNEWVEC (char, size + align - 1);
+  *base = (void *) (((uintptr_t) addr + align - 1) & -(uintptr_t) align);
+  return 0;
+}
+
+/* Relocate the PCH image of SIZE bytes at BASE that was written for
+   address PREFERRED_BASE, using the relocation bitmap read from F, and
+   the global pointers into it.  */
+
+static void
+gt_pch_relocate (FILE *f, char *base, char *preferred_base, size_t size)
+{
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  size_t reloc_size = pch_reloc_size (size);
+  unsigned char *reloc = XNEWVEC (unsigned char, reloc_size);
+  uintptr_t delta = (uintptr_t) base - (uintptr_t) preferred_base;
+  uintptr_t *words = (uintptr_t *) base;
+  size_t i;
+
+  timevar_push (TV_PCH_PTR_RELOCATE);
+  if (fread (reloc, reloc_size, 1, f) != 1)
+    fatal_error (input_location, "can%'t read PCH file: %m");
+
+  for (i = 0; i < reloc_size; i++)
+    if (reloc[i])
+      for (unsigned bit = 0; bit < CHAR_BIT; bit++)
+	if (reloc[i] & (1 << bit))
+	  words[i * CHAR_BIT + bit] += delta;
+
+  for (rt = gt_ggc_rtab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      for (i = 0; i < rti->nelt; i++)
+	{
+	  uintptr_t *p = (uintptr_t *) ((char *) rti->base + rti->stride * i);
+	  if (*p - (uintptr_t) preferred_base < size)
+	    *p += delta;
+	}
+
+  XDELETE (reloc);
+  timevar_pop (TV_PCH_PTR_RELOCATE);
+}
+
 /* Read the state of the compiler back in from F.  */
 
 void
@@ -597,6 +702,7 @@ gt_pch_restore (FILE *f)
   const struct ggc_root_tab *rti;
   size_t i;
   struct mmap_info mmi;
+  void *addr;
   int result;
 
   /* Delete any deletable objects.  This makes ggc_pch_read much
@@ -623,20 +729,33 @@ gt_pch_restore (FILE *f)
   if (fread (&mmi, sizeof (mmi), 1, f) != 1)
     fatal_error (input_location, "can%'t read PCH file: %m");
 
-  result = host_hooks.gt_pch_use_address (mmi.preferred_base, mmi.size,
-					  fileno (f), mmi.offset);
+  addr = mmi.preferred_base;
+  result = host_hooks.gt_pch_use_address (addr, mmi.size, fileno (f),
+					  mmi.offset);
   if (result < 0)
-    fatal_error (input_location, "had to relocate PCH");
+    result = gt_pch_use_any_address (&addr, mmi.size, fileno (f), mmi.offset);
   if (result == 0)
     {
       if (fseek (f, mmi.offset, SEEK_SET) != 0
-	  || fread (mmi.preferred_base, mmi.size, 1, f) != 1)
+	  || fread (addr, mmi.size, 1, f) != 1)
 	fatal_error (input_location, "can%'t read PCH file: %m");
     }
   else if (fseek (f, mmi.offset + mmi.size, SEEK_SET) != 0)
     fatal_error (input_location, "can%'t read PCH file: %m");
 
-  ggc_pch_read (f, mmi.preferred_base);
+  ggc_pch_read (f, addr);
+
+  /* The pages of an image mapped where it was written for stay shared
+     with other processes using it; one mapped elsewhere has to have the
+     pointers in it adjusted.  */
+  if (addr == mmi.preferred_base)
+    {
+      if (fseek (f, pch_reloc_size (mmi.size), SEEK_CUR) != 0)
+	fatal_error (input_location, "can%'t read PCH file: %m");
+    }
+  else
+    gt_pch_relocate (f, (char *) addr, (char *) mmi.preferred_base,
+		     mmi.size);
 
   gt_pch_restore_stringpool ();
 }
@@ -655,15 +774,18 @@ default_gt_pch_get_address (size_t size ATTRIBUTE_UNUSED,
 /* Default version of HOST_HOOKS_GT_PCH_USE_ADDRESS when mmap is not present.
    Allocate SIZE bytes with malloc.  Return 0 if the address we got is the
    same as base, indicating that the memory has been allocated but needs to
-   be read in from the file.  Return -1 if the address differs, to relocation
-   of the PCH file would be required.  */
+   be read in from the file.  Return -1 if the address differs, so that
+   the PCH file has to be loaded elsewhere and relocated.  */
 
 int
 default_gt_pch_use_address (void *base, size_t size, int fd ATTRIBUTE_UNUSED,
 			    size_t offset ATTRIBUTE_UNUSED)
 {
   void *addr = xmalloc (size);
-  return (addr == base) - 1;
+  if (addr == base)
+    return 0;
+  free (addr);
+  return -1;
 }
 
 /* Default version of HOST_HOOKS_GT_PCH_GET_ADDRESS.   Return the
@@ -318,7 +318,9 @@ typedef page_entry **page_table[PAGE_L1_SIZE];
 
 /* On 64-bit hosts, we use the same two level page tables plus a linked
    list that disambiguates the top 32-bits.  There will almost always be
-   exactly one entry in the list.  */
+   exactly one entry in the list; when there are more (heaps larger than
+   4GB, as in LTO WPA), lookup_page_table_entry keeps the most recently
+   used one at the front.  */
 typedef struct page_table_chain
 {
   struct page_table_chain *next;
@@ -400,6 +402,10 @@ static struct ggc_globals
   /* Bytes currently allocated at the end of the last collection.  */
   size_t allocated_last_gc;
 
+  /* The largest value of ALLOCATED seen when it last decreased, since
+     the last call to ggc_reset_heap_peak.  */
+  size_t allocated_peak;
+
   /* Total amount of memory mapped.  */
   size_t bytes_mapped;
 
@@ -493,6 +499,21 @@ static struct ggc_globals
 
     /* The overhead for each of the allocation orders.  */
     unsigned long long total_overhead_per_order[NUM_ORDERS];
+
+    /* Number of allocations carved from a freshly allocated page,
+       satisfied by the next_bit_hint of the page at the head of the
+       list, or requiring a scan of its in_use_p bitmap.  */
+    unsigned long long alloc_new_page;
+    unsigned long long alloc_hint_hit;
+    unsigned long long alloc_bitmap_scan;
+
+    /* Number of bitmap words examined by those scans.  */
+    unsigned long long alloc_scanned_words;
+
+    /* Objects and bytes handed back explicitly with ggc_free, and
+       therefore never left for a collection to find.  */
+    unsigned long long total_freed;
+    unsigned long long total_freed_bytes;
   } stats;
 } G;
 
@@ -631,8 +652,23 @@ lookup_page_table_entry (const void *p)
 #else
   page_table table = G.lookup;
   uintptr_t high_bits = (uintptr_t) p & ~ (uintptr_t) 0xffffffff;
-  while (table->high_bits != high_bits)
-    table = table->next;
+  if (table->high_bits != high_bits)
+    {
+      /* The marking routines call us for every reachable object, and
+	 consecutive objects tend to live in the same 4GB window.  Move
+	 the table we find to the head of the list so that the next
+	 lookup does not have to walk it again.  */
+      page_table prev;
+      do
+	{
+	  prev = table;
+	  table = table->next;
+	}
+      while (table->high_bits != high_bits);
+      prev->next = table->next;
+      table->next = G.lookup;
+      G.lookup = table;
+    }
   base = &table->table[0];
 #endif
 
@@ -1311,6 +1347,9 @@ ggc_internal_alloc (size_t size, void (*f)(void *), size_t s, size_t n
       word = 0;
       bit = 0;
       object_offset = 0;
+
+      if (GATHER_STATISTICS)
+	G.stats.alloc_new_page++;
     }
   else
     {
@@ -1322,22 +1361,53 @@ ggc_internal_alloc (size_t size, void (*f)(void *), size_t s, size_t n
       word = hint / HOST_BITS_PER_LONG;
       bit = hint % HOST_BITS_PER_LONG;
 
-      /* If the hint didn't work, scan the bitmap from the beginning.  */
+      /* If the hint didn't work, scan the bitmap for a word with a
+	 clear bit.  Objects are handed out in address order, so the
+	 words before the hint are mostly full; start at the hint and
+	 only wrap around to the beginning of the page when the tail
+	 of the bitmap is exhausted.  The page has a free object, so
+	 this terminates.  */
       if ((entry->in_use_p[word] >> bit) & 1)
 	{
-	  word = bit = 0;
-	  while (~entry->in_use_p[word] == 0)
-	    ++word;
+	  size_t num_bits = OBJECTS_IN_PAGE (entry) + 1;
+	  size_t num_words = CEIL (num_bits, HOST_BITS_PER_LONG);
+	  unsigned long in_use;
+
+	  /* The bits after the one-past-the-end bit in the last word
+	     are clear but do not stand for objects; treat them as in
+	     use.  */
+	  unsigned long padding = 0;
+	  if (num_bits % HOST_BITS_PER_LONG)
+	    padding = ~0UL << (num_bits % HOST_BITS_PER_LONG);
+
+	  for (;;)
+	    {
+	      in_use = entry->in_use_p[word];
+	      if (word == num_words - 1)
+		in_use |= padding;
+	      if (~in_use != 0)
+		break;
+	      if (++word == num_words)
+		word = 0;
+	      if (GATHER_STATISTICS)
+		G.stats.alloc_scanned_words++;
+	    }
 
 #if GCC_VERSION >= 3004
-	  bit = __builtin_ctzl (~entry->in_use_p[word]);
+	  bit = __builtin_ctzl (~in_use);
 #else
-	  while ((entry->in_use_p[word] >> bit) & 1)
+	  bit = 0;
+	  while ((in_use >> bit) & 1)
 	    ++bit;
 #endif
 
 	  hint = word * HOST_BITS_PER_LONG + bit;
+
+	  if (GATHER_STATISTICS)
+	    G.stats.alloc_bitmap_scan++;
 	}
+      else if (GATHER_STATISTICS)
+	G.stats.alloc_hint_hit++;
 
       /* Next time, try the next bit.  */
       entry->next_bit_hint = hint + 1;
@@ -1598,7 +1668,11 @@ ggc_free (void *p)
   size_t size = OBJECT_SIZE (order);
 
   if (GATHER_STATISTICS)
-    ggc_free_overhead (p);
+    {
+      ggc_free_overhead (p);
+      G.stats.total_freed++;
+      G.stats.total_freed_bytes += size;
+    }
 
   if (GGC_DEBUG_LEVEL >= 3)
     fprintf (G.debug_file,
@@ -1627,6 +1701,7 @@ ggc_free (void *p)
   {
     unsigned int bit_offset, word, bit;
 
+    G.allocated_peak = MAX (G.allocated_peak, G.allocated);
     G.allocated -= size;
 
     /* Mark the object not-in-use.  */
@@ -2185,6 +2260,7 @@ ggc_collect (void)
 
   /* Zero the total allocated bytes.  This will be recalculated in the
      sweep phase.  */
+  G.allocated_peak = MAX (G.allocated_peak, G.allocated);
   G.allocated = 0;
 
   /* Release the pages we freed the last time we collected, but didn't
@@ -2237,6 +2313,24 @@ ggc_grow (void)
     fprintf (stderr, " {GC start %luk} ", (unsigned long) G.allocated / 1024);
 }
 
+/* Return the largest number of bytes allocated in the GC heap at any
+   time since the last call to ggc_reset_heap_peak.  */
+
+size_t
+ggc_heap_peak (void)
+{
+  return MAX (G.allocated_peak, G.allocated);
+}
+
+/* Start tracking the peak size of the GC heap again, from PEAK bytes or
+   the current size if that is larger.  */
+
+void
+ggc_reset_heap_peak (size_t peak)
+{
+  G.allocated_peak = peak;
+}
+
 /* Print allocation statistics.  */
 #define SCALE(x) ((unsigned long) ((x) < 1024*10 \
 		  ? (x) \
@@ -2344,6 +2438,24 @@ ggc_print_statistics (void)
 		     (unsigned long) OBJECT_SIZE (i),
 		     G.stats.total_allocated_per_order[i]);
 	  }
+
+      unsigned long long allocs = (G.stats.alloc_new_page
+				   + G.stats.alloc_hint_hit
+				   + G.stats.alloc_bitmap_scan);
+      fprintf (stderr, "\nObject allocations:                      %10"
+	       HOST_LONG_LONG_FORMAT "u\n", allocs);
+      fprintf (stderr, "  from a new page:                       %10"
+	       HOST_LONG_LONG_FORMAT "u\n", G.stats.alloc_new_page);
+      fprintf (stderr, "  via the next-bit hint:                 %10"
+	       HOST_LONG_LONG_FORMAT "u (%.1f%%)\n", G.stats.alloc_hint_hit,
+	       allocs ? G.stats.alloc_hint_hit * 100.0 / allocs : 0.0);
+      fprintf (stderr, "  via a bitmap scan:                     %10"
+	       HOST_LONG_LONG_FORMAT "u (%" HOST_LONG_LONG_FORMAT
+	       "u words)\n", G.stats.alloc_bitmap_scan,
+	       G.stats.alloc_scanned_words);
+      fprintf (stderr, "Objects freed by ggc_free:               %10"
+	       HOST_LONG_LONG_FORMAT "u (%" HOST_LONG_LONG_FORMAT
+	       "u bytes)\n", G.stats.total_freed, G.stats.total_freed_bytes);
   }
 }
 
@@ -469,6 +469,40 @@ test_tree_marking ()
 
 namespace selftest {
 
+/* Benchmark: allocating small objects of assorted sizes from the
+   garbage-collected heap and freeing them, in batches.  */
+
+static void
+bench_alloc_free (unsigned int iterations)
+{
+  const unsigned int batch_size = 256;
+  void *batch[batch_size];
+  unsigned int n = 0;
+  size_t sum = 0;
+
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      batch[n++] = ggc_internal_alloc (16 + (i & 3) * 16);
+      if (n == batch_size)
+	{
+	  sum += (size_t) batch[0];
+	  while (n > 0)
+	    ggc_free (batch[--n]);
+	}
+    }
+  while (n > 0)
+    ggc_free (batch[--n]);
+  benchmark_consume (sum);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+ggc_tests_c_benchmarks ()
+{
+  run_benchmark ("ggc/alloc_free", bench_alloc_free);
+}
+
 /* Run all of the selftests within this file.  */
 
 void
@@ -263,6 +263,13 @@ extern void gt_pch_restore (FILE *f);
 /* Print allocation statistics.  */
 extern void ggc_print_statistics (void);
 
+/* Return the peak size of the GC heap since the last call to
+   ggc_reset_heap_peak.  */
+extern size_t ggc_heap_peak (void);
+
+/* Restart tracking the peak size of the GC heap.  */
+extern void ggc_reset_heap_peak (size_t);
+
 extern void stringpool_statistics (void);
 
 /* Heuristics.  */
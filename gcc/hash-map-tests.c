@@ -38,13 +38,14 @@ along with GCC; see the file COPYING3.  If not see
 
 namespace selftest {
 
-/* Construct a hash_map <const char *, int> and verify that
+/* Construct a hash_map <const char *, int> of type Map and verify that
    various operations work correctly.  */
 
+template <typename Map>
 static void
 test_map_of_strings_to_int ()
 {
-  hash_map <const char *, int> m;
+  Map m;
 
   const char *ostrich = "ostrich";
   const char *elephant = "elephant";
@@ -85,7 +86,40 @@ test_map_of_strings_to_int ()
 void
 hash_map_tests_c_tests ()
 {
-  test_map_of_strings_to_int ();
+  typedef simple_hashmap_traits <default_hash_traits <const char *>, int>
+    traits;
+  test_map_of_strings_to_int <hash_map <const char *, int> > ();
+  test_map_of_strings_to_int <hash_map <const char *, int, traits, true> > ();
+}
+
+/* Benchmark: updating the value of an existing key, then looking up a
+   key that may or may not be present, in a map of 4096 elements.  */
+
+static void
+bench_put_get (unsigned int iterations)
+{
+  const int n = 4096;
+  hash_map <int_hash <int, -1, -2>, int> m (n);
+  for (int i = 0; i < n; i++)
+    m.put (i * 2, i);
+
+  size_t sum = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      int key = (int) (i % n);
+      m.put (key * 2, key);
+      if (int *value = m.get (key))
+	sum += *value;
+    }
+  benchmark_consume (sum);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+hash_map_tests_c_benchmarks ()
+{
+  run_benchmark ("hash_map/put_get", bench_put_get);
 }
 
 } // namespace selftest
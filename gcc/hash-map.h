@@ -21,8 +21,12 @@ along with GCC; see the file COPYING3.  If not see
 #ifndef hash_map_h
 #define hash_map_h
 
+/* A map from keys of type KeyId to values of type Value, hashed and
+   compared by Traits.  Specify Tagged as true to use a tagged hash_table,
+   see hash-table.h; tagged maps cannot live in GC memory.  */
+
 template<typename KeyId, typename Value,
-	 typename Traits>
+	 typename Traits, bool Tagged>
 class GTY((user)) hash_map
 {
   typedef typename Traits::key_type Key;
@@ -181,7 +185,7 @@ public:
 				   const Value &, Arg)>
   void traverse (Arg a) const
     {
-      for (typename hash_table<hash_entry>::iterator iter = m_table.begin ();
+      for (typename hash_table<hash_entry, xcallocator, Tagged>::iterator iter = m_table.begin ();
 	   iter != m_table.end (); ++iter)
 	f ((*iter).m_key, (*iter).m_value, a);
     }
@@ -190,7 +194,7 @@ public:
 				   Value *, Arg)>
   void traverse (Arg a) const
     {
-      for (typename hash_table<hash_entry>::iterator iter = m_table.begin ();
+      for (typename hash_table<hash_entry, xcallocator, Tagged>::iterator iter = m_table.begin ();
 	   iter != m_table.end (); ++iter)
 	if (!f ((*iter).m_key, &(*iter).m_value, a))
 	  break;
@@ -203,7 +207,7 @@ public:
   class iterator
   {
   public:
-    explicit iterator (const typename hash_table<hash_entry>::iterator &iter) :
+    explicit iterator (const typename hash_table<hash_entry, xcallocator, Tagged>::iterator &iter) :
       m_iter (iter) {}
 
     iterator &operator++ ()
@@ -225,7 +229,7 @@ public:
     }
 
   private:
-    typename hash_table<hash_entry>::iterator m_iter;
+    typename hash_table<hash_entry, xcallocator, Tagged>::iterator m_iter;
   };
 
   /* Standard iterator retrieval methods.  */
@@ -239,7 +243,7 @@ private:
   template<typename T, typename U, typename V> friend void gt_pch_nx (hash_map<T, U, V> *);
       template<typename T, typename U, typename V> friend void gt_pch_nx (hash_map<T, U, V> *, gt_pointer_operator, void *);
 
-  hash_table<hash_entry> m_table;
+  hash_table<hash_entry, xcallocator, Tagged> m_table;
 };
 
 /* ggc marking routines.  */
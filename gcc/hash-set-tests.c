@@ -30,13 +30,14 @@ along with GCC; see the file COPYING3.  If not see
 
 namespace selftest {
 
-/* Construct a hash_set <const char *> and verify that various operations
-   work correctly.  */
+/* Construct a hash_set <const char *> of type Set and verify that
+   various operations work correctly.  */
 
+template <typename Set>
 static void
 test_set_of_strings ()
 {
-  hash_set <const char *> s;
+  Set s;
   ASSERT_EQ (0, s.elements ());
 
   const char *red = "red";
@@ -61,7 +62,10 @@ test_set_of_strings ()
 void
 hash_set_tests_c_tests ()
 {
-  test_set_of_strings ();
+  test_set_of_strings <hash_set <const char *> > ();
+  test_set_of_strings <hash_set <const char *,
+				 default_hash_traits <const char *>,
+				 true> > ();
 }
 
 } // namespace selftest
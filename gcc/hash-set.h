@@ -21,7 +21,12 @@ along with GCC; see the file COPYING3.  If not see
 #ifndef hash_set_h
 #define hash_set_h
 
-template<typename KeyId, typename Traits = default_hash_traits<KeyId> >
+/* A set of keys of type KeyId, hashed and compared by Traits.  Specify
+   Tagged as true to use a tagged hash_table, see hash-table.h; tagged
+   sets cannot live in GC memory.  */
+
+template<typename KeyId, typename Traits = default_hash_traits<KeyId>,
+	 bool Tagged = false>
 class hash_set
 {
 public:
@@ -71,7 +76,7 @@ public:
   template<typename Arg, bool (*f)(const typename Traits::value_type &, Arg)>
   void traverse (Arg a) const
     {
-      for (typename hash_table<Traits>::iterator iter = m_table.begin ();
+      for (typename hash_table<Traits, xcallocator, Tagged>::iterator iter = m_table.begin ();
 	   iter != m_table.end (); ++iter)
 	f (*iter, a);
     }
@@ -83,7 +88,7 @@ public:
   class iterator
   {
   public:
-    explicit iterator (const typename hash_table<Traits>::iterator &iter) :
+    explicit iterator (const typename hash_table<Traits, xcallocator, Tagged>::iterator &iter) :
       m_iter (iter) {}
 
     iterator &operator++ ()
@@ -105,7 +110,7 @@ public:
       }
 
   private:
-    typename hash_table<Traits>::iterator m_iter;
+    typename hash_table<Traits, xcallocator, Tagged>::iterator m_iter;
   };
 
   /* Standard iterator retrieval methods.  */
@@ -120,7 +125,7 @@ private:
   template<typename T, typename U> friend void gt_pch_nx (hash_set<T, U> *);
       template<typename T, typename U> friend void gt_pch_nx (hash_set<T, U> *, gt_pointer_operator, void *);
 
-  hash_table<Traits> m_table;
+  hash_table<Traits, xcallocator, Tagged> m_table;
 };
 
 /* ggc marking routines.  */
@@ -0,0 +1,209 @@
+/* Unit tests for hash-table.h.
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 3, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING3.  If not see
+<http://www.gnu.org/licenses/>.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+#include "hash-table.h"
+#include "selftest.h"
+
+#if CHECKING_P
+
+namespace selftest {
+
+/* Number of calls to counting_int_hash::equal so far.  */
+
+static unsigned int num_equal_calls;
+
+/* A descriptor for ints that spreads them over the whole hashval_t
+   range and counts the comparisons made by the table.  */
+
+struct counting_int_hash : int_hash <int, -1, -2>
+{
+  static inline hashval_t hash (int);
+  static inline bool equal (int, int);
+};
+
+inline hashval_t
+counting_int_hash::hash (int x)
+{
+  return (hashval_t) x * 0x9e3779b1U;
+}
+
+inline bool
+counting_int_hash::equal (int x, int y)
+{
+  num_equal_calls++;
+  return x == y;
+}
+
+/* Return true if TABLE contains X.  */
+
+template <typename Table>
+static bool
+contains_p (Table &table, int x)
+{
+  return table.find (x) == x;
+}
+
+/* Insert X into TABLE, returning true if it was already present.  */
+
+template <typename Table>
+static bool
+insert (Table &table, int x)
+{
+  int *slot = table.find_slot (x, INSERT);
+  bool existed = *slot == x;
+  *slot = x;
+  return existed;
+}
+
+/* Populate a hash table of kind Table, then verify lookups, removals,
+   reinsertion after removal, copying and emptying it.  Return the
+   number of calls to equal made by the lookups of absent elements.  */
+
+template <typename Table>
+static unsigned int
+test_table_kind ()
+{
+  const int n = 1000;
+  Table table (13);
+
+  for (int i = 0; i < n; i++)
+    ASSERT_FALSE (insert (table, i));
+  ASSERT_EQ (n, (int) table.elements ());
+  for (int i = 0; i < n; i++)
+    ASSERT_TRUE (insert (table, i));
+  ASSERT_EQ (n, (int) table.elements ());
+
+  /* Lookups of elements that are not in the table.  */
+  num_equal_calls = 0;
+  for (int i = n; i < 2 * n; i++)
+    ASSERT_FALSE (contains_p (table, i));
+  unsigned int misses = num_equal_calls;
+
+  /* Remove every other element, both via remove_elt and clear_slot.  */
+  for (int i = 0; i < n; i += 4)
+    table.remove_elt (i);
+  for (int i = 2; i < n; i += 4)
+    table.clear_slot (table.find_slot (i, NO_INSERT));
+  for (int i = 0; i < n; i++)
+    ASSERT_EQ (i % 2 != 0, contains_p (table, i));
+  ASSERT_EQ (n / 2, (int) table.elements ());
+
+  /* Slots freed by the removals must be usable again.  */
+  for (int i = 0; i < n; i += 2)
+    ASSERT_FALSE (insert (table, i));
+  for (int i = 0; i < n; i++)
+    ASSERT_TRUE (contains_p (table, i));
+
+  /* A copy must contain the same elements.  */
+  Table copy (table);
+  ASSERT_EQ (n, (int) copy.elements ());
+  for (int i = 0; i < 2 * n; i++)
+    ASSERT_EQ (i < n, contains_p (copy, i));
+
+  table.empty ();
+  ASSERT_EQ (0, (int) table.elements ());
+  for (int i = 0; i < n; i++)
+    ASSERT_FALSE (contains_p (table, i));
+  ASSERT_FALSE (insert (table, 42));
+  ASSERT_TRUE (contains_p (table, 42));
+
+  return misses;
+}
+
+/* Verify that untagged and tagged tables behave the same, and that the
+   tags let a tagged table skip most comparisons on a miss.  */
+
+static void
+test_tagged_table ()
+{
+  unsigned int untagged_misses
+    = test_table_kind <hash_table <counting_int_hash> > ();
+  unsigned int tagged_misses
+    = test_table_kind <hash_table <counting_int_hash, xcallocator, true> > ();
+
+  ASSERT_TRUE (untagged_misses > 0);
+  ASSERT_TRUE (tagged_misses * 8 < untagged_misses);
+
+  /* Only tagged tables carry the pointer to the tags.  */
+  ASSERT_EQ (sizeof (hash_table <counting_int_hash>) + sizeof (void *),
+	     sizeof (hash_table <counting_int_hash, xcallocator, true>));
+}
+
+/* Run all of the selftests within this file.  */
+
+void
+hash_table_tests_c_tests ()
+{
+  test_tagged_table ();
+}
+
+/* The number of elements in the tables timed by the benchmarks below.  */
+
+static const int bench_table_size = 4096;
+
+/* Benchmark: successful and unsuccessful lookups, alternately, in a
+   table of bench_table_size elements.  */
+
+static void
+bench_find (unsigned int iterations)
+{
+  hash_table <int_hash <int, -1, -2> > table (bench_table_size);
+  for (int i = 0; i < bench_table_size; i++)
+    insert (table, i * 3);
+
+  size_t found = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    found += contains_p (table, (int) (i % (2 * bench_table_size)) * 3 / 2);
+  benchmark_consume (found);
+}
+
+/* Benchmark: inserting an element and removing an older one, keeping
+   the table at bench_table_size elements.  */
+
+static void
+bench_insert_remove (unsigned int iterations)
+{
+  hash_table <int_hash <int, -1, -2> > table (bench_table_size);
+  for (int i = 0; i < bench_table_size; i++)
+    insert (table, i);
+
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      int x = (int) (i & 0x3fffffff);
+      insert (table, x + bench_table_size);
+      table.remove_elt (x);
+    }
+  benchmark_consume (table.elements ());
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+hash_table_tests_c_benchmarks ()
+{
+  run_benchmark ("hash_table/find", bench_find);
+  run_benchmark ("hash_table/insert_remove", bench_insert_remove);
+}
+
+} // namespace selftest
+
+#endif /* #if CHECKING_P */
@@ -77,7 +77,8 @@ along with GCC; see the file COPYING3.  If not see
          - A static member function named 'data_free'.  This function
          deallocates the data elements in the table.
 
-   Hash table are instantiated with two type arguments.
+   Hash table are instantiated with two type arguments and an optional
+   bool argument.
 
       * The descriptor type, (2) above.
 
@@ -85,6 +86,15 @@ along with GCC; see the file COPYING3.  If not see
       provide your own allocator type.  By default, hash tables will use
       the class template xcallocator, which uses malloc/free for allocation.
 
+      * Whether the table is tagged.  A tagged table keeps, next to the
+      elements, one byte per slot holding seven bits of the hash value
+      of the element stored there.  Probing skips slots whose tag does
+      not match the hash being looked up, so Descriptor::equal is called
+      only on the rare slots that could hold the element.  This pays off
+      when 'equal' is expensive or has to touch memory the table does not
+      otherwise need, at the cost of one byte per slot.  Tagged tables
+      cannot live in GC memory.  The default is an untagged table.
+
 
    DEFINING A DESCRIPTOR TYPE
 
@@ -240,8 +250,8 @@ along with GCC; see the file COPYING3.  If not see
 #include "hash-traits.h"
 #include "hash-map-traits.h"
 
-template<typename, typename, typename> class hash_map;
-template<typename, typename> class hash_set;
+template<typename, typename, typename, bool> class hash_map;
+template<typename, typename, bool> class hash_set;
 
 /* The ordinary memory allocator.  */
 /* FIXME (crowl): This allocator may be extracted for wider sharing later.  */
@@ -340,6 +350,70 @@ hash_table_mod2 (hashval_t hash, unsigned int index)
 
 class mem_usage;
 
+/* The tag bytes of a tagged hash_table, one per slot, zero for slots
+   about which nothing is known.  Untagged tables derive from the empty
+   specialization below, so they are no larger than before tags were
+   added and every tag operation compiles to nothing.  */
+
+template <bool Tagged>
+class hash_table_tags
+{
+protected:
+  hash_table_tags () : m_tags (NULL) {}
+  ~hash_table_tags () { free (m_tags); }
+
+  /* Replace the tags with SIZE zero tags.  */
+  void alloc_tags (size_t size)
+  {
+    free (m_tags);
+    m_tags = XCNEWVEC (unsigned char, size);
+  }
+
+  /* Copy the SIZE tags of OTHER.  */
+  void copy_tags (const hash_table_tags &other, size_t size)
+  {
+    free (m_tags);
+    m_tags = XDUPVEC (unsigned char, other.m_tags, size);
+  }
+
+  /* Reset the SIZE tags to zero.  */
+  void clear_tags (size_t size)
+  {
+    memset (m_tags, 0, size);
+  }
+
+  /* Return true if the tag of slot INDEX shows that it holds an element
+     whose hash value differs from one with tag TAG.  Such a slot is
+     neither empty nor deleted, and cannot compare equal.  */
+  bool tag_mismatch_p (size_t index, unsigned char tag) const
+  {
+    return m_tags[index] && m_tags[index] != tag;
+  }
+
+  /* Record TAG for slot INDEX.  */
+  void set_tag (size_t index, unsigned char tag)
+  {
+    m_tags[index] = tag;
+  }
+
+private:
+  hash_table_tags (const hash_table_tags &);
+  hash_table_tags &operator = (const hash_table_tags &);
+
+  unsigned char *m_tags;
+};
+
+template <>
+class hash_table_tags <false>
+{
+protected:
+  void alloc_tags (size_t) {}
+  void copy_tags (const hash_table_tags &, size_t) {}
+  void clear_tags (size_t) {}
+  bool tag_mismatch_p (size_t, unsigned char) const { return false; }
+  void set_tag (size_t, unsigned char) {}
+};
+
 /* User-facing hash table type.
 
    The table stores elements of type Descriptor::value_type and uses
@@ -349,13 +423,17 @@ class mem_usage;
    Specify the template Allocator to allocate and free memory.
      The default is xcallocator.
 
+   Specify Tagged as true to keep a tag byte per slot, see the
+     description at the top of the file.  The default is false.
+
      Storage is an implementation detail and should not be used outside the
      hash table code.
 
 */
 template <typename Descriptor,
-	 template<typename Type> class Allocator = xcallocator>
-class hash_table
+	 template<typename Type> class Allocator = xcallocator,
+	 bool Tagged = false>
+class hash_table : private hash_table_tags <Tagged>
 {
   typedef typename Descriptor::value_type value_type;
   typedef typename Descriptor::compare_type compare_type;
@@ -490,10 +568,10 @@ private:
   template<typename T> friend void
     hashtab_entry_note_pointers (void *, void *, gt_pointer_operator, void *);
   template<typename T, typename U, typename V> friend void
-  gt_pch_nx (hash_map<T, U, V> *, gt_pointer_operator, void *);
-  template<typename T, typename U> friend void gt_pch_nx (hash_set<T, U> *,
-							  gt_pointer_operator,
-							  void *);
+  gt_pch_nx (hash_map<T, U, V, false> *, gt_pointer_operator, void *);
+  template<typename T, typename U>
+  friend void gt_pch_nx (hash_set<T, U, false> *, gt_pointer_operator,
+			 void *);
   template<typename T> friend void gt_pch_nx (hash_table<T> *,
 					      gt_pointer_operator, void *);
 
@@ -524,6 +602,14 @@ private:
     Descriptor::mark_empty (v);
   }
 
+  /* Return the tag recorded for an element whose hash value is HASH.
+     The top bit is always set, so that a zero tag can mean that
+     nothing is known about the slot.  */
+  static unsigned char hash_tag (hashval_t hash)
+  {
+    return (hash >> 25) | 0x80;
+  }
+
   /* Table itself.  */
   typename Descriptor::value_type *m_entries;
 
@@ -565,16 +651,19 @@ extern mem_alloc_description<mem_usage> hash_table_usage;
 /* Support function for statistics.  */
 extern void dump_hash_table_loc_statistics (void);
 
-template<typename Descriptor, template<typename Type> class Allocator>
-hash_table<Descriptor, Allocator>::hash_table (size_t size, bool ggc, bool
-					       gather_mem_stats,
-					       mem_alloc_origin origin
-					       MEM_STAT_DECL) :
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+hash_table<Descriptor, Allocator, Tagged>::hash_table (size_t size, bool ggc,
+						       bool gather_mem_stats,
+						       mem_alloc_origin origin
+						       MEM_STAT_DECL) :
   m_n_elements (0), m_n_deleted (0), m_searches (0), m_collisions (0),
   m_ggc (ggc), m_gather_mem_stats (gather_mem_stats)
 {
   unsigned int size_prime_index;
 
+  gcc_checking_assert (!Tagged || !ggc);
+
   size_prime_index = hash_table_higher_prime_index (size);
   size = prime_tab[size_prime_index].prime;
 
@@ -583,21 +672,26 @@ hash_table<Descriptor, Allocator>::hash_table (size_t size, bool ggc, bool
 					  FINAL_PASS_MEM_STAT);
 
   m_entries = alloc_entries (size PASS_MEM_STAT);
+  this->alloc_tags (size);
   m_size = size;
   m_size_prime_index = size_prime_index;
 }
 
-template<typename Descriptor, template<typename Type> class Allocator>
-hash_table<Descriptor, Allocator>::hash_table (const hash_table &h, bool ggc,
-					       bool gather_mem_stats,
-					       mem_alloc_origin origin
-					       MEM_STAT_DECL) :
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+hash_table<Descriptor, Allocator, Tagged>::hash_table (const hash_table &h,
+						       bool ggc,
+						       bool gather_mem_stats,
+						       mem_alloc_origin origin
+						       MEM_STAT_DECL) :
   m_n_elements (h.m_n_elements), m_n_deleted (h.m_n_deleted),
   m_searches (0), m_collisions (0), m_ggc (ggc),
   m_gather_mem_stats (gather_mem_stats)
 {
   size_t size = h.m_size;
 
+  gcc_checking_assert (!Tagged || !ggc);
+
   if (m_gather_mem_stats)
     hash_table_usage.register_descriptor (this, origin, ggc
 					  FINAL_PASS_MEM_STAT);
@@ -612,12 +706,14 @@ hash_table<Descriptor, Allocator>::hash_table (const hash_table &h, bool ggc,
 	nentries[i] = entry;
     }
   m_entries = nentries;
+  this->copy_tags (h, size);
   m_size = size;
   m_size_prime_index = h.m_size_prime_index;
 }
 
-template<typename Descriptor, template<typename Type> class Allocator>
-hash_table<Descriptor, Allocator>::~hash_table ()
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+hash_table<Descriptor, Allocator, Tagged>::~hash_table ()
 {
   for (size_t i = m_size - 1; i < m_size; i--)
     if (!is_empty (m_entries[i]) && !is_deleted (m_entries[i]))
@@ -636,9 +732,12 @@ hash_table<Descriptor, Allocator>::~hash_table ()
 
 /* This function returns an array of empty hash table elements.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
-inline typename hash_table<Descriptor, Allocator>::value_type *
-hash_table<Descriptor, Allocator>::alloc_entries (size_t n MEM_STAT_DECL) const
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+inline typename hash_table<Descriptor, Allocator, Tagged>::value_type *
+hash_table<Descriptor, Allocator, Tagged>::alloc_entries (size_t n
+							   MEM_STAT_DECL)
+  const
 {
   value_type *nentries;
 
@@ -664,9 +763,11 @@ hash_table<Descriptor, Allocator>::alloc_entries (size_t n MEM_STAT_DECL) const
    This function also assumes there are no deleted entries in the table.
    HASH is the hash value for the element to be inserted.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
-typename hash_table<Descriptor, Allocator>::value_type *
-hash_table<Descriptor, Allocator>::find_empty_slot_for_expand (hashval_t hash)
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+typename hash_table<Descriptor, Allocator, Tagged>::value_type *
+hash_table<Descriptor, Allocator, Tagged>
+::find_empty_slot_for_expand (hashval_t hash)
 {
   hashval_t index = hash_table_mod1 (hash, m_size_prime_index);
   size_t size = m_size;
@@ -698,9 +799,10 @@ hash_table<Descriptor, Allocator>::find_empty_slot_for_expand (hashval_t hash)
    table entries is changed.  If memory allocation fails, this function
    will abort.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
 void
-hash_table<Descriptor, Allocator>::expand ()
+hash_table<Descriptor, Allocator, Tagged>::expand ()
 {
   value_type *oentries = m_entries;
   unsigned int oindex = m_size_prime_index;
@@ -734,6 +836,7 @@ hash_table<Descriptor, Allocator>::expand ()
   m_size_prime_index = nindex;
   m_n_elements -= m_n_deleted;
   m_n_deleted = 0;
+  this->alloc_tags (nsize);
 
   value_type *p = oentries;
   do
@@ -742,9 +845,11 @@ hash_table<Descriptor, Allocator>::expand ()
 
       if (!is_empty (x) && !is_deleted (x))
         {
-          value_type *q = find_empty_slot_for_expand (Descriptor::hash (x));
+	  hashval_t hash = Descriptor::hash (x);
+          value_type *q = find_empty_slot_for_expand (hash);
 
           *q = x;
+	  this->set_tag (q - m_entries, hash_tag (hash));
         }
 
       p++;
@@ -759,9 +864,10 @@ hash_table<Descriptor, Allocator>::expand ()
 
 /* Implements empty() in cases where it isn't a no-op.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
 void
-hash_table<Descriptor, Allocator>::empty_slow ()
+hash_table<Descriptor, Allocator, Tagged>::empty_slow ()
 {
   size_t size = m_size;
   value_type *entries = m_entries;
@@ -785,9 +891,14 @@ hash_table<Descriptor, Allocator>::empty_slow ()
       m_entries = alloc_entries (nsize);
       m_size = nsize;
       m_size_prime_index = nindex;
+      this->alloc_tags (nsize);
     }
   else
-    memset (entries, 0, size * sizeof (value_type));
+    {
+      for (i = size - 1; i >= 0; i--)
+	mark_empty (entries[i]);
+      this->clear_tags (size);
+    }
   m_n_deleted = 0;
   m_n_elements = 0;
 }
@@ -796,9 +907,10 @@ hash_table<Descriptor, Allocator>::empty_slow ()
    useful when you've already done the lookup and don't want to do it
    again. */
 
-template<typename Descriptor, template<typename Type> class Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
 void
-hash_table<Descriptor, Allocator>::clear_slot (value_type *slot)
+hash_table<Descriptor, Allocator, Tagged>::clear_slot (value_type *slot)
 {
   gcc_checking_assert (!(slot < m_entries || slot >= m_entries + size ()
 		         || is_empty (*slot) || is_deleted (*slot)));
@@ -806,6 +918,7 @@ hash_table<Descriptor, Allocator>::clear_slot (value_type *slot)
   Descriptor::remove (*slot);
 
   mark_deleted (*slot);
+  this->set_tag (slot - m_entries, 0);
   m_n_deleted++;
 }
 
@@ -813,18 +926,21 @@ hash_table<Descriptor, Allocator>::clear_slot (value_type *slot)
    COMPARABLE element starting with the given HASH value.  It cannot
    be used to insert or delete an element. */
 
-template<typename Descriptor, template<typename Type> class Allocator>
-typename hash_table<Descriptor, Allocator>::value_type &
-hash_table<Descriptor, Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+typename hash_table<Descriptor, Allocator, Tagged>::value_type &
+hash_table<Descriptor, Allocator, Tagged>
 ::find_with_hash (const compare_type &comparable, hashval_t hash)
 {
   m_searches++;
   size_t size = m_size;
   hashval_t index = hash_table_mod1 (hash, m_size_prime_index);
+  unsigned char tag = hash_tag (hash);
 
   value_type *entry = &m_entries[index];
-  if (is_empty (*entry)
-      || (!is_deleted (*entry) && Descriptor::equal (*entry, comparable)))
+  if (!this->tag_mismatch_p (index, tag)
+      && (is_empty (*entry)
+	  || (!is_deleted (*entry) && Descriptor::equal (*entry, comparable))))
     return *entry;
 
   hashval_t hash2 = hash_table_mod2 (hash, m_size_prime_index);
@@ -836,8 +952,10 @@ hash_table<Descriptor, Allocator>
         index -= size;
 
       entry = &m_entries[index];
-      if (is_empty (*entry)
-          || (!is_deleted (*entry) && Descriptor::equal (*entry, comparable)))
+      if (!this->tag_mismatch_p (index, tag)
+	  && (is_empty (*entry)
+	      || (!is_deleted (*entry)
+		  && Descriptor::equal (*entry, comparable))))
         return *entry;
     }
 }
@@ -850,9 +968,10 @@ hash_table<Descriptor, Allocator>
    write the value you want into the returned slot.  When inserting an
    entry, NULL may be returned if memory allocation fails. */
 
-template<typename Descriptor, template<typename Type> class Allocator>
-typename hash_table<Descriptor, Allocator>::value_type *
-hash_table<Descriptor, Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+typename hash_table<Descriptor, Allocator, Tagged>::value_type *
+hash_table<Descriptor, Allocator, Tagged>
 ::find_slot_with_hash (const compare_type &comparable, hashval_t hash,
 		       enum insert_option insert)
 {
@@ -864,14 +983,17 @@ hash_table<Descriptor, Allocator>
   value_type *first_deleted_slot = NULL;
   hashval_t index = hash_table_mod1 (hash, m_size_prime_index);
   hashval_t hash2 = hash_table_mod2 (hash, m_size_prime_index);
+  unsigned char tag = hash_tag (hash);
   value_type *entry = &m_entries[index];
   size_t size = m_size;
-  if (is_empty (*entry))
+  if (this->tag_mismatch_p (index, tag))
+    ;
+  else if (is_empty (*entry))
     goto empty_entry;
   else if (is_deleted (*entry))
     first_deleted_slot = &m_entries[index];
   else if (Descriptor::equal (*entry, comparable))
-    return &m_entries[index];
+    goto found_entry;
 
   for (;;)
     {
@@ -881,7 +1003,9 @@ hash_table<Descriptor, Allocator>
 	index -= size;
 
       entry = &m_entries[index];
-      if (is_empty (*entry))
+      if (this->tag_mismatch_p (index, tag))
+	;
+      else if (is_empty (*entry))
 	goto empty_entry;
       else if (is_deleted (*entry))
 	{
@@ -889,9 +1013,13 @@ hash_table<Descriptor, Allocator>
 	    first_deleted_slot = &m_entries[index];
 	}
       else if (Descriptor::equal (*entry, comparable))
-	return &m_entries[index];
+	goto found_entry;
     }
 
+ found_entry:
+  this->set_tag (index, tag);
+  return &m_entries[index];
+
  empty_entry:
   if (insert == NO_INSERT)
     return NULL;
@@ -900,10 +1028,12 @@ hash_table<Descriptor, Allocator>
     {
       m_n_deleted--;
       mark_empty (*first_deleted_slot);
+      this->set_tag (first_deleted_slot - m_entries, tag);
       return first_deleted_slot;
     }
 
   m_n_elements++;
+  this->set_tag (index, tag);
   return &m_entries[index];
 }
 
@@ -911,9 +1041,10 @@ hash_table<Descriptor, Allocator>
    from hash table starting with the given HASH.  If there is no
    matching element in the hash table, this function does nothing. */
 
-template<typename Descriptor, template<typename Type> class Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
 void
-hash_table<Descriptor, Allocator>
+hash_table<Descriptor, Allocator, Tagged>
 ::remove_elt_with_hash (const compare_type &comparable, hashval_t hash)
 {
   value_type *slot = find_slot_with_hash (comparable, hash, NO_INSERT);
@@ -923,6 +1054,7 @@ hash_table<Descriptor, Allocator>
   Descriptor::remove (*slot);
 
   mark_deleted (*slot);
+  this->set_tag (slot - m_entries, 0);
   m_n_deleted++;
 }
 
@@ -931,13 +1063,13 @@ hash_table<Descriptor, Allocator>
    ARGUMENT is passed as CALLBACK's second argument. */
 
 template<typename Descriptor,
-	  template<typename Type> class Allocator>
+	  template<typename Type> class Allocator, bool Tagged>
 template<typename Argument,
 	  int (*Callback)
-     (typename hash_table<Descriptor, Allocator>::value_type *slot,
+     (typename hash_table<Descriptor, Allocator, Tagged>::value_type *slot,
       Argument argument)>
 void
-hash_table<Descriptor, Allocator>::traverse_noresize (Argument argument)
+hash_table<Descriptor, Allocator, Tagged>::traverse_noresize (Argument argument)
 {
   value_type *slot = m_entries;
   value_type *limit = slot + size ();
@@ -957,13 +1089,13 @@ hash_table<Descriptor, Allocator>::traverse_noresize (Argument argument)
    to improve effectivity of subsequent calls.  */
 
 template <typename Descriptor,
-	  template <typename Type> class Allocator>
+	  template <typename Type> class Allocator, bool Tagged>
 template <typename Argument,
 	  int (*Callback)
-     (typename hash_table<Descriptor, Allocator>::value_type *slot,
+     (typename hash_table<Descriptor, Allocator, Tagged>::value_type *slot,
       Argument argument)>
 void
-hash_table<Descriptor, Allocator>::traverse (Argument argument)
+hash_table<Descriptor, Allocator, Tagged>::traverse (Argument argument)
 {
   size_t size = m_size;
   if (elements () * 8 < size && size > 32)
@@ -974,9 +1106,10 @@ hash_table<Descriptor, Allocator>::traverse (Argument argument)
 
 /* Slide down the iterator slots until an active entry is found.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
 void
-hash_table<Descriptor, Allocator>::iterator::slide ()
+hash_table<Descriptor, Allocator, Tagged>::iterator::slide ()
 {
   for ( ; m_slot < m_limit; ++m_slot )
     {
@@ -990,9 +1123,10 @@ hash_table<Descriptor, Allocator>::iterator::slide ()
 
 /* Bump the iterator.  */
 
-template<typename Descriptor, template<typename Type> class Allocator>
-inline typename hash_table<Descriptor, Allocator>::iterator &
-hash_table<Descriptor, Allocator>::iterator::operator ++ ()
+template<typename Descriptor, template<typename Type> class Allocator,
+	 bool Tagged>
+inline typename hash_table<Descriptor, Allocator, Tagged>::iterator &
+hash_table<Descriptor, Allocator, Tagged>::iterator::operator ++ ()
 {
   ++m_slot;
   slide ();
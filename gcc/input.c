@@ -3264,6 +3264,75 @@ for_each_line_table_case (void (*testcase) (const line_table_case &))
   ASSERT_EQ (num_cases_tested, 2 * 12);
 }
 
+/* A fragment of C source code, repeated to form the file lexed by
+   bench_lexer.  */
+
+static const char bench_lexer_fragment[] =
+  "#define MAX(A, B) ((A) > (B) ? (A) : (B))\n"
+  "/* Return the largest element of the LEN elements of V.  */\n"
+  "static unsigned long\n"
+  "largest_element (const unsigned long *v, int len)\n"
+  "{\n"
+  "  unsigned long result = 0x0UL;\n"
+  "  for (int i = 0; i < len; i++)\n"
+  "    result = MAX (result, v[i] >> 3);\n"
+  "  if (result == 0 && len > 16)\n"
+  "    fprintf (stderr, \"%s: %d\\n\", \"empty\", len);\n"
+  "  return result + 'x' + 1.5e3;\n"
+  "}\n";
+
+/* Benchmark: fetching tokens from the preprocessor, including the
+   expansion of a function-like macro.  The file is reread whenever its
+   end is reached; it is long enough that this does not dominate.  */
+
+static void
+bench_lexer (unsigned int iterations)
+{
+  const int n_fragments = 64;
+  char *content = XNEWVEC (char, n_fragments * sizeof bench_lexer_fragment);
+  content[0] = '\0';
+  for (int i = 0; i < n_fragments; i++)
+    strcat (content, bench_lexer_fragment);
+  temp_source_file tmp (SELFTEST_LOCATION, ".c", content);
+  XDELETEVEC (content);
+
+  line_table_test ltt;
+  cpp_reader *parser = NULL;
+  size_t sum = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      if (parser == NULL)
+	{
+	  parser = cpp_create_reader (CLK_GNUC99, NULL, line_table);
+	  cpp_init_iconv (parser);
+	  cpp_read_main_file (parser, tmp.get_filename ());
+	}
+      location_t loc;
+      const cpp_token *tok = cpp_get_token_with_location (parser, &loc);
+      sum += tok->type;
+      if (tok->type == CPP_EOF)
+	{
+	  cpp_finish (parser, NULL);
+	  cpp_destroy (parser);
+	  parser = NULL;
+	}
+    }
+  if (parser)
+    {
+      cpp_finish (parser, NULL);
+      cpp_destroy (parser);
+    }
+  benchmark_consume (sum);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+input_c_benchmarks ()
+{
+  run_benchmark ("cpp/get_token", bench_lexer);
+}
+
 /* Run all of the selftests within this file.  */
 
 void
@@ -165,22 +165,19 @@ sem_item::add_reference (sem_item *target)
   refs.safe_push (target);
   unsigned index = refs.length ();
   target->usages.safe_push (new sem_usage_pair(this, index));
-  bitmap_set_bit (target->usage_index_bitmap, index);
   refs_set.add (target->node);
 }
 
-/* Initialize internal data structures. Bitmap STACK is used for
-   bitmap memory allocation process.  */
+/* Initialize internal data structures.  */
 
 void
-sem_item::setup (bitmap_obstack *stack)
+sem_item::setup (bitmap_obstack *)
 {
   gcc_checking_assert (node);
 
   refs.create (0);
   tree_refs.create (0);
   usages.create (0);
-  usage_index_bitmap = BITMAP_ALLOC (stack);
 }
 
 sem_item::~sem_item ()
@@ -191,8 +188,6 @@ sem_item::~sem_item ()
   refs.release ();
   tree_refs.release ();
   usages.release ();
-
-  BITMAP_FREE (usage_index_bitmap);
 }
 
 /* Dump function for debugging purpose.  */
@@ -594,6 +589,18 @@ sem_function::equals_wpa (sem_item *item,
   if (cnode->thunk.thunk_p != cnode2->thunk.thunk_p)
     return return_false_with_msg ("thunk_p mismatch");
 
+  /* Functions with different shape can not be equal; the body summary
+     tells them apart without reading the bodies in WPA.  */
+  if (edge_count != m_compared_func->edge_count
+      || cfg_checksum != m_compared_func->cfg_checksum
+      || gcode_hash != m_compared_func->gcode_hash
+      || bb_sizes.length () != m_compared_func->bb_sizes.length ())
+    return return_false_with_msg ("body summaries are different");
+
+  for (unsigned i = 0; i < bb_sizes.length (); i++)
+    if (bb_sizes[i] != m_compared_func->bb_sizes[i])
+      return return_false_with_msg ("basic block sizes are different");
+
   if (cnode->thunk.thunk_p)
     {
       if (cnode->thunk.fixed_offset != cnode2->thunk.fixed_offset)
@@ -1396,6 +1403,9 @@ sem_function::init (void)
   ssa_names_size = SSANAMES (func)->length ();
   node = node;
 
+  /* In WPA, BB sizes may have been read from the summary.  */
+  bb_sizes.truncate (0);
+
   decl = fndecl;
   region_tree = func->eh->region_tree;
 
@@ -1458,6 +1468,36 @@ sem_function::init (void)
     }
 }
 
+/* Stream out to OB the summary of the function body that equals_wpa
+   compares, so that WPA does not need to read bodies to tell functions
+   with different shape apart.  */
+
+void
+sem_function::stream_out_body_summary (output_block *ob)
+{
+  streamer_write_uhwi (ob, edge_count);
+  streamer_write_uhwi (ob, cfg_checksum);
+  streamer_write_uhwi (ob, gcode_hash);
+  streamer_write_uhwi (ob, bb_sizes.length ());
+  for (unsigned i = 0; i < bb_sizes.length (); i++)
+    streamer_write_uhwi (ob, bb_sizes[i]);
+}
+
+/* Read the body summary written by stream_out_body_summary from IB.  */
+
+void
+sem_function::stream_in_body_summary (lto_input_block *ib)
+{
+  edge_count = streamer_read_uhwi (ib);
+  cfg_checksum = streamer_read_uhwi (ib);
+  gcode_hash = streamer_read_uhwi (ib);
+
+  unsigned count = streamer_read_uhwi (ib);
+  bb_sizes.reserve_exact (count);
+  for (unsigned i = 0; i < count; i++)
+    bb_sizes.quick_push (streamer_read_uhwi (ib));
+}
+
 /* Accumulate to HSTATE a hash of expression EXP.
    Identical to inchash::add_expr, but guaranteed to be stable across LTO
    and DECL equality classes.  */
@@ -2360,6 +2400,9 @@ sem_item_optimizer::write_summary (void)
 	  streamer_write_uhwi_stream (ob->main_stream, node_ref);
 
 	  streamer_write_uhwi (ob, (*item)->get_hash ());
+
+	  if ((*item)->type == FUNC)
+	    static_cast<sem_function *> (*item)->stream_out_body_summary (ob);
 	}
     }
 
@@ -2415,7 +2458,9 @@ sem_item_optimizer::read_section (lto_file_decl_data *file_data,
 	{
 	  cgraph_node *cnode = dyn_cast <cgraph_node *> (node);
 
-	  m_items.safe_push (new sem_function (cnode, hash, &m_bmstack));
+	  sem_function *f = new sem_function (cnode, hash, &m_bmstack);
+	  f->stream_in_body_summary (&ib_main);
+	  m_items.safe_push (f);
 	}
       else
 	{
@@ -2486,7 +2531,7 @@ sem_item_optimizer::add_class (congruence_class *cls)
   congruence_class_group *group = get_group_by_hash (
 				    cls->members[0]->get_hash (),
 				    cls->members[0]->type);
-  group->classes.safe_push (cls);
+  group->add (cls);
 }
 
 /* Gets a congruence class group based on given HASH value and TYPE.  */
@@ -2768,7 +2813,7 @@ sem_item_optimizer::build_hash_based_classes (void)
       if (!group->classes.length ())
 	{
 	  m_classes_count++;
-	  group->classes.safe_push (new congruence_class (class_id++));
+	  group->add (new congruence_class (class_id++));
 	}
 
       add_item_to_class (group->classes[0], item);
@@ -2899,7 +2944,7 @@ sem_item_optimizer::subdivide_classes_by_equality (bool in_wpa)
 			  m_classes_count++;
 			  add_item_to_class (c, item);
 
-			  (*it)->classes.safe_push (c);
+			  (*it)->add (c);
 			}
 		    }
 		}
@@ -2980,7 +3025,7 @@ sem_item_optimizer::subdivide_classes_by_sensitive_refs ()
 
 		      if (first_class)
 		        {
-			  (*it)->classes[i] = new_cls;
+			  (*it)->replace (c, new_cls);
 			  first_class = false;
 			}
 		      else
@@ -3002,7 +3047,7 @@ sem_item_optimizer::subdivide_classes_by_sensitive_refs ()
 	  }
 
 	for (unsigned i = 0; i < new_classes.length (); i++)
-	  (*it)->classes.safe_push (new_classes[i]);
+	  (*it)->add (new_classes[i]);
     }
 
   return newly_created_classes;
@@ -3115,16 +3160,10 @@ sem_item_optimizer::traverse_congruence_split (congruence_class * const &cls,
 
       congruence_class_group *slot = optimizer->m_classes.find(&g);
 
-      for (unsigned int i = 0; i < slot->classes.length (); i++)
-	if (slot->classes[i] == cls)
-	  {
-	    slot->classes.ordered_remove (i);
-	    break;
-	  }
-
-      /* New class will be inserted and integrated to work list.  */
-      for (unsigned int i = 0; i < 2; i++)
-	optimizer->add_class (newclasses[i]);
+      /* New classes take the place of the old one in its group.  Groups
+	 can hold a great many classes, so avoid searching them.  */
+      slot->replace (cls, newclasses[0]);
+      slot->add (newclasses[1]);
 
       /* Two classes replace one, so that increment just by one.  */
       optimizer->m_classes_count++;
@@ -3162,43 +3201,38 @@ sem_item_optimizer::traverse_congruence_split (congruence_class * const &cls,
 }
 
 /* Tests if a class CLS used as INDEXth splits any congruence classes.
-   Bitmap stack BMSTACK is used for bitmap allocation.  */
+   USAGES[START] to USAGES[END - 1] are the usages of members of CLS
+   with INDEX.  Bitmap stack BMSTACK is used for bitmap allocation.  */
 
 void
 sem_item_optimizer::do_congruence_step_for_index (congruence_class *cls,
-    unsigned int index)
+    unsigned int index, const vec<sem_usage_pair *> &usages,
+    unsigned int start, unsigned int end)
 {
   hash_map <congruence_class *, bitmap> split_map;
 
-  for (unsigned int i = 0; i < cls->members.length (); i++)
+  for (unsigned int i = start; i < end; i++)
     {
-      sem_item *item = cls->members[i];
+      sem_usage_pair *usage = usages[i];
 
-      /* Iterate all usages that have INDEX as usage of the item.  */
-      for (unsigned int j = 0; j < item->usages.length (); j++)
-	{
-	  sem_usage_pair *usage = item->usages[j];
-
-	  if (usage->index != index)
-	    continue;
+      gcc_checking_assert (usage->index == index);
 
-	  bitmap *slot = split_map.get (usage->item->cls);
-	  bitmap b;
+      bitmap *slot = split_map.get (usage->item->cls);
+      bitmap b;
 
-	  if(!slot)
-	    {
-	      b = BITMAP_ALLOC (&m_bmstack);
-	      split_map.put (usage->item->cls, b);
-	    }
-	  else
-	    b = *slot;
+      if(!slot)
+	{
+	  b = BITMAP_ALLOC (&m_bmstack);
+	  split_map.put (usage->item->cls, b);
+	}
+      else
+	b = *slot;
 
-	  gcc_checking_assert (usage->item->cls);
-	  gcc_checking_assert (usage->item->index_in_class <
-			       usage->item->cls->members.length ());
+      gcc_checking_assert (usage->item->cls);
+      gcc_checking_assert (usage->item->index_in_class <
+			   usage->item->cls->members.length ());
 
-	  bitmap_set_bit (b, usage->item->index_in_class);
-	}
+      bitmap_set_bit (b, usage->item->index_in_class);
     }
 
   traverse_split_pair pair;
@@ -3214,6 +3248,19 @@ sem_item_optimizer::do_congruence_step_for_index (congruence_class *cls,
   <traverse_split_pair *, sem_item_optimizer::release_split_map> (NULL);
 }
 
+/* Compare usage pairs A and B by index, for qsort.  */
+
+static int
+sort_usage_pairs_by_index (const void *a, const void *b)
+{
+  const sem_usage_pair *u1 = *(const sem_usage_pair * const *) a;
+  const sem_usage_pair *u2 = *(const sem_usage_pair * const *) b;
+
+  if (u1->index != u2->index)
+    return u1->index < u2->index ? -1 : 1;
+  return u1->item->index_in_class - u2->item->index_in_class;
+}
+
 /* Every usage of a congruence class CLS is a candidate that can split the
    collection of classes. Bitmap stack BMSTACK is used for bitmap
    allocation.  */
@@ -3221,27 +3268,33 @@ sem_item_optimizer::do_congruence_step_for_index (congruence_class *cls,
 void
 sem_item_optimizer::do_congruence_step (congruence_class *cls)
 {
-  bitmap_iterator bi;
-  unsigned int i;
-
-  bitmap usage = BITMAP_ALLOC (&m_bmstack);
+  /* Bucket the usages of all members by index at once, instead of
+     walking all of them again for every index.  */
+  auto_vec<sem_usage_pair *> usages;
 
   for (unsigned int i = 0; i < cls->members.length (); i++)
-    bitmap_ior_into (usage, cls->members[i]->usage_index_bitmap);
+    for (unsigned int j = 0; j < cls->members[i]->usages.length (); j++)
+      usages.safe_push (cls->members[i]->usages[j]);
 
-  EXECUTE_IF_SET_IN_BITMAP (usage, 0, i, bi)
-  {
-    if (dump_file && (dump_flags & TDF_DETAILS))
-      fprintf (dump_file, "  processing congruence step for class: %u, index: %u\n",
-	       cls->id, i);
+  usages.qsort (sort_usage_pairs_by_index);
 
-    do_congruence_step_for_index (cls, i);
+  for (unsigned int start = 0, end; start < usages.length (); start = end)
+    {
+      unsigned int index = usages[start]->index;
 
-    if (splitter_class_removed)
-      break;
-  }
+      for (end = start + 1;
+	   end < usages.length () && usages[end]->index == index; end++)
+	;
+
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "  processing congruence step for class: %u, "
+		 "index: %u\n", cls->id, index);
 
-  BITMAP_FREE (usage);
+      do_congruence_step_for_index (cls, index, usages, start, end);
+
+      if (splitter_class_removed)
+	break;
+    }
 }
 
 /* Adds a newly created congruence class CLS to worklist.  */
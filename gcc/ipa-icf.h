@@ -29,7 +29,8 @@ class congruence_class
 {
 public:
   /* Congruence class constructor for a new class with _ID.  */
-  congruence_class (unsigned int _id): in_worklist (false), id(_id)
+  congruence_class (unsigned int _id): in_worklist (false), id(_id),
+    index_in_group (0)
   {
   }
 
@@ -54,6 +55,9 @@ public:
 
   /* Global unique class identifier.  */
   unsigned int id;
+
+  /* Index of the class in classes vector of its congruence_class_group.  */
+  unsigned int index_in_group;
 };
 
 /* Semantic item type enum.  */
@@ -228,9 +232,6 @@ public:
   /* List of semantic items where the instance is used.  */
   vec <sem_usage_pair *> usages;
 
-  /* A bitmap with indices of all classes referencing this item.  */
-  bitmap usage_index_bitmap;
-
   /* List of tree references (either FUNC_DECL or VAR_DECL).  */
   vec <tree> tree_refs;
 
@@ -275,8 +276,7 @@ protected:
   hashval_t m_hash;
 
 private:
-  /* Initialize internal data structures. Bitmap STACK is used for
-     bitmap memory allocation process.  */
+  /* Initialize internal data structures.  */
   void setup (bitmap_obstack *stack);
 }; // class sem_item
 
@@ -331,6 +331,14 @@ public:
      paramters.  */
   bool compatible_parm_types_p (tree, tree);
 
+  /* Stream out to OB the summary of the function body that equals_wpa
+     compares, so that WPA does not need to read bodies to tell functions
+     with different shape apart.  */
+  void stream_out_body_summary (output_block *ob);
+
+  /* Read the body summary written by stream_out_body_summary from IB.  */
+  void stream_in_body_summary (lto_input_block *ib);
+
   /* Exception handling region tree.  */
   eh_region region_tree;
 
@@ -438,6 +446,21 @@ struct congruence_class_group
   hashval_t hash;
   sem_item_type type;
   vec <congruence_class *> classes;
+
+  /* Appends CLS to the classes of the group.  */
+  void add (congruence_class *cls)
+  {
+    cls->index_in_group = classes.length ();
+    classes.safe_push (cls);
+  }
+
+  /* Puts NEW_CLS in place of OLD_CLS, in constant time.  */
+  void replace (congruence_class *old_cls, congruence_class *new_cls)
+  {
+    gcc_checking_assert (classes[old_cls->index_in_group] == old_cls);
+    new_cls->index_in_group = old_cls->index_in_group;
+    classes[new_cls->index_in_group] = new_cls;
+  }
 };
 
 /* Congruence class set structure.  */
@@ -574,8 +597,11 @@ private:
   void do_congruence_step (congruence_class *cls);
 
   /* Tests if a class CLS used as INDEXth splits any congruence classes.
-     Bitmap stack BMSTACK is used for bitmap allocation.  */
-  void do_congruence_step_for_index (congruence_class *cls, unsigned int index);
+     USAGES[START] to USAGES[END - 1] are the usages of members of CLS
+     with INDEX.  Bitmap stack BMSTACK is used for bitmap allocation.  */
+  void do_congruence_step_for_index (congruence_class *cls, unsigned int index,
+				     const vec<sem_usage_pair *> &usages,
+				     unsigned int start, unsigned int end);
 
   /* Makes pairing between a congruence class CLS and semantic ITEM.  */
   static void add_item_to_class (congruence_class *cls, sem_item *item);
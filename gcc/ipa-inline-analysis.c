@@ -130,7 +130,7 @@ static void inline_edge_duplication_hook (struct cgraph_edge *,
 
 /* VECtor holding inline summaries.  
    In GGC memory because conditions might point to constant trees.  */
-function_summary <inline_summary *> *inline_summaries;
+fast_function_summary <inline_summary *, va_gc> *inline_summaries;
 vec<inline_edge_summary_t> inline_edge_summary_vec;
 
 /* Cached node/edge growths.  */
@@ -172,16 +172,17 @@ struct GTY(()) inline_summary
   int scc_no;
 };
 
-class GTY((user)) inline_summary_t: public function_summary <inline_summary *>
+class GTY((user)) inline_summary_t:
+  public fast_function_summary <inline_summary *, va_gc>
 {
 public:
-  inline_summary_t (symbol_table *symtab, bool ggc):
-    function_summary <inline_summary *> (symtab, ggc) {}
+  inline_summary_t (symbol_table *symtab):
+    fast_function_summary <inline_summary *, va_gc> (symtab) {}
 
   static inline_summary_t *create_ggc (symbol_table *symtab)
   {
     struct inline_summary_t *summary = new (ggc_cleared_alloc <inline_summary_t> ())
-      inline_summary_t(symtab, true);
+      inline_summary_t(symtab);
     summary->disable_insertion_hook ();
     return summary;
   }
@@ -193,7 +194,8 @@ public:
 			  inline_summary *src_data, inline_summary *dst_data);
 };
 
-extern GTY(()) function_summary <inline_summary *> *inline_summaries;
+extern GTY(()) fast_function_summary <inline_summary *, va_gc>
+  *inline_summaries;
 
 /* Information kept about parameter of call site.  */
 struct inline_param_summary
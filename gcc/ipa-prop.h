@@ -584,11 +584,11 @@ ipa_get_ith_polymorhic_call_context (struct ipa_edge_args *args, int i)
 }
 
 /* Function summary for ipa_node_params.  */
-class ipa_node_params_t: public function_summary <ipa_node_params *>
+class ipa_node_params_t: public fast_function_summary <ipa_node_params *>
 {
 public:
   ipa_node_params_t (symbol_table *table):
-    function_summary<ipa_node_params *> (table) { }
+    fast_function_summary<ipa_node_params *> (table) { }
 
   /* Hook that is called by summary when a node is duplicated.  */
   virtual void duplicate (cgraph_node *node,
@@ -49,6 +49,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "splay-tree.h"
 #include "ipa-utils.h"
 #include "ipa-reference.h"
+#include "params.h"
 
 static void remove_node_data (struct cgraph_node *node,
 			      void *data ATTRIBUTE_UNUSED);
@@ -76,7 +77,8 @@ struct ipa_reference_global_vars_info_d
   bitmap statics_written;
 };
 
-/* Information we save about every function after ipa-reference is completed.  */
+/* Information we save about every function after ipa-reference is completed.
+   The sets are shared between functions, see share_static_var_set.  */
 
 struct ipa_reference_optimization_summary_d
 {
@@ -114,6 +116,43 @@ static bitmap_obstack local_info_obstack;
 /* Obstack holding global analysis live forever.  */
 static bitmap_obstack optimization_summary_obstack;
 
+/* Hasher for sets of static variables, comparing them by contents.
+   bitmap_hash just xors the words of the set together, which makes the
+   many similar sets computed by the propagation collide.  */
+
+struct static_var_set_hasher : nofree_ptr_hash <bitmap_head>
+{
+  static inline hashval_t hash (const bitmap_head *set)
+  {
+    /* The sets can be large, so use a cheap multiplicative hash.  */
+    unsigned HOST_WIDE_INT h = 0;
+    for (const bitmap_element *elt = set->first; elt; elt = elt->next)
+      {
+	h = (h ^ elt->indx) * HOST_WIDE_INT_UC (0x100000001b3);
+	for (unsigned i = 0; i < BITMAP_ELEMENT_WORDS; i++)
+	  h = (h ^ elt->bits[i]) * HOST_WIDE_INT_UC (0x100000001b3);
+      }
+    return (hashval_t) (h ^ (h >> 32));
+  }
+  static inline bool equal (const bitmap_head *set1, const bitmap_head *set2)
+  {
+    return bitmap_equal_p (set1, set2);
+  }
+};
+
+/* The sets of static variables of the optimization summaries.  Many
+   functions have the same sets, so each distinct set is kept once, on
+   optimization_summary_obstack, and the sets are never modified once they
+   are in the table.  */
+static hash_table<static_var_set_hasher> *static_var_sets;
+
+/* The shared empty set, in STATIC_VAR_SETS.  */
+static bitmap empty_static_var_set;
+
+/* Likewise for the global sets computed by the propagation, which are
+   kept on local_info_obstack.  */
+static hash_table<static_var_set_hasher> *global_var_sets;
+
 /* Holders of ipa cgraph hooks: */
 static struct cgraph_2node_hook_list *node_duplication_hook_holder;
 static struct cgraph_node_hook_list *node_removal_hook_holder;
@@ -301,6 +340,64 @@ dump_static_vars_set_to_file (FILE *f, bitmap set)
       }
 }
 
+/* Create the table of shared sets of static variables.  */
+
+static void
+init_static_var_sets (void)
+{
+  static_var_sets = new hash_table<static_var_set_hasher> (511);
+  empty_static_var_set = BITMAP_ALLOC (&optimization_summary_obstack);
+  *static_var_sets->find_slot (empty_static_var_set, INSERT)
+    = empty_static_var_set;
+}
+
+/* Return the set of static variables in TABLE equal to SET and free SET
+   if it is not that set.  New sets are added to TABLE, copied to OBSTACK
+   if SET is not there already.  The maximum set is returned as is.  If
+   TABLE has PARAM_IPA_REFERENCE_MAX_SETS sets already and SET is not one
+   of them, return FALLBACK instead, which must be a conservative
+   replacement for SET.  */
+
+static bitmap
+share_static_var_set (hash_table<static_var_set_hasher> *table,
+		      bitmap_obstack *obstack, bitmap set, bitmap fallback)
+{
+  if (set == all_module_statics)
+    return set;
+
+  hashval_t hash = static_var_set_hasher::hash (set);
+  bitmap_head **slot = table->find_slot_with_hash (set, hash, NO_INSERT);
+  bitmap shared;
+  if (slot)
+    shared = *slot;
+  else if (table->elements ()
+	   >= (size_t) PARAM_VALUE (PARAM_IPA_REFERENCE_MAX_SETS))
+    shared = fallback;
+  else if (set->obstack == obstack)
+    {
+      *table->find_slot_with_hash (set, hash, INSERT) = set;
+      return set;
+    }
+  else
+    {
+      shared = BITMAP_ALLOC (obstack);
+      bitmap_copy (shared, set);
+      *table->find_slot_with_hash (shared, hash, INSERT) = shared;
+    }
+  BITMAP_FREE (set);
+  return shared;
+}
+
+/* Return the shared optimization summary set equal to SET, or the empty
+   set if there are too many sets, and free SET.  */
+
+static bitmap
+share_summary_var_set (bitmap set)
+{
+  return share_static_var_set (static_var_sets, &optimization_summary_obstack,
+			       set, empty_static_var_set);
+}
+
 /* Compute X |= Y, taking into account the possibility that
    either X or Y is already the maximum set.
    Return true if X is the maximum set after taking the union with Y.  */
@@ -348,6 +445,20 @@ copy_static_var_set (bitmap set)
   return copy;
 }
 
+/* Compute SET |= Y, where Y is a shared set, like union_static_var_sets.
+   MERGED holds the shared sets already merged into SET, which need not
+   be merged again.  */
+
+static bool
+union_shared_static_var_set (bitmap &set, bitmap y, hash_set<bitmap> &merged)
+{
+  if (set == all_module_statics)
+    return true;
+  if (bitmap_empty_p (y) || merged.add (y))
+    return false;
+  return union_static_var_sets (set, y);
+}
+
 /* Compute the union all of the statics read and written by every callee of X
    into X_GLOBAL->statics_read and X_GLOBAL->statics_written.  X_GLOBAL is
    actually the set representing the cycle containing X.  If the read and
@@ -355,7 +466,8 @@ copy_static_var_set (bitmap set)
    have to look at the remaining callees.  */
 
 static void
-propagate_bits (ipa_reference_global_vars_info_t x_global, struct cgraph_node *x)
+propagate_bits (ipa_reference_global_vars_info_t x_global, struct cgraph_node *x,
+		hash_set<bitmap> &merged_read, hash_set<bitmap> &merged_written)
 {
   struct cgraph_edge *e;
   bool read_all = x_global->statics_read == all_module_statics;
@@ -391,8 +503,9 @@ propagate_bits (ipa_reference_global_vars_info_t x_global, struct cgraph_node *x
 	      if (flags & ECF_CONST)
 		continue;
 
-	      union_static_var_sets (x_global->statics_read,
-				     y_global->statics_read);
+	      read_all = union_shared_static_var_set (x_global->statics_read,
+						      y_global->statics_read,
+						      merged_read);
 
 	      /* If the function is pure, it has no stores even if it
 		 seems so to local analysis.  If we cannot return from
@@ -401,8 +514,10 @@ propagate_bits (ipa_reference_global_vars_info_t x_global, struct cgraph_node *x
 		  || e->cannot_lead_to_return_p ())
 		continue;
 
-	      union_static_var_sets (x_global->statics_written,
-				     y_global->statics_written);
+	      write_all
+		= union_shared_static_var_set (x_global->statics_written,
+					       y_global->statics_written,
+					       merged_written);
 	    }
 	  else
 	    gcc_unreachable ();
@@ -429,6 +544,7 @@ ipa_init (void)
   bitmap_obstack_initialize (&optimization_summary_obstack);
   all_module_statics = BITMAP_ALLOC (&optimization_summary_obstack);
   ignore_module_statics = BITMAP_ALLOC (&optimization_summary_obstack);
+  init_static_var_sets ();
 
   node_removal_hook_holder =
       symtab->add_cgraph_removal_hook (&remove_node_data, NULL);
@@ -522,10 +638,8 @@ duplicate_node_data (struct cgraph_node *src, struct cgraph_node *dst,
     return;
   dst_ginfo = XCNEW (struct ipa_reference_optimization_summary_d);
   set_reference_optimization_summary (dst, dst_ginfo);
-  dst_ginfo->statics_not_read =
-    copy_static_var_set (ginfo->statics_not_read);
-  dst_ginfo->statics_not_written =
-    copy_static_var_set (ginfo->statics_not_written);
+  dst_ginfo->statics_not_read = ginfo->statics_not_read;
+  dst_ginfo->statics_not_written = ginfo->statics_not_written;
 }
 
 /* Called when node is removed.  */
@@ -537,13 +651,7 @@ remove_node_data (struct cgraph_node *node, void *data ATTRIBUTE_UNUSED)
   ginfo = get_reference_optimization_summary (node);
   if (ginfo)
     {
-      if (ginfo->statics_not_read
-	  && ginfo->statics_not_read != all_module_statics)
-	BITMAP_FREE (ginfo->statics_not_read);
-
-      if (ginfo->statics_not_written
-	  && ginfo->statics_not_written != all_module_statics)
-	BITMAP_FREE (ginfo->statics_not_written);
+      /* The sets are shared and stay around.  */
       free (ginfo);
       set_reference_optimization_summary (node, NULL);
     }
@@ -734,6 +842,8 @@ propagate (void)
   if (dump_file)
     ipa_print_order (dump_file, "reduced", order, order_pos);
 
+  global_var_sets = new hash_table<static_var_set_hasher> (511);
+
   for (i = 0; i < order_pos; i++ )
     {
       unsigned x;
@@ -782,6 +892,7 @@ propagate (void)
 
       /* Merge the sets of this cycle with all sets of callees reached
          from this cycle.  */
+      hash_set<bitmap> merged_read, merged_written;
       FOR_EACH_VEC_ELT (cycle_nodes, x, w)
 	{
 	  if (read_all && write_all)
@@ -802,9 +913,19 @@ propagate (void)
 						   w_l->statics_written);
 	    }
 
-	  propagate_bits (node_g, w);
+	  propagate_bits (node_g, w, merged_read, merged_written);
 	}
 
+      /* Callers merge the sets of the cycle into theirs, so share them;
+	 when there are too many sets, assume the cycle accesses all
+	 statics.  */
+      node_g->statics_read
+	= share_static_var_set (global_var_sets, &local_info_obstack,
+				node_g->statics_read, all_module_statics);
+      node_g->statics_written
+	= share_static_var_set (global_var_sets, &local_info_obstack,
+				node_g->statics_written, all_module_statics);
+
       /* All nodes within a cycle have the same global info bitmaps.  */
       FOR_EACH_VEC_ELT (cycle_nodes, x, w)
 	{
@@ -877,26 +998,25 @@ propagate (void)
 
 	  if (bitmap_empty_p (node_g->statics_read))
 	    opt->statics_not_read = all_module_statics;
+	  else if (node_g->statics_read == all_module_statics)
+	    opt->statics_not_read = empty_static_var_set;
 	  else
 	    {
-	      opt->statics_not_read
-		 = BITMAP_ALLOC (&optimization_summary_obstack);
-	      if (node_g->statics_read != all_module_statics)
-		bitmap_and_compl (opt->statics_not_read,
-				  all_module_statics,
-				  node_g->statics_read);
+	      bitmap set = BITMAP_ALLOC (&optimization_summary_obstack);
+	      bitmap_and_compl (set, all_module_statics, node_g->statics_read);
+	      opt->statics_not_read = share_summary_var_set (set);
 	    }
 
 	  if (bitmap_empty_p (node_g->statics_written))
 	    opt->statics_not_written = all_module_statics;
+	  else if (node_g->statics_written == all_module_statics)
+	    opt->statics_not_written = empty_static_var_set;
 	  else
 	    {
-	      opt->statics_not_written
-	        = BITMAP_ALLOC (&optimization_summary_obstack);
-	      if (node_g->statics_written != all_module_statics)
-		bitmap_and_compl (opt->statics_not_written,
-				  all_module_statics,
-				  node_g->statics_written);
+	      bitmap set = BITMAP_ALLOC (&optimization_summary_obstack);
+	      bitmap_and_compl (set, all_module_statics,
+				node_g->statics_written);
+	      opt->statics_not_written = share_summary_var_set (set);
 	    }
 	}
       free (node_info);
@@ -905,6 +1025,8 @@ propagate (void)
   ipa_free_postorder_info ();
   free (order);
 
+  delete global_var_sets;
+  global_var_sets = NULL;
   bitmap_obstack_release (&local_info_obstack);
   ipa_reference_vars_vector.release ();
   if (dump_file)
@@ -982,7 +1104,43 @@ stream_out_bitmap (struct lto_simple_output_block *ob,
     }
 }
 
-/* Serialize the ipa info for lto.  */
+/* Return the index under which the set BITS&LTRANS_STATICS is streamed,
+   or -1 if it is the maximum set, given that LTRANS_STATICS has
+   LTRANS_STATICS_BITCOUNT bits.  The sets to stream are pushed to SETS
+   and their indices recorded in SET_IDS, so that each shared set is
+   streamed once.  */
+
+static int
+static_var_set_id (bitmap bits, bitmap ltrans_statics,
+		   int ltrans_statics_bitcount,
+		   hash_map<bitmap, int> &set_ids, vec<bitmap> &sets)
+{
+  if (bits == all_module_statics)
+    return -1;
+
+  bool existed;
+  int &id = set_ids.get_or_insert (bits, &existed);
+  if (!existed)
+    {
+      int count = 0;
+      unsigned int index;
+      bitmap_iterator bi;
+      EXECUTE_IF_AND_IN_BITMAP (bits, ltrans_statics, 0, index, bi)
+	count ++;
+      if (count == ltrans_statics_bitcount)
+	id = -1;
+      else
+	{
+	  id = sets.length ();
+	  sets.safe_push (bits);
+	}
+    }
+  return id;
+}
+
+/* Serialize the ipa info for lto.  The sets of the functions are shared,
+   so the distinct sets are streamed first and each function refers to
+   its sets by their index.  */
 
 static void
 ipa_reference_write_optimization_summary (void)
@@ -993,6 +1151,8 @@ ipa_reference_write_optimization_summary (void)
   int ltrans_statics_bitcount = 0;
   lto_symtab_encoder_t encoder = ob->decl_state->symtab_node_encoder;
   bitmap ltrans_statics = BITMAP_ALLOC (NULL);
+  hash_map<bitmap, int> set_ids;
+  auto_vec<bitmap> sets;
   int i;
 
   reference_vars_to_consider = splay_tree_new (splay_tree_compare_ints, 0, 0);
@@ -1023,13 +1183,28 @@ ipa_reference_write_optimization_summary (void)
 	symtab_node *snode = lto_symtab_encoder_deref (encoder, i);
 	cgraph_node *cnode = dyn_cast <cgraph_node *> (snode);
 	if (cnode && write_node_summary_p (cnode, encoder, ltrans_statics))
-	  count++;
+	  {
+	    ipa_reference_optimization_summary_t info
+	      = get_reference_optimization_summary (cnode);
+	    static_var_set_id (info->statics_not_read, ltrans_statics,
+			       ltrans_statics_bitcount, set_ids, sets);
+	    static_var_set_id (info->statics_not_written, ltrans_statics,
+			       ltrans_statics_bitcount, set_ids, sets);
+	    count++;
+	  }
       }
 
   streamer_write_uhwi_stream (ob->main_stream, count);
   if (count)
-    stream_out_bitmap (ob, ltrans_statics, ltrans_statics,
-		       -1);
+    {
+      bitmap set;
+
+      stream_out_bitmap (ob, ltrans_statics, ltrans_statics,
+			 -1);
+      streamer_write_uhwi_stream (ob->main_stream, sets.length ());
+      FOR_EACH_VEC_ELT (sets, i, set)
+	stream_out_bitmap (ob, set, ltrans_statics, -1);
+    }
 
   /* Process all of the functions.  */
   if (ltrans_statics_bitcount)
@@ -1046,10 +1221,14 @@ ipa_reference_write_optimization_summary (void)
 	    node_ref = lto_symtab_encoder_encode (encoder, snode);
 	    streamer_write_uhwi_stream (ob->main_stream, node_ref);
 
-	    stream_out_bitmap (ob, info->statics_not_read, ltrans_statics,
-			       ltrans_statics_bitcount);
-	    stream_out_bitmap (ob, info->statics_not_written, ltrans_statics,
-			       ltrans_statics_bitcount);
+	    streamer_write_hwi_stream
+	      (ob->main_stream,
+	       static_var_set_id (info->statics_not_read, ltrans_statics,
+				  ltrans_statics_bitcount, set_ids, sets));
+	    streamer_write_hwi_stream
+	      (ob->main_stream,
+	       static_var_set_id (info->statics_not_written, ltrans_statics,
+				  ltrans_statics_bitcount, set_ids, sets));
 	  }
       }
   BITMAP_FREE (ltrans_statics);
@@ -1067,6 +1246,7 @@ ipa_reference_read_optimization_summary (void)
   struct lto_file_decl_data * file_data;
   unsigned int j = 0;
   bitmap_obstack_initialize (&optimization_summary_obstack);
+  init_static_var_sets ();
 
   node_removal_hook_holder =
       symtab->add_cgraph_removal_hook (&remove_node_data, NULL);
@@ -1087,6 +1267,8 @@ ipa_reference_read_optimization_summary (void)
 	  unsigned int i;
 	  unsigned int f_count = streamer_read_uhwi (ib);
 	  int b_count;
+	  unsigned int s_count;
+	  auto_vec<bitmap> sets;
 	  if (!f_count)
 	    continue;
 	  b_count = streamer_read_hwi (ib);
@@ -1103,12 +1285,33 @@ ipa_reference_read_optimization_summary (void)
 		fprintf (dump_file, " %s", fndecl_name (v_decl));
 	    }
 
+	  /* Read the sets the functions refer to.  */
+	  s_count = streamer_read_uhwi (ib);
+	  sets.reserve_exact (s_count);
+	  for (i = 0; i < s_count; i++)
+	    {
+	      bitmap set = BITMAP_ALLOC (&optimization_summary_obstack);
+	      int v_count = streamer_read_hwi (ib);
+	      if (dump_file)
+		fprintf (dump_file, "\nset %u:", i);
+	      for (int k = 0; k < v_count; k++)
+		{
+		  unsigned int var_index = streamer_read_uhwi (ib);
+		  tree v_decl = lto_file_decl_data_get_var_decl (file_data,
+								 var_index);
+		  bitmap_set_bit (set, ipa_reference_var_uid (v_decl));
+		  if (dump_file)
+		    fprintf (dump_file, " %s", fndecl_name (v_decl));
+		}
+	      sets.quick_push (share_summary_var_set (set));
+	    }
+
 	  for (i = 0; i < f_count; i++)
 	    {
-	      unsigned int j, index;
+	      unsigned int index;
 	      struct cgraph_node *node;
 	      ipa_reference_optimization_summary_t info;
-	      int v_count;
+	      int not_read, not_written;
 	      lto_symtab_encoder_t encoder;
 
 	      index = streamer_read_uhwi (ib);
@@ -1117,57 +1320,31 @@ ipa_reference_read_optimization_summary (void)
 		(encoder, index));
 	      info = XCNEW (struct ipa_reference_optimization_summary_d);
 	      set_reference_optimization_summary (node, info);
-	      info->statics_not_read = BITMAP_ALLOC (&optimization_summary_obstack);
-	      info->statics_not_written = BITMAP_ALLOC (&optimization_summary_obstack);
-	      if (dump_file)
-		fprintf (dump_file,
-			 "\nFunction name:%s/%i:\n  static not read:",
-			 node->asm_name (), node->order);
-
-	      /* Set the statics not read.  */
-	      v_count = streamer_read_hwi (ib);
-	      if (v_count == -1)
-		{
-		  info->statics_not_read = all_module_statics;
-		  if (dump_file)
-		    fprintf (dump_file, " all module statics");
-		}
-	      else
-		for (j = 0; j < (unsigned int)v_count; j++)
-		  {
-		    unsigned int var_index = streamer_read_uhwi (ib);
-		    tree v_decl = lto_file_decl_data_get_var_decl (file_data,
-								   var_index);
-		    bitmap_set_bit (info->statics_not_read,
-				    ipa_reference_var_uid (v_decl));
-		    if (dump_file)
-		      fprintf (dump_file, " %s", fndecl_name (v_decl));
-		  }
 
+	      /* Set the statics not read and not written.  */
+	      not_read = streamer_read_hwi (ib);
+	      not_written = streamer_read_hwi (ib);
+	      info->statics_not_read
+		= not_read == -1 ? all_module_statics : sets[not_read];
+	      info->statics_not_written
+		= not_written == -1 ? all_module_statics : sets[not_written];
 	      if (dump_file)
-		fprintf (dump_file,
-			 "\n  static not written:");
-	      /* Set the statics not written.  */
-	      v_count = streamer_read_hwi (ib);
-	      if (v_count == -1)
 		{
-		  info->statics_not_written = all_module_statics;
-		  if (dump_file)
-		    fprintf (dump_file, " all module statics");
+		  fprintf (dump_file, "\nFunction name:%s/%i:\n",
+			   node->asm_name (), node->order);
+		  if (not_read == -1)
+		    fprintf (dump_file,
+			     "  static not read: all module statics\n");
+		  else
+		    fprintf (dump_file, "  static not read: set %i\n",
+			     not_read);
+		  if (not_written == -1)
+		    fprintf (dump_file,
+			     "  static not written: all module statics\n");
+		  else
+		    fprintf (dump_file, "  static not written: set %i\n",
+			     not_written);
 		}
-	      else
-		for (j = 0; j < (unsigned int)v_count; j++)
-		  {
-		    unsigned int var_index = streamer_read_uhwi (ib);
-		    tree v_decl = lto_file_decl_data_get_var_decl (file_data,
-								   var_index);
-		    bitmap_set_bit (info->statics_not_written,
-				    ipa_reference_var_uid (v_decl));
-		    if (dump_file)
-		      fprintf (dump_file, " %s", fndecl_name (v_decl));
-		  }
-	      if (dump_file)
-		fprintf (dump_file, "\n");
 	    }
 
 	  lto_destroy_simple_input_block (file_data,
@@ -1248,6 +1425,10 @@ ipa_reference_c_finalize (void)
       ipa_init_p = false;
     }
 
+  delete static_var_sets;
+  static_var_sets = NULL;
+  empty_static_var_set = NULL;
+
   if (node_removal_hook_holder)
     {
       symtab->remove_cgraph_removal_hook (node_removal_hook_holder);
@@ -34,6 +34,7 @@ along with GCC; see the file COPYING3.  If not see
 #include <zlib.h>
 #include "lto-compress.h"
 #include "timevar.h"
+#include "selftest.h"
 
 /* Compression stream structure, holds the flush callback and opaque token,
    the buffered data, and a note of whether compressing or uncompressing.  */
@@ -163,23 +164,19 @@ lto_compress_block (struct lto_compression_stream *stream,
   lto_stats.num_output_il_bytes += num_chars;
 }
 
-/* Finalize STREAM compression, and free stream allocations.  */
+/* Compress the data buffered in STREAM with zlib, passing the result to
+   the stream callback.  */
 
-void
-lto_end_compression (struct lto_compression_stream *stream)
+static void
+lto_zlib_compress (struct lto_compression_stream *stream)
 {
   unsigned char *cursor = (unsigned char *) stream->buffer;
   size_t remaining = stream->bytes;
   const size_t outbuf_length = Z_BUFFER_LENGTH;
   unsigned char *outbuf = (unsigned char *) xmalloc (outbuf_length);
   z_stream out_stream;
-  size_t compressed_bytes = 0;
   int status;
 
-  gcc_assert (stream->is_compression);
-
-  timevar_push (TV_IPA_LTO_COMPRESS);
-
   out_stream.next_out = outbuf;
   out_stream.avail_out = outbuf_length;
   out_stream.next_in = cursor;
@@ -205,7 +202,6 @@ lto_end_compression (struct lto_compression_stream *stream)
 
       stream->callback ((const char *) outbuf, out_bytes, stream->opaque);
       lto_stats.num_compressed_il_bytes += out_bytes;
-      compressed_bytes += out_bytes;
 
       cursor += in_bytes;
       remaining -= in_bytes;
@@ -221,8 +217,390 @@ lto_end_compression (struct lto_compression_stream *stream)
   if (status != Z_OK)
     internal_error ("compressed stream: %s", zError (status));
 
-  lto_destroy_compression_stream (stream);
   free (outbuf);
+}
+
+/* Return true if the REMAINING bytes at CURSOR start with a zlib stream
+   header.  */
+
+static bool
+lto_zlib_match_p (const unsigned char *cursor, size_t remaining)
+{
+  return (remaining >= 2
+	  && (cursor[0] & 0x0f) == Z_DEFLATED
+	  && ((cursor[0] << 8) | cursor[1]) % 31 == 0);
+}
+
+/* Inflate the zlib stream at the start of the REMAINING bytes at CURSOR,
+   passing the uncompressed data to CALLBACK along with OPAQUE.  Store the
+   number of bytes of the stream in *CONSUMED and add the number of bytes
+   produced to *UNCOMPRESSED_BYTES.  Return NULL on success and an error
+   message otherwise.  */
+
+static const char *
+lto_zlib_uncompress (const unsigned char *cursor, size_t remaining,
+		     void (*callback) (const char *, unsigned, void *),
+		     void *opaque, size_t *consumed,
+		     size_t *uncompressed_bytes)
+{
+  const size_t outbuf_length = Z_BUFFER_LENGTH;
+  unsigned char *outbuf = (unsigned char *) xmalloc (outbuf_length);
+  const size_t len = remaining;
+  z_stream in_stream;
+  size_t out_bytes;
+  int status;
+
+  in_stream.next_out = outbuf;
+  in_stream.avail_out = outbuf_length;
+  in_stream.next_in = CONST_CAST (unsigned char *, cursor);
+  in_stream.avail_in = remaining;
+  in_stream.zalloc = lto_zalloc;
+  in_stream.zfree = lto_zfree;
+  in_stream.opaque = Z_NULL;
+
+  status = inflateInit (&in_stream);
+  if (status != Z_OK)
+    {
+      free (outbuf);
+      return zError (status);
+    }
+
+  do
+    {
+      size_t in_bytes;
+
+      status = inflate (&in_stream, Z_SYNC_FLUSH);
+      if (status != Z_OK && status != Z_STREAM_END)
+	{
+	  inflateEnd (&in_stream);
+	  free (outbuf);
+	  return zError (status);
+	}
+
+      in_bytes = remaining - in_stream.avail_in;
+      out_bytes = outbuf_length - in_stream.avail_out;
+
+      callback ((const char *) outbuf, out_bytes, opaque);
+      *uncompressed_bytes += out_bytes;
+
+      cursor += in_bytes;
+      remaining -= in_bytes;
+
+      in_stream.next_out = outbuf;
+      in_stream.avail_out = outbuf_length;
+      in_stream.next_in = CONST_CAST (unsigned char *, cursor);
+      in_stream.avail_in = remaining;
+    }
+  while (!(status == Z_STREAM_END && out_bytes == 0));
+
+  status = inflateEnd (&in_stream);
+  free (outbuf);
+  if (status != Z_OK)
+    return zError (status);
+
+  *consumed = len - remaining;
+  return NULL;
+}
+
+/* The "lz" algorithm is a byte-oriented LZ77 variant in the style of LZ4,
+   which trades compression ratio for speed.  Each segment is
+
+     "GCLZ"          magic, which cannot start a zlib stream
+     8 bytes         little-endian uncompressed size
+     8 bytes         little-endian compressed size, excluding this header
+     sequences
+
+   A sequence is a token byte whose high and low nibbles hold the number
+   of literal bytes and the length of the match minus LZ_MIN_MATCH, then
+   the rest of the literal length if its nibble is 15, the literal bytes,
+   a 2-byte little-endian match offset and the rest of the match length
+   if its nibble is 15.  The lengths continue in bytes that are added
+   until one is below 255.  The last sequence has no match; it ends at the
+   end of the segment.  */
+
+static const unsigned char lz_magic[4] = { 'G', 'C', 'L', 'Z' };
+static const size_t LZ_HEADER_LENGTH = 4 + 8 + 8;
+static const size_t LZ_MIN_MATCH = 4;
+static const size_t LZ_MAX_OFFSET = 65535;
+static const unsigned LZ_HASH_BITS = 16;
+
+/* Store the 64-bit VALUE at P in little-endian order.  */
+
+static void
+lz_put_size (unsigned char *p, uint64_t value)
+{
+  for (unsigned i = 0; i < 8; i++)
+    p[i] = (unsigned char) (value >> (8 * i));
+}
+
+/* Return the 64-bit little-endian value at P.  */
+
+static uint64_t
+lz_get_size (const unsigned char *p)
+{
+  uint64_t value = 0;
+  for (unsigned i = 0; i < 8; i++)
+    value |= (uint64_t) p[i] << (8 * i);
+  return value;
+}
+
+/* Return the 4 bytes at P as an integer.  */
+
+static inline uint32_t
+lz_read32 (const unsigned char *p)
+{
+  uint32_t value;
+  memcpy (&value, p, sizeof (value));
+  return value;
+}
+
+/* Write at OP the continuation bytes of a length LEN whose nibble was 15,
+   and return the position after them.  */
+
+static inline unsigned char *
+lz_put_length (unsigned char *op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = (unsigned char) len;
+  return op;
+}
+
+/* Write at OP the sequence made of the NLIT literal bytes at LIT followed
+   by a match of MLEN bytes at OFFSET, or by no match if MLEN is zero.
+   Return the position after the sequence.  */
+
+static unsigned char *
+lz_put_sequence (unsigned char *op, const unsigned char *lit, size_t nlit,
+		 size_t offset, size_t mlen)
+{
+  unsigned char *token = op++;
+  size_t mcode = mlen ? mlen - LZ_MIN_MATCH : 0;
+
+  *token = (MIN (nlit, 15) << 4) | MIN (mcode, 15);
+  if (nlit >= 15)
+    op = lz_put_length (op, nlit - 15);
+  memcpy (op, lit, nlit);
+  op += nlit;
+
+  if (mlen)
+    {
+      *op++ = offset & 0xff;
+      *op++ = offset >> 8;
+      if (mcode >= 15)
+	op = lz_put_length (op, mcode - 15);
+    }
+  return op;
+}
+
+/* Compress the data buffered in STREAM with the "lz" algorithm, passing
+   the result to the stream callback.  */
+
+static void
+lto_lz_compress (struct lto_compression_stream *stream)
+{
+  const unsigned char *in = (const unsigned char *) stream->buffer;
+  const size_t len = stream->bytes;
+  /* The worst case is all literals.  */
+  unsigned char *out
+    = XNEWVEC (unsigned char, LZ_HEADER_LENGTH + len + len / 255 + 16);
+  unsigned char *op = out + LZ_HEADER_LENGTH;
+  /* The last position at which each hash of 4 bytes was seen, plus one.  */
+  uint32_t *table = XCNEWVEC (uint32_t, 1 << LZ_HASH_BITS);
+  size_t ip = 0, anchor = 0;
+
+  while (ip + LZ_MIN_MATCH <= len)
+    {
+      uint32_t seq = lz_read32 (in + ip);
+      uint32_t hash = (seq * 2654435761U) >> (32 - LZ_HASH_BITS);
+      size_t ref = table[hash];
+
+      table[hash] = ip + 1;
+      if (ref-- == 0
+	  || ip - ref > LZ_MAX_OFFSET
+	  || lz_read32 (in + ref) != seq)
+	{
+	  /* Skip faster through data that does not compress.  */
+	  ip += 1 + ((ip - anchor) >> 6);
+	  continue;
+	}
+
+      size_t mlen = LZ_MIN_MATCH;
+      while (ip + mlen < len && in[ref + mlen] == in[ip + mlen])
+	mlen++;
+
+      op = lz_put_sequence (op, in + anchor, ip - anchor, ip - ref, mlen);
+      ip += mlen;
+      anchor = ip;
+    }
+  op = lz_put_sequence (op, in + anchor, len - anchor, 0, 0);
+
+  memcpy (out, lz_magic, sizeof (lz_magic));
+  lz_put_size (out + 4, len);
+  lz_put_size (out + 12, op - out - LZ_HEADER_LENGTH);
+
+  /* The callback takes an unsigned length.  */
+  for (unsigned char *p = out; p < op; p += UINT_MAX)
+    stream->callback ((const char *) p, MIN ((size_t) (op - p), UINT_MAX),
+		      stream->opaque);
+  lto_stats.num_compressed_il_bytes += op - out;
+
+  free (table);
+  free (out);
+}
+
+/* Read at *IP, before END, the continuation bytes of a length whose
+   nibble was 15 and add them to *LEN.  Return false if the data ends
+   first.  */
+
+static inline bool
+lz_get_length (const unsigned char **ip, const unsigned char *end,
+	       size_t *len)
+{
+  unsigned char byte;
+
+  do
+    {
+      if (*ip >= end)
+	return false;
+      byte = *(*ip)++;
+      *len += byte;
+    }
+  while (byte == 255);
+  return true;
+}
+
+/* Return true if the REMAINING bytes at CURSOR start with a segment
+   compressed with the "lz" algorithm.  */
+
+static bool
+lto_lz_match_p (const unsigned char *cursor, size_t remaining)
+{
+  return (remaining >= LZ_HEADER_LENGTH
+	  && memcmp (cursor, lz_magic, sizeof (lz_magic)) == 0);
+}
+
+/* Uncompress the segment compressed with the "lz" algorithm at the start
+   of the REMAINING bytes at CURSOR, with the interface of
+   lto_zlib_uncompress.  */
+
+static const char *
+lto_lz_uncompress (const unsigned char *cursor, size_t remaining,
+		   void (*callback) (const char *, unsigned, void *),
+		   void *opaque, size_t *consumed,
+		   size_t *uncompressed_bytes)
+{
+  const char *corrupt = "corrupt lz data";
+  uint64_t out_len = lz_get_size (cursor + 4);
+  uint64_t in_len = lz_get_size (cursor + 12);
+
+  if (in_len > remaining - LZ_HEADER_LENGTH
+      || out_len > ((uint64_t) in_len + 1) * 255 * 16
+      || out_len != (size_t) out_len)
+    return corrupt;
+
+  const unsigned char *ip = cursor + LZ_HEADER_LENGTH;
+  const unsigned char *end = ip + in_len;
+  unsigned char *out = XNEWVEC (unsigned char, MAX (out_len, 1));
+  unsigned char *op = out;
+  unsigned char *out_end = out + out_len;
+
+  while (true)
+    {
+      if (ip >= end)
+	goto fail;
+
+      unsigned token = *ip++;
+      size_t nlit = token >> 4;
+      size_t mlen = token & 15;
+
+      if (nlit == 15 && !lz_get_length (&ip, end, &nlit))
+	goto fail;
+      if (nlit > (size_t) (end - ip) || nlit > (size_t) (out_end - op))
+	goto fail;
+      memcpy (op, ip, nlit);
+      ip += nlit;
+      op += nlit;
+
+      /* The last sequence has no match.  */
+      if (ip == end)
+	break;
+
+      if (end - ip < 2)
+	goto fail;
+      size_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (mlen == 15 && !lz_get_length (&ip, end, &mlen))
+	goto fail;
+      mlen += LZ_MIN_MATCH;
+      if (offset == 0
+	  || offset > (size_t) (op - out)
+	  || mlen > (size_t) (out_end - op))
+	goto fail;
+
+      const unsigned char *ref = op - offset;
+      if (offset >= mlen)
+	memcpy (op, ref, mlen);
+      else
+	/* The match overlaps the bytes it produces.  */
+	for (size_t i = 0; i < mlen; i++)
+	  op[i] = ref[i];
+      op += mlen;
+    }
+
+  if (op != out_end)
+    goto fail;
+
+  for (unsigned char *p = out; p < op; p += UINT_MAX)
+    callback ((const char *) p, MIN ((size_t) (op - p), UINT_MAX), opaque);
+  *uncompressed_bytes += out_len;
+  *consumed = LZ_HEADER_LENGTH + in_len;
+  free (out);
+  return NULL;
+
+ fail:
+  free (out);
+  return corrupt;
+}
+
+/* A compression algorithm.  */
+
+struct lto_codec
+{
+  /* Compress the data buffered in a stream, passing the result to the
+     stream callback.  */
+  void (*compress) (struct lto_compression_stream *);
+
+  /* Return true if the data starts with a segment compressed by this
+     codec.  */
+  bool (*match_p) (const unsigned char *, size_t);
+
+  /* Uncompress such a segment.  */
+  const char *(*uncompress) (const unsigned char *, size_t,
+			     void (*) (const char *, unsigned, void *),
+			     void *, size_t *, size_t *);
+};
+
+/* The codecs, indexed by enum lto_compression_algorithm.  */
+
+static const struct lto_codec lto_codecs[] =
+{
+  { lto_zlib_compress, lto_zlib_match_p, lto_zlib_uncompress },
+  { lto_lz_compress, lto_lz_match_p, lto_lz_uncompress }
+};
+
+/* Finalize STREAM compression, and free stream allocations.  */
+
+void
+lto_end_compression (struct lto_compression_stream *stream)
+{
+  gcc_assert (stream->is_compression);
+  gcc_checking_assert ((unsigned) flag_lto_compression_algorithm
+		       < ARRAY_SIZE (lto_codecs));
+
+  timevar_push (TV_IPA_LTO_COMPRESS);
+  lto_codecs[flag_lto_compression_algorithm].compress (stream);
+  lto_destroy_compression_stream (stream);
   timevar_pop (TV_IPA_LTO_COMPRESS);
 }
 
@@ -248,73 +626,258 @@ lto_uncompress_block (struct lto_compression_stream *stream,
   lto_stats.num_input_il_bytes += num_chars;
 }
 
-/* Finalize STREAM uncompression, and free stream allocations.
+/* Uncompress the REMAINING bytes at CURSOR, passing the uncompressed data
+   to CALLBACK along with OPAQUE, and add its size to *UNCOMPRESSED_BYTES.
 
    Because of the way LTO IL streams are compressed, there may be several
-   concatenated compressed segments in the accumulated data, so for this
-   function we iterate decompressions until no data remains.  */
+   concatenated compressed segments in the data, possibly compressed by
+   different codecs, so we iterate decompressions until no data remains.
+   Return NULL on success and an error message otherwise.  */
+
+static const char *
+lto_uncompress_segments (const unsigned char *cursor, size_t remaining,
+			 void (*callback) (const char *, unsigned, void *),
+			 void *opaque, size_t *uncompressed_bytes)
+{
+  while (remaining > 0)
+    {
+      const struct lto_codec *codec = NULL;
+      size_t consumed = 0;
+      const char *msg;
+
+      for (unsigned i = 0; i < ARRAY_SIZE (lto_codecs); i++)
+	if (lto_codecs[i].match_p (cursor, remaining))
+	  {
+	    codec = &lto_codecs[i];
+	    break;
+	  }
+      if (!codec)
+	return "unknown compression format";
+
+      msg = codec->uncompress (cursor, remaining, callback, opaque,
+			       &consumed, uncompressed_bytes);
+      if (msg)
+	return msg;
+
+      cursor += consumed;
+      remaining -= consumed;
+    }
+
+  return NULL;
+}
+
+/* Finalize STREAM uncompression, and free stream allocations.  */
 
 void
 lto_end_uncompression (struct lto_compression_stream *stream)
 {
-  unsigned char *cursor = (unsigned char *) stream->buffer;
-  size_t remaining = stream->bytes;
-  const size_t outbuf_length = Z_BUFFER_LENGTH;
-  unsigned char *outbuf = (unsigned char *) xmalloc (outbuf_length);
   size_t uncompressed_bytes = 0;
+  const char *msg;
 
   gcc_assert (!stream->is_compression);
   timevar_push (TV_IPA_LTO_DECOMPRESS);
 
-  while (remaining > 0)
+  msg = lto_uncompress_segments ((const unsigned char *) stream->buffer,
+				 stream->bytes, stream->callback,
+				 stream->opaque, &uncompressed_bytes);
+  if (msg)
+    internal_error ("compressed stream: %s", msg);
+  lto_stats.num_uncompressed_il_bytes += uncompressed_bytes;
+
+  lto_destroy_compression_stream (stream);
+  timevar_pop (TV_IPA_LTO_DECOMPRESS);
+}
+
+/* Growing output buffer for lto_uncompress_buffer.  */
+
+struct lto_uncompress_buffer_data
+{
+  char *data;
+  size_t length;
+  size_t allocation;
+};
+
+/* Append NUM_CHARS from BASE to the lto_uncompress_buffer_data OPAQUE.  */
+
+static void
+lto_append_to_uncompress_buffer (const char *base, unsigned num_chars,
+				 void *opaque)
+{
+  struct lto_uncompress_buffer_data *buffer
+    = (struct lto_uncompress_buffer_data *) opaque;
+  size_t required = buffer->length + num_chars;
+
+  if (buffer->allocation < required)
     {
-      z_stream in_stream;
-      size_t out_bytes;
-      int status;
+      while (buffer->allocation < required)
+	buffer->allocation *= 2;
+      buffer->data = (char *) xrealloc (buffer->data, buffer->allocation);
+    }
 
-      in_stream.next_out = outbuf;
-      in_stream.avail_out = outbuf_length;
-      in_stream.next_in = cursor;
-      in_stream.avail_in = remaining;
-      in_stream.zalloc = lto_zalloc;
-      in_stream.zfree = lto_zfree;
-      in_stream.opaque = Z_NULL;
+  memcpy (buffer->data + buffer->length, base, num_chars);
+  buffer->length += num_chars;
+}
 
-      status = inflateInit (&in_stream);
-      if (status != Z_OK)
-	internal_error ("compressed stream: %s", zError (status));
+/* Uncompress the LEN bytes at DATA into a new buffer allocated with
+   xmalloc and store the length of the result in *OUT_LEN.  Return NULL
+   if DATA is corrupt.
 
-      do
-	{
-	  size_t in_bytes;
+   Unlike the stream interface above, this neither updates lto_stats nor
+   pushes timevars, and it does not report errors itself, so helper
+   threads may use it.  The caller accounts for the data instead.  */
 
-	  status = inflate (&in_stream, Z_SYNC_FLUSH);
-	  if (status != Z_OK && status != Z_STREAM_END)
-	    internal_error ("compressed stream: %s", zError (status));
+char *
+lto_uncompress_buffer (const char *data, size_t len, size_t *out_len)
+{
+  struct lto_uncompress_buffer_data buffer;
+  size_t uncompressed_bytes = 0;
 
-	  in_bytes = remaining - in_stream.avail_in;
-	  out_bytes = outbuf_length - in_stream.avail_out;
+  /* LTO IL typically compresses 3 to 5 times.  */
+  buffer.allocation = MAX (4 * len, MIN_STREAM_ALLOCATION);
+  buffer.data = (char *) xmalloc (buffer.allocation);
+  buffer.length = 0;
 
-	  stream->callback ((const char *) outbuf, out_bytes, stream->opaque);
-	  lto_stats.num_uncompressed_il_bytes += out_bytes;
-	  uncompressed_bytes += out_bytes;
+  if (lto_uncompress_segments ((const unsigned char *) data, len,
+			       lto_append_to_uncompress_buffer, &buffer,
+			       &uncompressed_bytes))
+    {
+      free (buffer.data);
+      return NULL;
+    }
+
+  *out_len = buffer.length;
+  return buffer.data;
+}
 
-	  cursor += in_bytes;
-	  remaining -= in_bytes;
+#if CHECKING_P
 
-	  in_stream.next_out = outbuf;
-	  in_stream.avail_out = outbuf_length;
-	  in_stream.next_in = cursor;
-	  in_stream.avail_in = remaining;
-	}
-      while (!(status == Z_STREAM_END && out_bytes == 0));
+namespace selftest {
 
-      status = inflateEnd (&in_stream);
-      if (status != Z_OK)
-	internal_error ("compressed stream: %s", zError (status));
+/* Append NUM_CHARS from BASE to the auto_vec<char> OPAQUE.  */
+
+static void
+append_to_vec (const char *base, unsigned num_chars, void *opaque)
+{
+  auto_vec<char> *v = (auto_vec<char> *) opaque;
+  for (unsigned i = 0; i < num_chars; i++)
+    v->safe_push (base[i]);
+}
+
+/* Append to COMPRESSED the LEN bytes at DATA compressed with ALGORITHM.  */
+
+static void
+compress_with (enum lto_compression_algorithm algorithm, const char *data,
+	       size_t len, auto_vec<char> *compressed)
+{
+  enum lto_compression_algorithm saved = flag_lto_compression_algorithm;
+  struct lto_compression_stream *stream;
+
+  flag_lto_compression_algorithm = algorithm;
+  stream = lto_start_compression (append_to_vec, compressed);
+  lto_compress_block (stream, data, len);
+  lto_end_compression (stream);
+  flag_lto_compression_algorithm = saved;
+}
+
+/* Verify that the LEN bytes at DATA survive compression with ALGORITHM
+   and uncompression with both interfaces.  */
+
+static void
+check_round_trip (enum lto_compression_algorithm algorithm, const char *data,
+		  size_t len)
+{
+  auto_vec<char> compressed, uncompressed;
+  struct lto_compression_stream *stream;
+  size_t out_len;
+  char *out;
+
+  compress_with (algorithm, data, len, &compressed);
+
+  stream = lto_start_uncompression (append_to_vec, &uncompressed);
+  lto_uncompress_block (stream, compressed.address (), compressed.length ());
+  lto_end_uncompression (stream);
+  ASSERT_EQ (len, uncompressed.length ());
+  ASSERT_EQ (0, memcmp (data, uncompressed.address (), len));
+
+  out = lto_uncompress_buffer (compressed.address (), compressed.length (),
+			       &out_len);
+  ASSERT_TRUE (out != NULL);
+  ASSERT_EQ (len, out_len);
+  ASSERT_EQ (0, memcmp (data, out, len));
+  free (out);
+}
+
+/* Run the round trip checks for ALGORITHM on various kinds of data.  */
+
+static void
+test_round_trips (enum lto_compression_algorithm algorithm)
+{
+  const size_t len = 200000;
+  char *data = XNEWVEC (char, len);
+  unsigned int seed = 1;
+
+  check_round_trip (algorithm, "x", 1);
+  check_round_trip (algorithm, "abcdabcdabcdabcd", 16);
+
+  /* Incompressible data.  */
+  for (size_t i = 0; i < len; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      data[i] = seed >> 16;
     }
+  check_round_trip (algorithm, data, len);
 
-  lto_destroy_compression_stream (stream);
-  free (outbuf);
-  timevar_pop (TV_IPA_LTO_DECOMPRESS);
+  /* A long run, which gives long overlapping matches.  */
+  memset (data, 'a', len);
+  check_round_trip (algorithm, data, len);
+
+  /* Text with repetitions at various distances.  */
+  for (size_t i = 0; i < len; i++)
+    data[i] = "lto_compression"[(i * i / 1000) % 15];
+  check_round_trip (algorithm, data, len);
+
+  free (data);
 }
+
+/* Verify that segments compressed with different algorithms can be
+   concatenated, and that corrupt data is rejected.  */
+
+static void
+test_mixed_segments ()
+{
+  static const char text[] = "ld -r may concatenate sections compressed "
+			     "with different algorithms";
+  auto_vec<char> compressed;
+  size_t out_len;
+  char *out;
+
+  compress_with (LTO_COMPRESSION_LZ, text, sizeof (text), &compressed);
+  compress_with (LTO_COMPRESSION_ZLIB, text, sizeof (text), &compressed);
+  compress_with (LTO_COMPRESSION_LZ, text, sizeof (text), &compressed);
+  out = lto_uncompress_buffer (compressed.address (), compressed.length (),
+			       &out_len);
+  ASSERT_TRUE (out != NULL);
+  ASSERT_EQ (3 * sizeof (text), out_len);
+  for (unsigned i = 0; i < 3; i++)
+    ASSERT_EQ (0, memcmp (text, out + i * sizeof (text), sizeof (text)));
+  free (out);
+
+  /* Truncate the last segment.  */
+  ASSERT_TRUE (lto_uncompress_buffer (compressed.address (),
+				      compressed.length () - 1,
+				      &out_len) == NULL);
+}
+
+/* Run all of the selftests within this file.  */
+
+void
+lto_compress_c_tests ()
+{
+  test_round_trips (LTO_COMPRESSION_ZLIB);
+  test_round_trips (LTO_COMPRESSION_LZ);
+  test_mixed_segments ();
+}
+
+} // namespace selftest
+
+#endif /* CHECKING_P */
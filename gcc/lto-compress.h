@@ -38,5 +38,7 @@ extern struct lto_compression_stream
 extern void lto_uncompress_block (struct lto_compression_stream *stream,
 				  const char *base, size_t num_chars);
 extern void lto_end_uncompression (struct lto_compression_stream *stream);
+extern char *lto_uncompress_buffer (const char *data, size_t len,
+				    size_t *out_len);
 
 #endif /* GCC_LTO_COMPRESS_H  */
@@ -168,10 +168,16 @@ lto_write_options (void)
     {
       struct cl_decoded_option *option = &save_decoded_options[i];
 
-      /* Skip explicitly some common options that we do not need.  */
+      /* Skip explicitly some common options that we do not need.  The
+	 names of the temporary files of WPA, or the descriptor it reports
+	 ready units on, would also keep the LTRANS units of successive
+	 links from being identical.  */
       switch (option->opt_index)
       {
 	case OPT_dumpbase:
+	case OPT_fltrans_output_list_:
+	case OPT_fltrans_ready_fd_:
+	case OPT_fresolution_:
 	case OPT_SPECIAL_unknown:
 	case OPT_SPECIAL_ignore:
 	case OPT_SPECIAL_program_name:
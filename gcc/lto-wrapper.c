@@ -48,6 +48,13 @@ along with GCC; see the file COPYING3.  If not see
 #include "simple-object.h"
 #include "lto-section-names.h"
 #include "collect-utils.h"
+#include "md5.h"
+#include "version.h"
+#include <dirent.h>
+#include <utime.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
 
 /* Environment variable, used for passing the names of offload targets from GCC
    driver to lto-wrapper.  */
@@ -90,7 +97,8 @@ tool_cleanup (bool)
     maybe_unlink (makefile);
   for (i = 0; i < nr; ++i)
     {
-      maybe_unlink (input_names[i]);
+      if (input_names[i])
+	maybe_unlink (input_names[i]);
       if (output_names[i])
 	maybe_unlink (output_names[i]);
     }
@@ -594,6 +602,8 @@ append_linker_options (obstack *argv_obstack, struct cl_decoded_option *opts,
 	case OPT_o:
 	case OPT_flto_:
 	case OPT_flto:
+	case OPT_flto_cache_:
+	case OPT_flto_cache_size_:
 	  /* We've handled these LTO options, do not pass them on.  */
 	  continue;
 
@@ -842,6 +852,268 @@ copy_file (const char *dest, const char *src)
     }
 }
 
+/* The LTRANS object cache.
+
+   With -flto-cache=DIR, the object produced by each LTRANS compilation is
+   kept in DIR, in a file named after an MD5 digest of everything that the
+   compilation depends on: the compiler, its command line and the LTRANS
+   unit streamed out by WPA.  A later link in which WPA streams out an
+   identical unit copies the object from the cache instead of compiling
+   the unit again.  So that this happens as often as possible, WPA is run
+   with a fixed random seed and, unless the link line selects another
+   partitioning, -flto-partition=stable.  The least recently used entries
+   are removed once the cache grows beyond -flto-cache-size.  */
+
+/* The cache directory, or NULL if the cache is not in use.  */
+static const char *lto_cache_dir;
+
+/* The size limit of the cache, in bytes.  */
+static unsigned HOST_WIDE_INT lto_cache_size;
+
+/* A digest of the identity of the compiler.  */
+static unsigned char lto_cache_compiler_digest[16];
+
+/* Feed the identity of the file PATH, as far as it can be had without
+   reading it, into CTX.  */
+
+static void
+lto_cache_process_file_id (const char *path, struct md5_ctx *ctx)
+{
+  struct stat st;
+
+  md5_process_bytes (path, strlen (path) + 1, ctx);
+  if (stat (path, &st) == 0)
+    {
+      md5_process_bytes (&st.st_size, sizeof (st.st_size), ctx);
+      md5_process_bytes (&st.st_mtime, sizeof (st.st_mtime), ctx);
+    }
+}
+
+/* Start using the cache in DIR, of at most SIZE_MB megabytes, creating DIR
+   if necessary.  WRAPPER is the name this program was run as; lto1 is
+   installed alongside it.  */
+
+static void
+lto_cache_init (const char *dir, int size_mb, const char *wrapper)
+{
+  struct md5_ctx ctx;
+  struct stat st;
+  const char *p;
+  char *dir_name, *lto1;
+
+  if (stat (dir, &st) != 0 && mkdir (dir, 0777) != 0 && errno != EEXIST)
+    {
+      warning (0, "cannot create LTO cache directory %s: %m", dir);
+      return;
+    }
+  lto_cache_dir = dir;
+  lto_cache_size = (unsigned HOST_WIDE_INT) size_mb << 20;
+
+  /* Rebuilding the compiler does not necessarily change its version, so
+     also identify lto-wrapper and lto1 by their size and time stamp.  */
+  md5_init_ctx (&ctx);
+  md5_process_bytes (version_string, strlen (version_string) + 1, &ctx);
+  lto_cache_process_file_id (wrapper, &ctx);
+  for (p = wrapper + strlen (wrapper); p != wrapper; --p)
+    if (IS_DIR_SEPARATOR (p[-1]))
+      break;
+  dir_name = xstrndup (wrapper, p - wrapper);
+  lto1 = concat (dir_name, "lto1", NULL);
+#ifdef HOST_EXECUTABLE_SUFFIX
+  lto1 = reconcat (lto1, lto1, HOST_EXECUTABLE_SUFFIX, NULL);
+#endif
+  lto_cache_process_file_id (lto1, &ctx);
+  free (lto1);
+  free (dir_name);
+  md5_finish_ctx (&ctx, lto_cache_compiler_digest);
+}
+
+/* Return the name of the cache entry for compiling the LTRANS unit
+   INPUT_NAME with the NARGS options in ARGS, or NULL if the unit cannot
+   be read.  */
+
+static char *
+lto_cache_entry_name (const char **args, int nargs, const char *input_name)
+{
+  static char buffer[65536];
+  struct md5_ctx ctx;
+  unsigned char digest[16];
+  char hex[2 * sizeof (digest) + 1];
+  size_t len;
+  bool ok;
+  int i;
+
+  FILE *f = fopen (input_name, "rb");
+  if (!f)
+    return NULL;
+
+  md5_init_ctx (&ctx);
+  md5_process_bytes (lto_cache_compiler_digest,
+		     sizeof (lto_cache_compiler_digest), &ctx);
+  for (i = 0; i < nargs; i++)
+    md5_process_bytes (args[i], strlen (args[i]) + 1, &ctx);
+  while ((len = fread (buffer, 1, sizeof (buffer), f)) > 0)
+    md5_process_bytes (buffer, len, &ctx);
+  ok = !ferror (f);
+  fclose (f);
+  if (!ok)
+    return NULL;
+  md5_finish_ctx (&ctx, digest);
+
+  for (i = 0; i < (int) sizeof (digest); i++)
+    sprintf (hex + 2 * i, "%02x", digest[i]);
+  return concat (lto_cache_dir, "/", hex, ".o", NULL);
+}
+
+/* Copy the file SRC to DEST.  Return false if that failed; unlike with
+   copy_file, that is not fatal, as a cache failure costs no more than a
+   compilation.  */
+
+static bool
+lto_cache_copy (const char *dest, const char *src)
+{
+  static char buffer[65536];
+  size_t len;
+  bool ok = true;
+
+  FILE *s = fopen (src, "rb");
+  if (!s)
+    return false;
+  FILE *d = fopen (dest, "wb");
+  if (!d)
+    {
+      fclose (s);
+      return false;
+    }
+  while ((len = fread (buffer, 1, sizeof (buffer), s)) > 0)
+    if (fwrite (buffer, 1, len, d) != len)
+      {
+	ok = false;
+	break;
+      }
+  if (ferror (s))
+    ok = false;
+  fclose (s);
+  if (fclose (d) != 0)
+    ok = false;
+  if (!ok)
+    unlink (dest);
+  return ok;
+}
+
+/* If the cache has the object for ENTRY, copy it to OUTPUT_NAME and
+   return true.  */
+
+static bool
+lto_cache_fetch (const char *entry, const char *output_name)
+{
+  if (!lto_cache_copy (output_name, entry))
+    return false;
+
+  /* Mark the entry as recently used.  */
+  utime (entry, NULL);
+  if (verbose)
+    fprintf (stderr, "[Reusing %s for %s]\n", entry, output_name);
+  return true;
+}
+
+/* Store the object OUTPUT_NAME in the cache as ENTRY.  Another link using
+   the same cache may be storing the same entry, so write a file of our
+   own and rename it into place.  */
+
+static void
+lto_cache_store (const char *entry, const char *output_name)
+{
+  char *tmp = XNEWVEC (char, strlen (entry) + 32);
+
+  sprintf (tmp, "%s.%ld.tmp", entry, (long) getpid ());
+  if (!lto_cache_copy (tmp, output_name) || rename (tmp, entry) != 0)
+    unlink (tmp);
+  free (tmp);
+}
+
+/* A file in the cache.  */
+
+struct lto_cache_file
+{
+  char *name;
+  off_t size;
+  time_t mtime;
+};
+
+/* Order cache files from the least to the most recently used.  */
+
+static int
+lto_cache_file_cmp (const void *pa, const void *pb)
+{
+  const lto_cache_file *a = (const lto_cache_file *) pa;
+  const lto_cache_file *b = (const lto_cache_file *) pb;
+
+  if (a->mtime != b->mtime)
+    return a->mtime < b->mtime ? -1 : 1;
+  return strcmp (a->name, b->name);
+}
+
+/* Return true if NAME is the name of a cache entry.  */
+
+static bool
+lto_cache_entry_p (const char *name)
+{
+  int i;
+
+  for (i = 0; i < 32; i++)
+    if (!ISXDIGIT (name[i]))
+      return false;
+  return strcmp (name + 32, ".o") == 0;
+}
+
+/* Remove the least recently used entries from the cache until it is no
+   larger than its limit.  */
+
+static void
+lto_cache_trim (void)
+{
+  lto_cache_file *files = NULL;
+  unsigned int nfiles = 0, i;
+  unsigned HOST_WIDE_INT total = 0;
+  struct dirent *ent;
+  DIR *dir;
+
+  dir = opendir (lto_cache_dir);
+  if (!dir)
+    return;
+  while ((ent = readdir (dir)) != NULL)
+    {
+      struct stat st;
+      char *name;
+
+      if (!lto_cache_entry_p (ent->d_name))
+	continue;
+      name = concat (lto_cache_dir, "/", ent->d_name, NULL);
+      if (stat (name, &st) != 0)
+	{
+	  free (name);
+	  continue;
+	}
+      files = XRESIZEVEC (lto_cache_file, files, nfiles + 1);
+      files[nfiles].name = name;
+      files[nfiles].size = st.st_size;
+      files[nfiles].mtime = st.st_mtime;
+      nfiles++;
+      total += st.st_size;
+    }
+  closedir (dir);
+
+  qsort (files, nfiles, sizeof (lto_cache_file), lto_cache_file_cmp);
+  for (i = 0; i < nfiles; i++)
+    {
+      if (total > lto_cache_size && unlink (files[i].name) == 0)
+	total -= files[i].size;
+      free (files[i].name);
+    }
+  free (files);
+}
+
 /* Find the crtoffloadtable.o file in LIBRARY_PATH, make copy and pass name of
    the copy to the linker.  */
 
@@ -940,6 +1212,333 @@ find_and_merge_options (int fd, off_t file_offset, const char *prefix,
   return true;
 }
 
+#ifdef HAVE_WORKING_FORK
+/* The LTRANS units compiled by lto-wrapper itself when they are run in
+   parallel without make: the command line of each unit, the input it
+   consumes and the process compiling it once started.  Units are queued
+   as soon as WPA reports them, and started as soon as a slot is free.  */
+static const char ***ltrans_jobs;
+static char **ltrans_job_inputs;
+static pid_t *ltrans_job_pids;
+static unsigned ltrans_njobs, ltrans_jobs_started, ltrans_jobs_running;
+
+/* The command of the first unit that failed, and its status.  */
+static const char *ltrans_job_failed;
+static int ltrans_job_failed_status;
+
+/* Queue the compilation of INPUT with the command line ARGV, of which a
+   copy is made.  */
+
+static void
+queue_ltrans_job (const char **argv, char *input)
+{
+  unsigned argc;
+
+  for (argc = 0; argv[argc] != NULL; ++argc)
+    ;
+  ltrans_jobs = XRESIZEVEC (const char **, ltrans_jobs, ltrans_njobs + 1);
+  ltrans_job_inputs = XRESIZEVEC (char *, ltrans_job_inputs,
+				  ltrans_njobs + 1);
+  ltrans_job_pids = XRESIZEVEC (pid_t, ltrans_job_pids, ltrans_njobs + 1);
+  ltrans_jobs[ltrans_njobs] = XDUPVEC (const char *, argv, argc + 1);
+  ltrans_job_inputs[ltrans_njobs] = input;
+  ltrans_job_pids[ltrans_njobs] = 0;
+  ltrans_njobs++;
+}
+
+/* Start queued units while fewer than PARALLEL are running, unless a
+   unit failed already.  */
+
+static void
+start_ltrans_jobs (int parallel)
+{
+  while (ltrans_jobs_running < (unsigned) parallel
+	 && ltrans_jobs_started < ltrans_njobs
+	 && !ltrans_job_failed)
+    {
+      const char **argv = ltrans_jobs[ltrans_jobs_started];
+
+      if (verbose || debug)
+	{
+	  fprintf (stderr, "%s", argv[0]);
+	  for (unsigned j = 1; argv[j]; j++)
+	    fprintf (stderr, " %s", argv[j]);
+	  fprintf (stderr, "\n");
+	}
+      fflush (stdout);
+      fflush (stderr);
+
+      pid_t pid = fork ();
+      if (pid == -1)
+	fatal_error (input_location, "fork: %m");
+      if (pid == 0)
+	{
+	  execvp (argv[0], CONST_CAST (char **, argv));
+	  fprintf (stderr, "%s: %s: %s\n", progname, argv[0],
+		   xstrerror (errno));
+	  _exit (127);
+	}
+      ltrans_job_pids[ltrans_jobs_started++] = pid;
+      ltrans_jobs_running++;
+    }
+}
+
+/* Record that the unit compiled by process PID exited with STATUS, and
+   remove its input.  Return false if PID does not compile a unit.  */
+
+static bool
+ltrans_job_done (pid_t pid, int status)
+{
+  for (unsigned i = 0; i < ltrans_jobs_started; i++)
+    if (ltrans_job_pids[i] == pid)
+      {
+	ltrans_job_pids[i] = 0;
+	ltrans_jobs_running--;
+	if (status && !ltrans_job_failed)
+	  {
+	    ltrans_job_failed = ltrans_jobs[i][0];
+	    ltrans_job_failed_status = status;
+	  }
+	maybe_unlink (ltrans_job_inputs[i]);
+	return true;
+      }
+  return false;
+}
+
+/* Collect the units that are done without blocking, then start queued
+   units.  This is used while WPA is running, as waiting for any child
+   would also collect WPA.  */
+
+static void
+poll_ltrans_jobs (int parallel)
+{
+  for (unsigned i = 0; i < ltrans_jobs_started; i++)
+    {
+      int status;
+      pid_t pid = ltrans_job_pids[i];
+      if (pid && waitpid (pid, &status, WNOHANG) == pid)
+	ltrans_job_done (pid, status);
+    }
+  start_ltrans_jobs (parallel);
+}
+
+/* Return the next line WPA reports on descriptor FD, without its newline,
+   or NULL at the end.  While units are running, wait for it only a
+   little at a time and collect the units that are done in between, so
+   that a unit finishing while WPA is quiet frees its slot at once for
+   the next of PARALLEL.  */
+
+static char *
+read_ready_line (int fd, int parallel)
+{
+  static char *buf;
+  static size_t len, size;
+
+  for (;;)
+    {
+      char *nl = len ? (char *) memchr (buf, '\n', len) : NULL;
+      if (nl)
+	{
+	  char *line = xstrndup (buf, nl - buf);
+	  len -= nl + 1 - buf;
+	  memmove (buf, nl + 1, len);
+	  return line;
+	}
+
+#ifdef HAVE_POLL_H
+      if (ltrans_jobs_running)
+	{
+	  struct pollfd pfd;
+	  int n;
+
+	  pfd.fd = fd;
+	  pfd.events = POLLIN;
+	  pfd.revents = 0;
+	  n = poll (&pfd, 1, 100);
+	  if (n < 0 && errno != EINTR)
+	    fatal_error (input_location, "poll: %m");
+	  poll_ltrans_jobs (parallel);
+	  if (n <= 0)
+	    continue;
+	}
+#endif
+
+      if (len == size)
+	{
+	  size = size ? 2 * size : 256;
+	  buf = XRESIZEVEC (char, buf, size);
+	}
+      ssize_t got = read (fd, buf + len, size - len);
+      if (got < 0 && errno == EINTR)
+	continue;
+      if (got < 0)
+	fatal_error (input_location, "read: %m");
+      if (got == 0)
+	{
+	  free (buf);
+	  buf = NULL;
+	  len = size = 0;
+	  return NULL;
+	}
+      len += got;
+    }
+}
+
+/* Run the queued units, at most PARALLEL at a time, and wait for all of
+   them.  If a unit failed, the units already running are waited for
+   before reporting the error.  */
+
+static void
+finish_ltrans_jobs (int parallel)
+{
+  for (;;)
+    {
+      int status;
+
+      start_ltrans_jobs (parallel);
+      if (!ltrans_jobs_running)
+	break;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid == -1)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  fatal_error (input_location, "waitpid: %m");
+	}
+      ltrans_job_done (pid, status);
+    }
+
+  for (unsigned i = 0; i < ltrans_njobs; ++i)
+    free (ltrans_jobs[i]);
+  free (ltrans_jobs);
+  free (ltrans_job_inputs);
+  free (ltrans_job_pids);
+
+  if (ltrans_job_failed)
+    {
+      if (WIFSIGNALED (ltrans_job_failed_status))
+	{
+	  int sig = WTERMSIG (ltrans_job_failed_status);
+	  fatal_error (input_location, "%s terminated with signal %d [%s]%s",
+		       ltrans_job_failed, sig, strsignal (sig),
+		       WCOREDUMP (ltrans_job_failed_status)
+		       ? ", core dumped" : "");
+	}
+      fatal_error (input_location, "%s returned %d exit status",
+		   ltrans_job_failed, WEXITSTATUS (ltrans_job_failed_status));
+    }
+}
+#endif
+
+/* Read a line from STREAM and return it without its newline, or NULL at
+   the end of the file.  */
+
+static char *
+read_line (FILE *stream)
+{
+  const unsigned piece = 32;
+  char *line = XNEWVEC (char, piece);
+  char *buf = line;
+  size_t len;
+
+  for (;;)
+    {
+      if (!fgets (buf, piece, stream))
+	{
+	  free (line);
+	  return NULL;
+	}
+      len = strlen (line);
+      if (line[len - 1] == '\n')
+	{
+	  line[len - 1] = '\0';
+	  return line;
+	}
+      line = XRESIZEVEC (char, line, len + piece);
+      buf = line + len;
+    }
+}
+
+/* Make room for the LTRANS unit with index I in INPUT_NAMES and
+   OUTPUT_NAMES, and in *CACHE_ENTRIES if the LTO cache is used.  */
+
+static void
+grow_ltrans_units (unsigned i, char ***cache_entries)
+{
+  if (i < nr)
+    return;
+  input_names = XRESIZEVEC (char *, input_names, i + 1);
+  output_names = XRESIZEVEC (char *, output_names, i + 1);
+  if (lto_cache_dir)
+    *cache_entries = XRESIZEVEC (char *, *cache_entries, i + 1);
+  for (; nr <= i; nr++)
+    {
+      input_names[nr] = NULL;
+      output_names[nr] = NULL;
+      if (lto_cache_dir)
+	(*cache_entries)[nr] = NULL;
+    }
+}
+
+/* Set up NEW_ARGV, the command line whose head has NEW_HEAD_ARGC
+   arguments followed by the unit-specific ones at ARGV_PTR, to compile
+   the LTRANS unit with index I.  Set OUTPUT_NAMES[I] to the object it
+   produces, allocated on OB.  LINKER_OUTPUT is the output of the link if
+   known.  Return false if the object was found in the LTO cache, in which
+   case nothing is left to do; otherwise set CACHE_ENTRIES[I] to the cache
+   entry to store the object in, if any.  */
+
+static bool
+prepare_ltrans_unit (unsigned i, const char **new_argv, const char **argv_ptr,
+		     int new_head_argc, const char *linker_output,
+		     struct obstack *ob, char **cache_entries)
+{
+  char *input_name = input_names[i];
+  char *output_name;
+
+  /* Replace the .o suffix with a .ltrans.o suffix and write
+     the resulting name to the LTRANS output list.  */
+  obstack_grow (ob, input_name, strlen (input_name) - 2);
+  obstack_grow (ob, ".ltrans.o", sizeof (".ltrans.o"));
+  output_name = XOBFINISH (ob, char *);
+  output_names[i] = output_name;
+
+  /* Adjust the dumpbase if the linker output file was seen.  */
+  if (linker_output)
+    {
+      char *dumpbase
+	  = (char *) xmalloc (strlen (linker_output)
+			      + sizeof (DUMPBASE_SUFFIX) + 1);
+      snprintf (dumpbase,
+		strlen (linker_output) + sizeof (DUMPBASE_SUFFIX),
+		"%s.ltrans%u", linker_output, i);
+      argv_ptr[0] = dumpbase;
+    }
+
+  argv_ptr[1] = "-fltrans";
+  argv_ptr[2] = "-o";
+  argv_ptr[3] = output_name;
+  argv_ptr[4] = input_name;
+  argv_ptr[5] = NULL;
+
+  /* Look the unit up in the cache.  The dumpbase and the names of
+     the temporary files do not affect the object.  */
+  if (lto_cache_dir)
+    {
+      cache_entries[i] = lto_cache_entry_name (new_argv, new_head_argc,
+					       input_name);
+      if (cache_entries[i]
+	  && lto_cache_fetch (cache_entries[i], output_name))
+	{
+	  free (cache_entries[i]);
+	  cache_entries[i] = NULL;
+	  maybe_unlink (input_name);
+	  return false;
+	}
+    }
+  return true;
+}
+
 /* Execute gcc. ARGC is the number of arguments. ARGV contains the arguments. */
 
 static void
@@ -964,6 +1563,14 @@ run_gcc (unsigned argc, char *argv[])
   int new_head_argc;
   bool have_lto = false;
   bool have_offload = false;
+  bool have_partition = false;
+  bool have_random_seed = false;
+  const char *cache_dir = NULL;
+  int cache_size_mb = 1024;
+  char **cache_entries = NULL;
+  bool direct_ltrans = false;
+  int ready_fds[2] = { -1, -1 };
+  struct obstack env_obstack;
   unsigned lto_argc = 0;
   char **lto_argv;
 
@@ -1062,6 +1669,20 @@ run_gcc (unsigned argc, char *argv[])
 	case OPT_flto_partition_:
 	  if (strcmp (option->arg, "none") == 0)
 	    no_partition = true;
+	  have_partition = true;
+	  break;
+
+	case OPT_flto_cache_:
+	  cache_dir = option->arg;
+	  break;
+
+	case OPT_flto_cache_size_:
+	  cache_size_mb = option->value;
+	  break;
+
+	case OPT_frandom_seed:
+	case OPT_frandom_seed_:
+	  have_random_seed = true;
 	  break;
 
 	case OPT_flto_:
@@ -1094,6 +1715,21 @@ run_gcc (unsigned argc, char *argv[])
       parallel = 0;
     }
 
+  if (cache_dir && lto_mode == LTO_MODE_WHOPR)
+    {
+      lto_cache_init (cache_dir, cache_size_mb, argv[0]);
+
+      /* Make WPA deterministic, and the LTRANS units it streams out
+	 resistant to changes elsewhere in the program.  */
+      if (lto_cache_dir && !have_random_seed)
+	obstack_ptr_grow (&argv_obstack,
+			  concat ("-frandom-seed=",
+				  linker_output ? linker_output : "a.out",
+				  NULL));
+      if (lto_cache_dir && !have_partition)
+	obstack_ptr_grow (&argv_obstack, "-flto-partition=stable");
+    }
+
   if (linker_output)
     {
       char *output_dir, *base, *name;
@@ -1274,6 +1910,21 @@ cont1:
 	}
       else
         obstack_ptr_grow (&argv_obstack, "-fwpa");
+
+#ifdef HAVE_WORKING_FORK
+      /* Without a jobserver to cooperate with, run the LTRANS units
+	 ourselves rather than through make.  Have WPA report each unit as
+	 soon as it is written, so that it is compiled while the others
+	 are streamed out.  */
+      direct_ltrans = parallel && !jobserver;
+      if (direct_ltrans && pipe (ready_fds) == 0)
+	{
+	  char buf[64];
+	  fcntl (ready_fds[0], F_SETFD, FD_CLOEXEC);
+	  sprintf (buf, "-fltrans-ready-fd=%d", ready_fds[1]);
+	  obstack_ptr_grow (&argv_obstack, xstrdup (buf));
+	}
+#endif
     }
 
   /* Append the input objects and possible preceding arguments.  */
@@ -1283,7 +1934,43 @@ cont1:
 
   new_argv = XOBFINISH (&argv_obstack, const char **);
   argv_ptr = &new_argv[new_head_argc];
-  fork_execute (new_argv[0], CONST_CAST (char **, new_argv), true);
+  obstack_init (&env_obstack);
+  nr = 0;
+#ifdef HAVE_WORKING_FORK
+  if (ready_fds[1] != -1)
+    {
+      struct pex_obj *pex;
+      char *line;
+
+      pex = collect_execute (new_argv[0], CONST_CAST (char **, new_argv),
+			     NULL, NULL, PEX_LAST | PEX_SEARCH, true);
+      /* Only WPA and its streaming processes may keep the pipe open,
+	 so that we see its end when they are done.  */
+      close (ready_fds[1]);
+      while ((line = read_ready_line (ready_fds[0], parallel)) != NULL)
+	{
+	  unsigned idx;
+	  int consumed;
+
+	  if (sscanf (line, "%u %n", &idx, &consumed) >= 1
+	      && line[consumed] != '\0')
+	    {
+	      grow_ltrans_units (idx, &cache_entries);
+	      input_names[idx] = xstrdup (line + consumed);
+	      if (prepare_ltrans_unit (idx, new_argv, argv_ptr, new_head_argc,
+				       linker_output, &env_obstack,
+				       cache_entries))
+		queue_ltrans_job (new_argv, input_names[idx]);
+	      poll_ltrans_jobs (parallel);
+	    }
+	  free (line);
+	}
+      close (ready_fds[0]);
+      do_wait (new_argv[0], pex);
+    }
+  else
+#endif
+    fork_execute (new_argv[0], CONST_CAST (char **, new_argv), true);
 
   if (lto_mode == LTO_MODE_LTO)
     {
@@ -1295,48 +1982,32 @@ cont1:
     {
       FILE *stream = fopen (ltrans_output_file, "r");
       FILE *mstream = NULL;
-      struct obstack env_obstack;
+      char *input_name;
+      unsigned n = 0;
 
       if (!stream)
 	fatal_error (input_location, "fopen: %s: %m", ltrans_output_file);
 
-      /* Parse the list of LTRANS inputs from the WPA stage.  */
-      obstack_init (&env_obstack);
-      nr = 0;
-      for (;;)
+      /* Parse the list of LTRANS inputs from the WPA stage.  The units
+	 WPA reported as they were written are known already.  */
+      while ((input_name = read_line (stream)) != NULL)
 	{
-	  const unsigned piece = 32;
-	  char *output_name = NULL;
-	  char *buf, *input_name = (char *)xmalloc (piece);
-	  size_t len;
-
-	  buf = input_name;
-cont:
-	  if (!fgets (buf, piece, stream))
-	    break;
-	  len = strlen (input_name);
-	  if (input_name[len - 1] != '\n')
+	  if (n < nr && input_names[n])
+	    free (input_name);
+	  else
 	    {
-	      input_name = (char *)xrealloc (input_name, len + piece);
-	      buf = input_name + len;
-	      goto cont;
+	      grow_ltrans_units (n, &cache_entries);
+	      input_names[n] = input_name;
+	      if (input_name[0] == '*')
+		output_names[n] = &input_name[1];
 	    }
-	  input_name[len - 1] = '\0';
-
-	  if (input_name[0] == '*')
-	    output_name = &input_name[1];
-
-	  nr++;
-	  input_names = (char **)xrealloc (input_names, nr * sizeof (char *));
-	  output_names = (char **)xrealloc (output_names, nr * sizeof (char *));
-	  input_names[nr-1] = input_name;
-	  output_names[nr-1] = output_name;
+	  n++;
 	}
       fclose (stream);
       maybe_unlink (ltrans_output_file);
       ltrans_output_file = NULL;
 
-      if (parallel)
+      if (parallel && !direct_ltrans)
 	{
 	  makefile = make_temp_file (".mk");
 	  mstream = fopen (makefile, "w");
@@ -1347,34 +2018,23 @@ cont:
       for (i = 0; i < nr; ++i)
 	{
 	  char *output_name;
-	  char *input_name = input_names[i];
-	  /* If it's a pass-through file do nothing.  */
+	  input_name = input_names[i];
+	  /* If it's a pass-through file or a unit WPA reported, do
+	     nothing.  */
 	  if (output_names[i])
 	    continue;
 
-	  /* Replace the .o suffix with a .ltrans.o suffix and write
-	     the resulting name to the LTRANS output list.  */
-	  obstack_grow (&env_obstack, input_name, strlen (input_name) - 2);
-	  obstack_grow (&env_obstack, ".ltrans.o", sizeof (".ltrans.o"));
-	  output_name = XOBFINISH (&env_obstack, char *);
-
-	  /* Adjust the dumpbase if the linker output file was seen.  */
-	  if (linker_output)
-	    {
-	      char *dumpbase
-		  = (char *) xmalloc (strlen (linker_output)
-				      + sizeof (DUMPBASE_SUFFIX) + 1);
-	      snprintf (dumpbase,
-			strlen (linker_output) + sizeof (DUMPBASE_SUFFIX),
-			"%s.ltrans%u", linker_output, i);
-	      argv_ptr[0] = dumpbase;
-	    }
+	  if (!prepare_ltrans_unit (i, new_argv, argv_ptr, new_head_argc,
+				    linker_output, &env_obstack,
+				    cache_entries))
+	    continue;
+	  output_name = output_names[i];
 
-	  argv_ptr[1] = "-fltrans";
-	  argv_ptr[2] = "-o";
-	  argv_ptr[3] = output_name;
-	  argv_ptr[4] = input_name;
-	  argv_ptr[5] = NULL;
+#ifdef HAVE_WORKING_FORK
+	  if (direct_ltrans)
+	    queue_ltrans_job (new_argv, input_name);
+	  else
+#endif
 	  if (parallel)
 	    {
 	      fprintf (mstream, "%s:\n\t@%s ", output_name, new_argv[0]);
@@ -1395,9 +2055,12 @@ cont:
 			    true);
 	      maybe_unlink (input_name);
 	    }
-
-	  output_names[i] = output_name;
 	}
+#ifdef HAVE_WORKING_FORK
+      if (direct_ltrans)
+	finish_ltrans_jobs (parallel);
+      else
+#endif
       if (parallel)
 	{
 	  struct pex_obj *pex;
@@ -1436,6 +2099,17 @@ cont:
 	  for (i = 0; i < nr; ++i)
 	    maybe_unlink (input_names[i]);
 	}
+      if (lto_cache_dir)
+	{
+	  for (i = 0; i < nr; ++i)
+	    if (cache_entries[i])
+	      {
+		lto_cache_store (cache_entries[i], output_names[i]);
+		free (cache_entries[i]);
+	      }
+	  free (cache_entries);
+	  lto_cache_trim ();
+	}
       for (i = 0; i < nr; ++i)
 	{
 	  fputs (output_names[i], stdout);
@@ -1446,8 +2120,8 @@ cont:
       free (output_names);
       free (input_names);
       free (list_option_full);
-      obstack_free (&env_obstack, NULL);
     }
+  obstack_free (&env_obstack, NULL);
 
  finish:
   XDELETE (lto_argv);
@@ -409,6 +409,25 @@ add_sorted_nodes (vec<symtab_node *> &next_nodes, ltrans_partition partition)
 }
 
 
+/* Return true if a stable partition should end after NODE, given that
+   it already contains INSNS of the expected PARTITION_SIZE.  Like
+   content-defined chunking, the boundaries are chosen by a hash of the
+   symbol name, so they do not move when symbols are added, removed or
+   resized elsewhere and the partitioning resynchronizes right after an
+   edit.  Each node ends the partition with a probability proportional
+   to its size, which makes the partitions PARTITION_SIZE large on
+   average.  */
+
+static bool
+stable_partition_boundary_p (cgraph_node *node, int insns, int partition_size)
+{
+  if (insns < partition_size / 2 || node->alias)
+    return false;
+  unsigned int size = inline_summaries->get (node)->size;
+  hashval_t hash = htab_hash_string (node->asm_name ());
+  return hash % (unsigned int) (partition_size / 2) < size;
+}
+
 /* Group cgraph nodes into equally-sized partitions.
 
    The partitioning algorithm is simple: nodes are taken in predefined order.
@@ -445,10 +464,17 @@ add_sorted_nodes (vec<symtab_node *> &next_nodes, ltrans_partition partition)
    edges going to other partitions) and continue adding functions until after
    the current partition has grown to twice the expected partition size.  Then
    the process is undone to the point where the minimal ratio of boundary size
-   and in-partition calls was reached.  */
+   and in-partition calls was reached.
+
+   If STABLE is true, the partitions are instead made to depend as little
+   as possible on the rest of the program, so that a change to one function
+   changes few partitions and the LTRANS objects of the others can be
+   reused (see -flto-cache).  The expected partition size is then fixed
+   and a partition ends after a node chosen by stable_partition_boundary_p,
+   which looks only at the node itself.  */
 
 void
-lto_balanced_map (int n_lto_partitions, int max_partition_size)
+lto_balanced_map (int n_lto_partitions, int max_partition_size, bool stable)
 {
   int n_nodes = 0;
   int n_varpool_nodes = 0, varpool_pos = 0, best_varpool_pos = 0;
@@ -515,9 +541,14 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
   if (PARAM_VALUE (MIN_PARTITION_SIZE) > max_partition_size)
     fatal_error (input_location, "min partition size cannot be greater than max partition size");
 
-  partition_size = total_size / n_lto_partitions;
-  if (partition_size < PARAM_VALUE (MIN_PARTITION_SIZE))
-    partition_size = PARAM_VALUE (MIN_PARTITION_SIZE);
+  if (stable)
+    partition_size = PARAM_VALUE (PARAM_LTO_STABLE_PARTITION_SIZE);
+  else
+    {
+      partition_size = total_size / n_lto_partitions;
+      if (partition_size < PARAM_VALUE (MIN_PARTITION_SIZE))
+	partition_size = PARAM_VALUE (MIN_PARTITION_SIZE);
+    }
   npartitions = 1;
   partition = new_partition ("");
   if (symtab->dump_file)
@@ -700,8 +731,10 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
 	      }
 	}
 
-      /* If the partition is large enough, start looking for smallest boundary cost.  */
-      if (partition->insns < partition_size * 3 / 4
+      /* If the partition is large enough, start looking for smallest boundary
+	 cost.  Stable partitions are never unwound.  */
+      if (stable
+	  || partition->insns < partition_size * 3 / 4
 	  || best_cost == INT_MAX
 	  || ((!cost 
 	       || (best_internal * (HOST_WIDE_INT) cost
@@ -724,7 +757,10 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
       /* Partition is too large, unwind into step when best cost was reached and
 	 start new partition.  */
       if (partition->insns > 2 * partition_size
-	  || partition->insns > max_partition_size)
+	  || partition->insns > max_partition_size
+	  || (stable
+	      && stable_partition_boundary_p (order[i], partition->insns,
+					      partition_size)))
 	{
 	  if (best_i != i)
 	    {
@@ -751,14 +787,17 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
 	  best_cost = INT_MAX;
 
 	  /* Since the size of partitions is just approximate, update the size after
-	     we finished current one.  */
-	  if (npartitions < n_lto_partitions)
-	    partition_size = total_size / (n_lto_partitions - npartitions);
-	  else
-	    partition_size = INT_MAX;
+	     we finished current one.  The size of stable partitions is fixed.  */
+	  if (!stable)
+	    {
+	      if (npartitions < n_lto_partitions)
+		partition_size = total_size / (n_lto_partitions - npartitions);
+	      else
+		partition_size = INT_MAX;
 
-	  if (partition_size < PARAM_VALUE (MIN_PARTITION_SIZE))
-	    partition_size = PARAM_VALUE (MIN_PARTITION_SIZE);
+	      if (partition_size < PARAM_VALUE (MIN_PARTITION_SIZE))
+		partition_size = PARAM_VALUE (MIN_PARTITION_SIZE);
+	    }
 	  npartitions ++;
 	}
     }
@@ -53,6 +53,10 @@ along with GCC; see the file COPYING3.  If not see
 #include "lto-symtab.h"
 #include "stringpool.h"
 #include "fold-const.h"
+#include "lto-compress.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 
 /* Number of parallel tasks to run, -1 if we want to use GNU Make jobserver.  */
@@ -2000,10 +2004,39 @@ create_subid_section_table (struct lto_section_slot *ls, splay_tree file_ids,
   return 1;
 }
 
-/* Read declarations and other initializations for a FILE_DATA. */
+/* The declarations section of a file, read ahead of lto_read_decls by a
+   helper thread.
+
+   Materializing and merging trees is inherently serial: it allocates GC
+   memory and shares identifiers, constants and types between the input
+   files.  Reading and decompressing the section is not, so the helper
+   threads do that for the next few files while the main thread merges
+   the current one.  The files are still merged in linker order, so the
+   result is the same as when reading them one after another.  */
+
+struct lto_decl_prefetch
+{
+  /* Where the section is.  Copied out of the file data by the main
+     thread, so that the helper threads never touch GC memory.  */
+  const char *file_name;
+  intptr_t offset;
+  size_t raw_len;
+
+  /* The uncompressed section, or NULL if it could not be read, in which
+     case the main thread reads it again and reports the error.  */
+  char *data;
+  size_t len;
+
+  /* Whether the helper thread is done with this section.  */
+  bool done;
+};
+
+/* Read declarations and other initializations for a FILE_DATA.  PREFETCH,
+   if not NULL, is the declarations section read ahead for it.  */
 
 static void
-lto_file_finalize (struct lto_file_decl_data *file_data, lto_file *file)
+lto_file_finalize (struct lto_file_decl_data *file_data,
+		   struct lto_decl_prefetch *prefetch)
 {
   const char *data;
   size_t len;
@@ -2020,12 +2053,29 @@ lto_file_finalize (struct lto_file_decl_data *file_data, lto_file *file)
   file_data->respairs.release ();
 
   file_data->renaming_hash_table = lto_create_renaming_table ();
-  file_data->file_name = file->filename;
 #ifdef ACCEL_COMPILER
   lto_input_mode_table (file_data);
 #else
   file_data->mode_table = lto_mode_identity_table;
 #endif
+  if (prefetch && prefetch->data)
+    {
+      /* Account for the section as lto_get_section_data would.  */
+      data = prefetch->data;
+      len = prefetch->len;
+      lto_stats.section_size[LTO_section_decls] += prefetch->raw_len;
+      lto_stats.num_input_il_bytes += prefetch->raw_len;
+      lto_stats.num_uncompressed_il_bytes += len;
+      lto_check_version (((const lto_header *) data)->major_version,
+			 ((const lto_header *) data)->minor_version,
+			 file_data->file_name);
+      /* Frees resolutions */
+      lto_read_decls (file_data, data, resolutions);
+      free (prefetch->data);
+      prefetch->data = NULL;
+      return;
+    }
+
   data = lto_get_section_data (file_data, LTO_section_decls, NULL, &len);
   if (data == NULL)
     {
@@ -2037,13 +2087,13 @@ lto_file_finalize (struct lto_file_decl_data *file_data, lto_file *file)
   lto_free_section_data (file_data, LTO_section_decls, NULL, data, len);
 }
 
-/* Finalize FILE_DATA in FILE and increase COUNT. */
+/* Finalize FILE_DATA, using PREFETCH if not NULL, and increase COUNT. */
 
 static int 
-lto_create_files_from_ids (lto_file *file, struct lto_file_decl_data *file_data,
-			   int *count)
+lto_create_files_from_ids (struct lto_file_decl_data *file_data,
+			   struct lto_decl_prefetch *prefetch, int *count)
 {
-  lto_file_finalize (file_data, file);
+  lto_file_finalize (file_data, prefetch);
   if (symtab->dump_file)
     fprintf (symtab->dump_file,
 	     "Creating file %s with sub id " HOST_WIDE_INT_PRINT_HEX "\n",
@@ -2052,15 +2102,12 @@ lto_create_files_from_ids (lto_file *file, struct lto_file_decl_data *file_data,
   return 0;
 }
 
-/* Generate a TREE representation for all types and external decls
-   entities in FILE.  
-
-   Read all of the globals out of the file.  Then read the cgraph
-   and process the .o index into the cgraph nodes so that it can open
-   the .o file to load the functions and ipa information.   */
+/* Find the sub modules of FILE and their sections, and read their
+   symbol resolutions.  Return the list of sub modules in linker order;
+   their declarations are read later by lto_read_all_decls.  */
 
 static struct lto_file_decl_data *
-lto_file_read (lto_file *file, FILE *resolution_file, int *count)
+lto_file_read (lto_file *file, FILE *resolution_file)
 {
   struct lto_file_decl_data *file_data = NULL;
   splay_tree file_ids;
@@ -2082,10 +2129,9 @@ lto_file_read (lto_file *file, FILE *resolution_file, int *count)
   /* Add resolutions to file ids */
   lto_resolution_read (file_ids, resolution_file, file);
 
-  /* Finalize each lto file for each submodule in the merged object */
   for (file_data = file_list.first; file_data != NULL; file_data = file_data->next)
-    lto_create_files_from_ids (file, file_data, count);
- 
+    file_data->file_name = file->filename;
+
   splay_tree_delete (file_ids);
   htab_delete (section_hash_table);
 
@@ -2099,6 +2145,56 @@ lto_file_read (lto_file *file, FILE *resolution_file, int *count)
 #if LTO_MMAP_IO
 /* Page size of machine is used for mmap and munmap calls.  */
 static size_t page_mask;
+
+/* A read-only mapping of a whole input file.  Sections are handed out
+   as pointers into it, so reading a section costs no system call and
+   the pages are only faulted in when the section is actually used.
+   BASE is NULL if the file could not be mapped as a whole, for instance
+   for lack of address space; its sections are then mapped one by one.  */
+
+struct lto_file_mapping
+{
+  char *base;
+  size_t size;
+};
+
+/* The mappings of the input files, by file name.  Input files stay
+   mapped until the end of the compilation.  */
+static hash_map<nofree_string_hash, lto_file_mapping> *lto_file_mappings;
+
+/* Return the mapping of FILE_DATA's file, mapping the file if it was
+   not used yet.  FD is an open descriptor of the file, or -1.  */
+
+static lto_file_mapping *
+lto_get_file_mapping (struct lto_file_decl_data *file_data, int fd)
+{
+  bool existed;
+  struct stat st;
+
+  if (!lto_file_mappings)
+    lto_file_mappings = new hash_map<nofree_string_hash, lto_file_mapping>;
+  lto_file_mapping *mapping
+    = lto_file_mappings->get (file_data->file_name);
+  if (mapping || fd == -1)
+    return mapping;
+
+  mapping = &lto_file_mappings->get_or_insert
+	       (xstrdup (file_data->file_name), &existed);
+  mapping->base = NULL;
+  mapping->size = 0;
+  if (fstat (fd, &st) == 0 && st.st_size > 0
+      && (off_t) (size_t) st.st_size == st.st_size)
+    {
+      char *base = (char *) mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+				  fd, 0);
+      if (base != MAP_FAILED)
+	{
+	  mapping->base = base;
+	  mapping->size = st.st_size;
+	}
+    }
+  return mapping;
+}
 #endif
 
 /* Get the section data of length LEN from FILENAME starting at
@@ -2116,13 +2212,26 @@ lto_read_section_data (struct lto_file_decl_data *file_data,
   intptr_t computed_len;
   intptr_t computed_offset;
   intptr_t diff;
+  lto_file_mapping *mapping;
+
+  mapping = lto_get_file_mapping (file_data, -1);
+  if (mapping && mapping->base)
+    {
+      if ((size_t) offset > mapping->size
+	  || len > mapping->size - offset)
+	{
+	  fatal_error (input_location, "Cannot read %s",
+		       file_data->file_name);
+	  return NULL;
+	}
+      return mapping->base + offset;
+    }
 #endif
 
   /* Keep a single-entry file-descriptor cache.  The last file we
-     touched will get closed at exit.
-     ???  Eventually we want to add a more sophisticated larger cache
-     or rather fix function body streaming to not stream them in
-     practically random order.  */
+     touched will get closed at exit.  With mmap the whole file is
+     mapped on first use, so this only matters for files that could not
+     be mapped.  */
   if (fd != -1
       && filename_cmp (fd_name, file_data->file_name) != 0)
     {
@@ -2148,6 +2257,18 @@ lto_read_section_data (struct lto_file_decl_data *file_data,
       page_mask = ~(page_size - 1);
     }
 
+  if (!mapping)
+    {
+      mapping = lto_get_file_mapping (file_data, fd);
+      if (mapping->base)
+	{
+	  free (fd_name);
+	  close (fd);
+	  fd = -1;
+	  return lto_read_section_data (file_data, offset, len);
+	}
+    }
+
   computed_offset = offset & page_mask;
   diff = offset - computed_offset;
   computed_len = len + diff;
@@ -2184,6 +2305,26 @@ lto_read_section_data (struct lto_file_decl_data *file_data,
 }    
 
 
+/* Return the location of the section of SECTION_TYPE with NAME in
+   FILE_DATA, or NULL if there is no such section.  NAME will be NULL
+   unless the section type is for a function body.  */
+
+static struct lto_section_slot *
+find_section (struct lto_file_decl_data *file_data,
+	      enum lto_section_type section_type,
+	      const char *name)
+{
+  struct lto_section_slot *f_slot;
+  struct lto_section_slot s_slot;
+  const char *section_name = lto_get_section_name (section_type, name, file_data);
+
+  s_slot.name = section_name;
+  f_slot = (struct lto_section_slot *) htab_find (file_data->section_hash_table,
+						  &s_slot);
+  free (CONST_CAST (char *, section_name));
+  return f_slot;
+}
+
 /* Get the section data from FILE_DATA of SECTION_TYPE with NAME.
    NAME will be NULL unless the section type is for a function
    body.  */
@@ -2194,22 +2335,17 @@ get_section_data (struct lto_file_decl_data *file_data,
 		      const char *name,
 		      size_t *len)
 {
-  htab_t section_hash_table = file_data->section_hash_table;
   struct lto_section_slot *f_slot;
-  struct lto_section_slot s_slot;
-  const char *section_name = lto_get_section_name (section_type, name, file_data);
   char *data = NULL;
 
   *len = 0;
-  s_slot.name = section_name;
-  f_slot = (struct lto_section_slot *) htab_find (section_hash_table, &s_slot);
+  f_slot = find_section (file_data, section_type, name);
   if (f_slot)
     {
       data = lto_read_section_data (file_data, f_slot->start, f_slot->len);
       *len = f_slot->len;
     }
 
-  free (CONST_CAST (char *, section_name));
   return data;
 }
 
@@ -2227,9 +2363,25 @@ free_section_data (struct lto_file_decl_data *file_data ATTRIBUTE_UNUSED,
   intptr_t computed_len;
   intptr_t computed_offset;
   intptr_t diff;
+  lto_file_mapping *mapping;
 #endif
 
 #if LTO_MMAP_IO
+  mapping = lto_get_file_mapping (file_data, -1);
+  if (mapping && mapping->base)
+    {
+#if defined (HAVE_MADVISE) && HAVE_DECL_MADVISE && defined (MADV_DONTNEED)
+      /* Drop the pages that only hold this section from our resident
+	 set.  The mapping is read-only, so they are simply read back
+	 from the file should the section be used again.  */
+      intptr_t start = ((intptr_t) offset + ~page_mask) & page_mask;
+      intptr_t end = ((intptr_t) offset + len) & page_mask;
+      if (start < end)
+	madvise ((caddr_t) start, end - start, MADV_DONTNEED);
+#endif
+      return;
+    }
+
   computed_offset = ((intptr_t) offset) & page_mask;
   diff = (intptr_t) offset - computed_offset;
   computed_len = len + diff;
@@ -2240,6 +2392,174 @@ free_section_data (struct lto_file_decl_data *file_data ATTRIBUTE_UNUSED,
 #endif
 }
 
+#ifdef HAVE_PTHREAD
+/* The sections read ahead by the helper threads, in linker order.  The
+   helpers stay at most DECL_PREFETCH_WINDOW sections ahead of the main
+   thread to bound the memory used by uncompressed sections.  */
+static struct lto_decl_prefetch *decl_prefetch;
+static unsigned decl_prefetch_count;
+static unsigned decl_prefetch_next;
+static unsigned decl_prefetch_consumed;
+static unsigned decl_prefetch_window;
+static pthread_mutex_t decl_prefetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t decl_prefetch_cond = PTHREAD_COND_INITIALIZER;
+
+/* Read and uncompress the section described by PREFETCH.  This runs on a
+   helper thread, so errors are left for the main thread to report.  */
+
+static void
+lto_prefetch_decls (struct lto_decl_prefetch *prefetch)
+{
+  char *raw;
+  size_t done = 0;
+  int fd;
+
+  if (!prefetch->file_name)
+    return;
+
+  fd = open (prefetch->file_name, O_RDONLY|O_BINARY);
+  if (fd == -1)
+    return;
+
+  raw = XNEWVEC (char, prefetch->raw_len);
+  if (lseek (fd, prefetch->offset, SEEK_SET) == prefetch->offset)
+    while (done < prefetch->raw_len)
+      {
+	ssize_t n = read (fd, raw + done, prefetch->raw_len - done);
+	if (n <= 0)
+	  break;
+	done += n;
+      }
+  close (fd);
+
+  if (done == prefetch->raw_len)
+    prefetch->data = lto_uncompress_buffer (raw, prefetch->raw_len,
+					    &prefetch->len);
+  free (raw);
+}
+
+/* Body of the helper threads: read ahead the sections not claimed by
+   another helper yet.  */
+
+static void *
+lto_decl_prefetch_thread (void *)
+{
+  pthread_mutex_lock (&decl_prefetch_lock);
+  while (true)
+    {
+      unsigned i;
+
+      while (decl_prefetch_next < decl_prefetch_count
+	     && (decl_prefetch_next
+		 >= decl_prefetch_consumed + decl_prefetch_window))
+	pthread_cond_wait (&decl_prefetch_cond, &decl_prefetch_lock);
+      if (decl_prefetch_next >= decl_prefetch_count)
+	break;
+      i = decl_prefetch_next++;
+
+      pthread_mutex_unlock (&decl_prefetch_lock);
+      lto_prefetch_decls (&decl_prefetch[i]);
+      pthread_mutex_lock (&decl_prefetch_lock);
+
+      decl_prefetch[i].done = true;
+      pthread_cond_broadcast (&decl_prefetch_cond);
+    }
+  pthread_mutex_unlock (&decl_prefetch_lock);
+  return NULL;
+}
+#endif
+
+/* Read the declarations of the sub modules in FILES, the NFILES lists
+   returned by lto_file_read, in linker order.  Increase COUNT by the
+   number of sub modules.  */
+
+static void
+lto_read_all_decls (struct lto_file_decl_data **files, unsigned nfiles,
+		    int *count)
+{
+  auto_vec<lto_file_decl_data *> all_files;
+  struct lto_file_decl_data *file_data;
+  unsigned i;
+
+  for (i = 0; i < nfiles; i++)
+    for (file_data = files[i]; file_data; file_data = file_data->next)
+      all_files.safe_push (file_data);
+
+#ifdef HAVE_PTHREAD
+  /* LTRANS units come from a single WPA output whose declarations are not
+     compressed, so there is nothing to gain there.  */
+  unsigned nthreads = PARAM_VALUE (PARAM_LTO_DECL_IN_THREADS);
+  if (flag_ltrans || all_files.length () < 2)
+    nthreads = 0;
+  nthreads = MIN (nthreads, all_files.length ());
+
+  pthread_t *threads = XNEWVEC (pthread_t, nthreads + 1);
+  unsigned nstarted = 0;
+  if (nthreads)
+    {
+      decl_prefetch = XCNEWVEC (struct lto_decl_prefetch,
+				all_files.length ());
+      FOR_EACH_VEC_ELT (all_files, i, file_data)
+	{
+	  struct lto_section_slot *f_slot
+	    = find_section (file_data, LTO_section_decls, NULL);
+	  if (f_slot)
+	    {
+	      decl_prefetch[i].file_name = file_data->file_name;
+	      decl_prefetch[i].offset = f_slot->start;
+	      decl_prefetch[i].raw_len = f_slot->len;
+	    }
+	}
+      decl_prefetch_count = all_files.length ();
+      decl_prefetch_next = 0;
+      decl_prefetch_consumed = 0;
+      decl_prefetch_window = 2 * nthreads;
+
+      for (; nstarted < nthreads; nstarted++)
+	if (pthread_create (&threads[nstarted], NULL,
+			    lto_decl_prefetch_thread, NULL) != 0)
+	  break;
+      if (!nstarted)
+	{
+	  free (decl_prefetch);
+	  decl_prefetch = NULL;
+	}
+    }
+
+  FOR_EACH_VEC_ELT (all_files, i, file_data)
+    {
+      struct lto_decl_prefetch *prefetch = NULL;
+      if (decl_prefetch)
+	{
+	  prefetch = &decl_prefetch[i];
+	  pthread_mutex_lock (&decl_prefetch_lock);
+	  while (!prefetch->done)
+	    pthread_cond_wait (&decl_prefetch_cond, &decl_prefetch_lock);
+	  pthread_mutex_unlock (&decl_prefetch_lock);
+	}
+
+      lto_create_files_from_ids (file_data, prefetch, count);
+
+      if (decl_prefetch)
+	{
+	  pthread_mutex_lock (&decl_prefetch_lock);
+	  decl_prefetch_consumed = i + 1;
+	  pthread_cond_broadcast (&decl_prefetch_cond);
+	  pthread_mutex_unlock (&decl_prefetch_lock);
+	}
+    }
+
+  for (i = 0; i < nstarted; i++)
+    pthread_join (threads[i], NULL);
+  free (threads);
+  free (decl_prefetch);
+  decl_prefetch = NULL;
+#else
+  FOR_EACH_VEC_ELT (all_files, i, file_data)
+    lto_create_files_from_ids (file_data, NULL, count);
+#endif
+}
+
 static lto_file *current_lto_file;
 
 /* Helper for qsort; compare partitions and return one with smaller size.
@@ -2291,6 +2611,28 @@ do_stream_out (char *temp_filename, lto_symtab_encoder_t encoder)
   free (file);
 }
 
+/* Report on -fltrans-ready-fd that the LTRANS unit with index I has been
+   written to TEMP_FILENAME, so that lto-wrapper can start compiling it
+   while the other units are streamed out.  The line is written with a
+   single write so that the reports of the streaming processes do not
+   interleave.  */
+
+static void
+report_ltrans_unit (unsigned i, const char *temp_filename)
+{
+  char *line;
+  size_t len;
+
+  if (flag_ltrans_ready_fd < 0)
+    return;
+  line = xasprintf ("%u %s\n", i, temp_filename);
+  len = strlen (line);
+  if (write (flag_ltrans_ready_fd, line, len) != (ssize_t) len)
+    fatal_error (input_location, "reporting LTRANS unit %s: %m",
+		 temp_filename);
+  free (line);
+}
+
 /* Wait for forked process and signal errors.  */
 #ifdef HAVE_WORKING_FORK
 static void
@@ -2316,11 +2658,11 @@ wait_for_child ()
 }
 #endif
 
-/* Stream out ENCODER into TEMP_FILENAME
+/* Stream out ENCODER, the LTRANS unit with index I, into TEMP_FILENAME
    Fork if that seems to help.  */
 
 static void
-stream_out (char *temp_filename, lto_symtab_encoder_t encoder,
+stream_out (unsigned i, char *temp_filename, lto_symtab_encoder_t encoder,
 	    bool ARG_UNUSED (last))
 {
 #ifdef HAVE_WORKING_FORK
@@ -2329,6 +2671,7 @@ stream_out (char *temp_filename, lto_symtab_encoder_t encoder,
   if (lto_parallelism <= 1)
     {
       do_stream_out (temp_filename, encoder);
+      report_ltrans_unit (i, temp_filename);
       return;
     }
 
@@ -2349,25 +2692,36 @@ stream_out (char *temp_filename, lto_symtab_encoder_t encoder,
 	{
 	  setproctitle ("lto1-wpa-streaming");
 	  do_stream_out (temp_filename, encoder);
+	  report_ltrans_unit (i, temp_filename);
 	  exit (0);
 	}
       /* Fork failed; lets do the job ourseleves.  */
       else if (cpid == -1)
-        do_stream_out (temp_filename, encoder);
+	{
+	  do_stream_out (temp_filename, encoder);
+	  report_ltrans_unit (i, temp_filename);
+	}
       else
-	nruns++;
+	{
+	  /* The child streams out its own copy of the encoder; ours is
+	     not needed anymore.  */
+	  lto_symtab_encoder_delete (encoder);
+	  nruns++;
+	}
     }
   /* Last partition; stream it and wait for all children to die.  */
   else
     {
-      int i;
+      int j;
       do_stream_out (temp_filename, encoder);
-      for (i = 0; i < nruns; i++)
+      report_ltrans_unit (i, temp_filename);
+      for (j = 0; j < nruns; j++)
 	wait_for_child ();
     }
   asm_nodes_output = true;
 #else
   do_stream_out (temp_filename, encoder);
+  report_ltrans_unit (i, temp_filename);
 #endif
 }
 
@@ -2465,7 +2819,7 @@ lto_wpa_write_files (void)
 	}
       gcc_checking_assert (lto_symtab_encoder_size (part->encoder) || !i);
 
-      stream_out (temp_filename, part->encoder, i == n_sets - 1);
+      stream_out (i, temp_filename, part->encoder, i == n_sets - 1);
 
       part->encoder = NULL;
 
@@ -2794,7 +3148,7 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
       if (!current_lto_file)
 	break;
 
-      file_data = lto_file_read (current_lto_file, resolution, &count);
+      file_data = lto_file_read (current_lto_file, resolution);
       if (!file_data)
 	{
 	  lto_obj_file_close (current_lto_file);
@@ -2810,6 +3164,10 @@ read_cgraph_and_symbols (unsigned nfiles, const char **fnames)
       current_lto_file = NULL;
     }
 
+  /* Read the declarations of all the files, merging them in linker
+     order.  */
+  lto_read_all_decls (decl_data, last_file_ix, &count);
+
   lto_flatten_files (decl_data, count, last_file_ix);
   lto_stats.num_input_files = count;
   ggc_free(decl_data);
@@ -3110,10 +3468,12 @@ do_whole_program_analysis (void)
   else if (flag_lto_partition == LTO_PARTITION_MAX)
     lto_max_map ();
   else if (flag_lto_partition == LTO_PARTITION_ONE)
-    lto_balanced_map (1, INT_MAX);
+    lto_balanced_map (1, INT_MAX, false);
   else if (flag_lto_partition == LTO_PARTITION_BALANCED)
     lto_balanced_map (PARAM_VALUE (PARAM_LTO_PARTITIONS),
-		      PARAM_VALUE (MAX_PARTITION_SIZE));
+		      PARAM_VALUE (MAX_PARTITION_SIZE), false);
+  else if (flag_lto_partition == LTO_PARTITION_STABLE)
+    lto_balanced_map (INT_MAX, PARAM_VALUE (MAX_PARTITION_SIZE), true);
   else
     gcc_unreachable ();
 
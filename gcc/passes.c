@@ -2175,6 +2175,48 @@ execute_ipa_summary_passes (ipa_opt_pass_d *ipa_pass)
     }
 }
 
+/* Return true if the statistics of each pass are needed, for
+   -ftime-report-format=json or -fself-profile.  */
+
+static bool
+pass_stats_p (void)
+{
+  return (g_timer
+	  && (flag_time_report_format == TIME_REPORT_FORMAT_JSON
+	      || g_timer->tracing_p ()));
+}
+
+/* Start recording the statistics of PASS.  Return the peak size of the
+   GC heap so far, to be passed to pass_stats_end.  */
+
+static size_t
+pass_stats_start (opt_pass *pass)
+{
+  size_t outer_ggc_heap_peak = ggc_heap_peak ();
+  const char *function = NULL;
+
+  if (cfun)
+    function = (DECL_ASSEMBLER_NAME_SET_P (cfun->decl)
+		? IDENTIFIER_POINTER (DECL_ASSEMBLER_NAME (cfun->decl))
+		: function_name (cfun));
+
+  ggc_reset_heap_peak (0);
+  g_timer->push_pass (pass->name, pass->static_pass_number, function);
+  return outer_ggc_heap_peak;
+}
+
+/* Finish recording the statistics of the pass started last, given the
+   peak size of the GC heap before it, OUTER_GGC_HEAP_PEAK.  */
+
+static void
+pass_stats_end (size_t outer_ggc_heap_peak)
+{
+  size_t peak = ggc_heap_peak ();
+
+  g_timer->pop_pass (peak);
+  ggc_reset_heap_peak (MAX (outer_ggc_heap_peak, peak));
+}
+
 /* Execute IPA_PASS function transform on NODE.  */
 
 static void
@@ -2198,6 +2240,11 @@ execute_one_ipa_transform_pass (struct cgraph_node *node,
   if (pass->tv_id != TV_NONE)
     timevar_push (pass->tv_id);
 
+  bool record_stats = pass_stats_p ();
+  size_t outer_ggc_heap_peak = 0;
+  if (record_stats)
+    outer_ggc_heap_peak = pass_stats_start (pass);
+
   /* Run pre-pass verification.  */
   execute_todo (ipa_pass->function_transform_todo_flags_start);
 
@@ -2214,6 +2261,8 @@ execute_one_ipa_transform_pass (struct cgraph_node *node,
     check_profile_consistency (pass->static_pass_number, 1, true);
 
   /* Stop timevar.  */
+  if (record_stats)
+    pass_stats_end (outer_ggc_heap_peak);
   if (pass->tv_id != TV_NONE)
     timevar_pop (pass->tv_id);
 
@@ -2329,6 +2378,11 @@ execute_one_pass (opt_pass *pass)
   if (pass->tv_id != TV_NONE)
     timevar_push (pass->tv_id);
 
+  bool record_stats = pass_stats_p ();
+  size_t outer_ggc_heap_peak = 0;
+  if (record_stats)
+    outer_ggc_heap_peak = pass_stats_start (pass);
+
   /* Run pre-pass verification.  */
   execute_todo (pass->todo_flags_start);
 
@@ -2342,6 +2396,8 @@ execute_one_pass (opt_pass *pass)
   if (todo_after & TODO_discard_function)
     {
       /* Stop timevar.  */
+      if (record_stats)
+	pass_stats_end (outer_ggc_heap_peak);
       if (pass->tv_id != TV_NONE)
 	timevar_pop (pass->tv_id);
 
@@ -2384,6 +2440,8 @@ execute_one_pass (opt_pass *pass)
   verify_interpass_invariants ();
 
   /* Stop timevar.  */
+  if (record_stats)
+    pass_stats_end (outer_ggc_heap_peak);
   if (pass->tv_id != TV_NONE)
     timevar_pop (pass->tv_id);
 
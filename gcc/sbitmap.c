@@ -21,6 +21,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "system.h"
 #include "coretypes.h"
 #include "sbitmap.h"
+#include "selftest.h"
 
 typedef SBITMAP_ELT_TYPE *sbitmap_ptr;
 typedef const SBITMAP_ELT_TYPE *const_sbitmap_ptr;
@@ -32,6 +33,214 @@ static inline unsigned int sbitmap_size_bytes (const_sbitmap map)
    return map->size * sizeof (SBITMAP_ELT_TYPE);
 }
 
+/* Word-parallel kernels.
+
+   The dataflow solvers spend much of their time in the operations
+   below that combine two to four bitmaps word by word.  They all share
+   one loop, sbitmap_kernel, which operates on a vector of words at a
+   time when the host compiler supports generic vector types.  On x86
+   hosts a copy of the loop compiled for AVX2 is used when the processor
+   supports it, in the way libcpp picks its line scanner.  */
+
+/* The operations implemented by sbitmap_kernel.  */
+
+enum sbitmap_op
+{
+  SBITMAP_AND,			/* A & B  */
+  SBITMAP_IOR,			/* A | B  */
+  SBITMAP_XOR,			/* A ^ B  */
+  SBITMAP_OR_AND,		/* A | (B & C)  */
+  SBITMAP_AND_OR,		/* A & (B | C)  */
+  SBITMAP_IOR_AND_COMPL		/* A | (B & ~C)  */
+};
+
+/* Apply operation OP to A, B and C, which are words or vectors of
+   words.  */
+
+#define SBITMAP_APPLY(OP, A, B, C)			\
+  ((OP) == SBITMAP_AND ? (A) & (B)			\
+   : (OP) == SBITMAP_IOR ? (A) | (B)			\
+   : (OP) == SBITMAP_XOR ? (A) ^ (B)			\
+   : (OP) == SBITMAP_OR_AND ? (A) | ((B) & (C))		\
+   : (OP) == SBITMAP_AND_OR ? (A) & ((B) | (C))		\
+   : (A) | ((B) & ~(C)))
+
+#if GCC_VERSION >= 4008
+typedef SBITMAP_ELT_TYPE sbitmap_vec __attribute__ ((__vector_size__ (16)));
+#define SBITMAP_KERNEL_INLINE inline __attribute__ ((__always_inline__))
+#else
+typedef SBITMAP_ELT_TYPE sbitmap_vec;
+#define SBITMAP_KERNEL_INLINE inline
+#endif
+
+/* Set the N words at DST to OP applied to the words at A, B and C, and
+   return true if any of them changed.  V is the type used to operate
+   on several words at once.  C is only used by the operations on three
+   bitmaps.  DST may be the same as any of the sources.  */
+
+template <typename V, sbitmap_op OP>
+static SBITMAP_KERNEL_INLINE bool
+sbitmap_kernel (SBITMAP_ELT_TYPE *dst, const SBITMAP_ELT_TYPE *a,
+		const SBITMAP_ELT_TYPE *b, const SBITMAP_ELT_TYPE *c,
+		unsigned int n)
+{
+  const unsigned int step = sizeof (V) / sizeof (SBITMAP_ELT_TYPE);
+  const bool ternary = OP >= SBITMAP_OR_AND;
+  SBITMAP_ELT_TYPE changed_words[step];
+  SBITMAP_ELT_TYPE changed = 0;
+  V va, vb, vc, vdst, vtmp, vchanged;
+  unsigned int i;
+
+  /* Unaligned accesses through memcpy, which the compiler turns into
+     vector loads and stores.  */
+  memset (&vchanged, 0, sizeof (V));
+  for (i = 0; i + step <= n; i += step)
+    {
+      memcpy (&va, a + i, sizeof (V));
+      memcpy (&vb, b + i, sizeof (V));
+      if (ternary)
+	memcpy (&vc, c + i, sizeof (V));
+      else
+	vc = vb;
+      memcpy (&vdst, dst + i, sizeof (V));
+      vtmp = SBITMAP_APPLY (OP, va, vb, vc);
+      vchanged |= vdst ^ vtmp;
+      memcpy (dst + i, &vtmp, sizeof (V));
+    }
+
+  memcpy (changed_words, &vchanged, sizeof (V));
+  for (unsigned int j = 0; j < step; j++)
+    changed |= changed_words[j];
+
+  for (; i < n; i++)
+    {
+      const SBITMAP_ELT_TYPE tmp
+	= SBITMAP_APPLY (OP, a[i], b[i], ternary ? c[i] : b[i]);
+      changed |= dst[i] ^ tmp;
+      dst[i] = tmp;
+    }
+
+  return changed != 0;
+}
+
+/* Call sbitmap_kernel for operation OP, with vector type V.  */
+
+template <typename V>
+static SBITMAP_KERNEL_INLINE bool
+sbitmap_dispatch (sbitmap_op op, SBITMAP_ELT_TYPE *dst,
+		  const SBITMAP_ELT_TYPE *a, const SBITMAP_ELT_TYPE *b,
+		  const SBITMAP_ELT_TYPE *c, unsigned int n)
+{
+  switch (op)
+    {
+    case SBITMAP_AND:
+      return sbitmap_kernel<V, SBITMAP_AND> (dst, a, b, c, n);
+    case SBITMAP_IOR:
+      return sbitmap_kernel<V, SBITMAP_IOR> (dst, a, b, c, n);
+    case SBITMAP_XOR:
+      return sbitmap_kernel<V, SBITMAP_XOR> (dst, a, b, c, n);
+    case SBITMAP_OR_AND:
+      return sbitmap_kernel<V, SBITMAP_OR_AND> (dst, a, b, c, n);
+    case SBITMAP_AND_OR:
+      return sbitmap_kernel<V, SBITMAP_AND_OR> (dst, a, b, c, n);
+    case SBITMAP_IOR_AND_COMPL:
+      return sbitmap_kernel<V, SBITMAP_IOR_AND_COMPL> (dst, a, b, c, n);
+    default:
+      gcc_unreachable ();
+    }
+}
+
+/* See the comment in libcpp/lex.c about the conditions under which
+   x86 code for other ISAs can be compiled into the host compiler.  */
+
+#if (GCC_VERSION >= 4008) && (__GNUC__ >= 5 || !defined(__PIC__)) \
+    && (defined(__i386__) || defined(__x86_64__)) \
+    && !(defined(__sun__) && defined(__svr4__))
+#define HAVE_sbitmap_kernel_avx2 1
+
+typedef SBITMAP_ELT_TYPE sbitmap_vec_avx2
+  __attribute__ ((__vector_size__ (32)));
+
+/* Nonzero if the processor supports AVX2, -1 if not known yet.  */
+
+static int sbitmap_use_avx2 = -1;
+
+/* sbitmap_dispatch compiled for AVX2.  */
+
+static bool
+#ifndef __AVX2__
+__attribute__ ((__target__ ("avx2")))
+#endif
+sbitmap_kernel_avx2 (sbitmap_op op, SBITMAP_ELT_TYPE *dst,
+		     const SBITMAP_ELT_TYPE *a, const SBITMAP_ELT_TYPE *b,
+		     const SBITMAP_ELT_TYPE *c, unsigned int n)
+{
+  return sbitmap_dispatch<sbitmap_vec_avx2> (op, dst, a, b, c, n);
+}
+#endif
+
+/* Set the N words at DST to OP applied to the words at A, B and C, and
+   return true if any of them changed.  */
+
+static bool
+sbitmap_combine (sbitmap_op op, SBITMAP_ELT_TYPE *dst,
+		 const SBITMAP_ELT_TYPE *a, const SBITMAP_ELT_TYPE *b,
+		 const SBITMAP_ELT_TYPE *c, unsigned int n)
+{
+#ifdef HAVE_sbitmap_kernel_avx2
+  if (sbitmap_use_avx2 < 0)
+    {
+      __builtin_cpu_init ();
+      sbitmap_use_avx2 = __builtin_cpu_supports ("avx2") != 0;
+    }
+  if (sbitmap_use_avx2)
+    return sbitmap_kernel_avx2 (op, dst, a, b, c, n);
+#endif
+  return sbitmap_dispatch<sbitmap_vec> (op, dst, a, b, c, n);
+}
+
+/* Number of words of DST that sbitmap_combine_n combines from all the
+   sources before moving on to the next words.  */
+
+#define SBITMAP_BLOCK_WORDS 64
+
+/* Set DST to the intersection, if OP is SBITMAP_AND, or the union, if OP
+   is SBITMAP_IOR, of the N bitmaps in SRCS.  Work on a block of words at
+   a time, so that each block of DST stays in cache while all of the
+   sources are combined into it.  DST may be one of the sources.  */
+
+static void
+sbitmap_combine_n (sbitmap_op op, sbitmap dst, const_sbitmap *srcs,
+		   unsigned int n)
+{
+  unsigned int size = dst->size;
+  unsigned int first = 0;
+
+  gcc_checking_assert (n > 0);
+
+  /* Both operations are commutative, so start from DST if it is one of
+     the sources rather than overwriting it.  */
+  for (unsigned int j = 0; j < n; j++)
+    if (srcs[j] == dst)
+      {
+	first = j;
+	break;
+      }
+
+  for (unsigned int i = 0; i < size; i += SBITMAP_BLOCK_WORDS)
+    {
+      unsigned int len = MIN (size - i, SBITMAP_BLOCK_WORDS);
+      SBITMAP_ELT_TYPE *block = dst->elms + i;
+
+      if (srcs[first] != dst)
+	memcpy (block, srcs[first]->elms + i,
+		len * sizeof (SBITMAP_ELT_TYPE));
+      for (unsigned int j = 0; j < n; j++)
+	if (j != first)
+	  sbitmap_combine (op, block, block, srcs[j]->elms + i, NULL, len);
+    }
+}
+
 
 /* Bitmap manipulation routines.  */
 
@@ -255,21 +464,8 @@ bitmap_vector_ones (sbitmap *bmap, unsigned int n_vecs)
 bool
 bitmap_ior_and_compl (sbitmap dst, const_sbitmap a, const_sbitmap b, const_sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & ~*cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  return sbitmap_combine (SBITMAP_IOR_AND_COMPL, dst->elms, a->elms, b->elms,
+			  c->elms, dst->size);
 }
 
 /* Set bitmap DST to the bitwise negation of the bitmap SRC.  */
@@ -343,20 +539,8 @@ bitmap_intersect_p (const_sbitmap a, const_sbitmap b)
 bool
 bitmap_and (sbitmap dst, const_sbitmap a, const_sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ & *bp++;
-      SBITMAP_ELT_TYPE wordchanged = *dstp ^ tmp;
-      *dstp++ = tmp;
-      changed |= wordchanged;
-    }
-  return changed != 0;
+  return sbitmap_combine (SBITMAP_AND, dst->elms, a->elms, b->elms, NULL,
+			  dst->size);
 }
 
 /* Set DST to be (A xor B)).
@@ -365,20 +549,8 @@ bitmap_and (sbitmap dst, const_sbitmap a, const_sbitmap b)
 bool
 bitmap_xor (sbitmap dst, const_sbitmap a, const_sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ ^ *bp++;
-      SBITMAP_ELT_TYPE wordchanged = *dstp ^ tmp;
-      *dstp++ = tmp;
-      changed |= wordchanged;
-    }
-  return changed != 0;
+  return sbitmap_combine (SBITMAP_XOR, dst->elms, a->elms, b->elms, NULL,
+			  dst->size);
 }
 
 /* Set DST to be (A or B)).
@@ -387,20 +559,26 @@ bitmap_xor (sbitmap dst, const_sbitmap a, const_sbitmap b)
 bool
 bitmap_ior (sbitmap dst, const_sbitmap a, const_sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
+  return sbitmap_combine (SBITMAP_IOR, dst->elms, a->elms, b->elms, NULL,
+			  dst->size);
+}
 
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ | *bp++;
-      SBITMAP_ELT_TYPE wordchanged = *dstp ^ tmp;
-      *dstp++ = tmp;
-      changed |= wordchanged;
-    }
-  return changed != 0;
+/* Set DST to the intersection of the N bitmaps in SRCS, making a single
+   pass over DST.  N must be positive, and DST may be one of SRCS.  */
+
+void
+bitmap_and_n (sbitmap dst, const_sbitmap *srcs, unsigned int n)
+{
+  sbitmap_combine_n (SBITMAP_AND, dst, srcs, n);
+}
+
+/* Set DST to the union of the N bitmaps in SRCS, making a single pass
+   over DST.  N must be positive, and DST may be one of SRCS.  */
+
+void
+bitmap_ior_n (sbitmap dst, const_sbitmap *srcs, unsigned int n)
+{
+  sbitmap_combine_n (SBITMAP_IOR, dst, srcs, n);
 }
 
 /* Return nonzero if A is a subset of B.  */
@@ -424,21 +602,8 @@ bitmap_subset_p (const_sbitmap a, const_sbitmap b)
 bool
 bitmap_or_and (sbitmap dst, const_sbitmap a, const_sbitmap b, const_sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & *cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  return sbitmap_combine (SBITMAP_OR_AND, dst->elms, a->elms, b->elms, c->elms,
+			  dst->size);
 }
 
 /* Set DST to be (A and (B or C)).
@@ -447,21 +612,8 @@ bitmap_or_and (sbitmap dst, const_sbitmap a, const_sbitmap b, const_sbitmap c)
 bool
 bitmap_and_or (sbitmap dst, const_sbitmap a, const_sbitmap b, const_sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      const SBITMAP_ELT_TYPE tmp = *ap++ & (*bp++ | *cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  return sbitmap_combine (SBITMAP_AND_OR, dst->elms, a->elms, b->elms, c->elms,
+			  dst->size);
 }
 
 /* Return number of first bit set in the bitmap, -1 if none.  */
@@ -604,3 +756,251 @@ dump_bitmap_vector (FILE *file, const char *title, const char *subtitle,
 
   fprintf (file, "\n");
 }
+
+#if CHECKING_P
+
+namespace selftest {
+
+/* Fill BMAP with pseudo-random bits drawn from *SEED.  */
+
+static void
+fill_random (sbitmap bmap, unsigned int *seed)
+{
+  for (unsigned int i = 0; i < bmap->size; i++)
+    {
+      SBITMAP_ELT_TYPE word = 0;
+      for (unsigned int j = 0; j < sizeof (word); j++)
+	{
+	  *seed = *seed * 1103515245 + 12345;
+	  word = (word << 8) | ((*seed >> 16) & 0xff);
+	}
+      bmap->elms[i] = word;
+    }
+}
+
+/* Set DST to operation OP of A, B and C using the public functions, and
+   return what they return.  */
+
+static bool
+apply_op (sbitmap_op op, sbitmap dst, const_sbitmap a, const_sbitmap b,
+	  const_sbitmap c)
+{
+  switch (op)
+    {
+    case SBITMAP_AND:
+      return bitmap_and (dst, a, b);
+    case SBITMAP_IOR:
+      return bitmap_ior (dst, a, b);
+    case SBITMAP_XOR:
+      return bitmap_xor (dst, a, b);
+    case SBITMAP_OR_AND:
+      return bitmap_or_and (dst, a, b, c);
+    case SBITMAP_AND_OR:
+      return bitmap_and_or (dst, a, b, c);
+    case SBITMAP_IOR_AND_COMPL:
+      return bitmap_ior_and_compl (dst, a, b, c);
+    default:
+      gcc_unreachable ();
+    }
+}
+
+/* Return operation OP of the words A, B and C.  */
+
+static SBITMAP_ELT_TYPE
+expected_word (sbitmap_op op, SBITMAP_ELT_TYPE a, SBITMAP_ELT_TYPE b,
+	       SBITMAP_ELT_TYPE c)
+{
+  switch (op)
+    {
+    case SBITMAP_AND:
+      return a & b;
+    case SBITMAP_IOR:
+      return a | b;
+    case SBITMAP_XOR:
+      return a ^ b;
+    case SBITMAP_OR_AND:
+      return a | (b & c);
+    case SBITMAP_AND_OR:
+      return a & (b | c);
+    case SBITMAP_IOR_AND_COMPL:
+      return a | (b & ~c);
+    default:
+      gcc_unreachable ();
+    }
+}
+
+/* Bitmap sizes, in bits, around the multiples of the number of words
+   processed at once by the kernels and by sbitmap_combine_n.  */
+
+static const unsigned int test_sizes[] = {
+  1, 63, 64, 65, 127, 128, 129, 191, 256, 257, 320, 1000,
+  2 * SBITMAP_BLOCK_WORDS * SBITMAP_ELT_BITS + 100
+};
+
+/* Verify the operations on two and three bitmaps, including whether
+   they report a change, and with the destination also being a
+   source.  */
+
+static void
+test_kernels ()
+{
+  unsigned int seed = 1;
+
+  for (unsigned int s = 0; s < ARRAY_SIZE (test_sizes); s++)
+    {
+      unsigned int n = test_sizes[s];
+      sbitmap a = sbitmap_alloc (n);
+      sbitmap b = sbitmap_alloc (n);
+      sbitmap c = sbitmap_alloc (n);
+      sbitmap dst = sbitmap_alloc (n);
+      sbitmap expected = sbitmap_alloc (n);
+
+      for (int op = SBITMAP_AND; op <= SBITMAP_IOR_AND_COMPL; op++)
+	{
+	  sbitmap_op sop = (sbitmap_op) op;
+	  fill_random (a, &seed);
+	  fill_random (b, &seed);
+	  fill_random (c, &seed);
+	  fill_random (dst, &seed);
+	  for (unsigned int i = 0; i < expected->size; i++)
+	    expected->elms[i] = expected_word (sop, a->elms[i], b->elms[i],
+					       c->elms[i]);
+
+	  ASSERT_TRUE (apply_op (sop, dst, a, b, c));
+	  ASSERT_TRUE (bitmap_equal_p (dst, expected));
+	  ASSERT_FALSE (apply_op (sop, dst, a, b, c));
+
+	  /* Change a single bit of the destination, at its end.  */
+	  bitmap_copy (dst, expected);
+	  dst->elms[dst->size - 1] ^= 1;
+	  ASSERT_TRUE (apply_op (sop, dst, a, b, c));
+	  ASSERT_TRUE (bitmap_equal_p (dst, expected));
+
+	  bitmap_copy (dst, a);
+	  apply_op (sop, dst, dst, b, c);
+	  ASSERT_TRUE (bitmap_equal_p (dst, expected));
+	}
+
+      sbitmap_free (a);
+      sbitmap_free (b);
+      sbitmap_free (c);
+      sbitmap_free (dst);
+      sbitmap_free (expected);
+    }
+}
+
+/* Verify bitmap_and_n and bitmap_ior_n against repeated bitmap_and and
+   bitmap_ior.  */
+
+static void
+test_and_ior_n ()
+{
+  unsigned int seed = 2;
+
+  for (unsigned int s = 0; s < ARRAY_SIZE (test_sizes); s++)
+    {
+      unsigned int n = test_sizes[s];
+      auto_sbitmap s0 (n), s1 (n), s2 (n), s3 (n), dst (n), expected (n);
+      sbitmap bmaps[] = { s0, s1, s2, s3 };
+      const_sbitmap srcs[] = { s0, s1, s2, s3 };
+
+      for (unsigned int count = 1; count <= ARRAY_SIZE (srcs); count++)
+	{
+	  fill_random (s0, &seed);
+	  fill_random (s1, &seed);
+	  fill_random (s2, &seed);
+	  fill_random (s3, &seed);
+
+	  bitmap_copy (expected, s0);
+	  for (unsigned int i = 1; i < count; i++)
+	    bitmap_and (expected, expected, srcs[i]);
+	  bitmap_and_n (dst, srcs, count);
+	  ASSERT_TRUE (bitmap_equal_p (dst, expected));
+
+	  bitmap_copy (expected, s0);
+	  for (unsigned int i = 1; i < count; i++)
+	    bitmap_ior (expected, expected, srcs[i]);
+	  bitmap_ior_n (dst, srcs, count);
+	  ASSERT_TRUE (bitmap_equal_p (dst, expected));
+
+	  /* The destination may be any of the sources.  */
+	  sbitmap last = bmaps[count - 1];
+	  bitmap_ior_n (last, srcs, count);
+	  ASSERT_TRUE (bitmap_equal_p (last, expected));
+	}
+    }
+}
+
+/* The number of bits in the bitmaps timed by the benchmarks below.  */
+
+static const unsigned int bench_bitmap_size = 8192;
+
+/* Benchmark: bitmap_and of two random bitmaps.  */
+
+static void
+bench_and (unsigned int iterations)
+{
+  unsigned int seed = 3;
+  auto_sbitmap a (bench_bitmap_size), b (bench_bitmap_size);
+  auto_sbitmap dst (bench_bitmap_size);
+  fill_random (a, &seed);
+  fill_random (b, &seed);
+
+  size_t changed = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    changed += bitmap_and (dst, a, (i & 1) ? b : a);
+  benchmark_consume (changed);
+}
+
+/* Benchmark: the intersection of four random bitmaps, as computed by
+   the meet over the predecessors of a block.  */
+
+static void
+bench_and_n (unsigned int iterations)
+{
+  unsigned int seed = 4;
+  auto_sbitmap s0 (bench_bitmap_size), s1 (bench_bitmap_size);
+  auto_sbitmap s2 (bench_bitmap_size), s3 (bench_bitmap_size);
+  auto_sbitmap dst (bench_bitmap_size);
+  const_sbitmap srcs[] = { s0, s1, s2, s3 };
+  fill_random (s0, &seed);
+  fill_random (s1, &seed);
+  fill_random (s2, &seed);
+  fill_random (s3, &seed);
+
+  for (unsigned int i = 0; i < iterations; i++)
+    bitmap_and_n (dst, srcs, ARRAY_SIZE (srcs));
+  benchmark_consume (bitmap_first_set_bit (dst));
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+sbitmap_c_benchmarks ()
+{
+  run_benchmark ("sbitmap/and", bench_and);
+  run_benchmark ("sbitmap/and_n", bench_and_n);
+}
+
+/* Run all of the selftests within this file.  */
+
+void
+sbitmap_c_tests ()
+{
+  test_kernels ();
+  test_and_ior_n ();
+
+#ifdef HAVE_sbitmap_kernel_avx2
+  /* Also test the generic kernels if the AVX2 ones were in use.  */
+  if (sbitmap_use_avx2 > 0)
+    {
+      sbitmap_use_avx2 = 0;
+      test_kernels ();
+      test_and_ior_n ();
+      sbitmap_use_avx2 = 1;
+    }
+#endif
+}
+
+} // namespace selftest
+#endif /* CHECKING_P */
@@ -59,6 +59,12 @@ along with GCC; see the file COPYING3.  If not see
       * A | (B & ~C)		: bitmap_ior_and_compl
       * A & (B | C)		: bitmap_and_or
 
+   as are the intersection and union of many sets, in a single pass
+   over the target set:
+
+      * A[0] & ... & A[N-1]	: bitmap_and_n
+      * A[0] | ... | A[N-1]	: bitmap_ior_n
+
    Most of the set functions have two variants: One that returns non-zero
    if members were added or removed from the target set, and one that just
    performs the operation without feedback.  The former operations are a
@@ -249,6 +255,8 @@ extern bool bitmap_intersect_p (const_sbitmap, const_sbitmap);
 extern bool bitmap_and (sbitmap, const_sbitmap, const_sbitmap);
 extern bool bitmap_ior (sbitmap, const_sbitmap, const_sbitmap);
 extern bool bitmap_xor (sbitmap, const_sbitmap, const_sbitmap);
+extern void bitmap_and_n (sbitmap, const_sbitmap *, unsigned int);
+extern void bitmap_ior_n (sbitmap, const_sbitmap *, unsigned int);
 extern bool bitmap_subset_p (const_sbitmap, const_sbitmap);
 
 extern int bitmap_first_set_bit (const_sbitmap);
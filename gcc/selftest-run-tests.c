@@ -47,7 +47,9 @@ selftest::run_tests ()
 
   /* Low-level data structures.  */
   bitmap_c_tests ();
+  sbitmap_c_tests ();
   et_forest_c_tests ();
+  hash_table_tests_c_tests ();
   hash_map_tests_c_tests ();
   hash_set_tests_c_tests ();
   vec_c_tests ();
@@ -57,6 +59,8 @@ selftest::run_tests ()
   sreal_c_tests ();
   fibonacci_heap_c_tests ();
   typed_splay_tree_c_tests ();
+  lto_compress_c_tests ();
+  timevar_c_tests ();
 
   /* Mid-level data structures.  */
   input_c_tests ();
@@ -90,4 +94,37 @@ selftest::run_tests ()
 	   elapsed_time / 1000000, elapsed_time % 1000000);
 }
 
+/* Run all benchmarks, printing the results as JSON if JSON.  */
+
+void
+selftest::run_benchmarks (bool json)
+{
+  long start_time = get_run_time ();
+
+  start_benchmarks (json);
+
+  /* Low-level data structures.  */
+  bitmap_c_benchmarks ();
+  sbitmap_c_benchmarks ();
+  hash_table_tests_c_benchmarks ();
+  hash_map_tests_c_benchmarks ();
+  vec_c_benchmarks ();
+  alloc_pool_c_benchmarks ();
+  ggc_tests_c_benchmarks ();
+  wide_int_cc_benchmarks ();
+
+  /* The lexer.  */
+  input_c_benchmarks ();
+
+  finish_benchmarks ();
+
+  long finish_time = get_run_time ();
+  long elapsed_time = finish_time - start_time;
+
+  if (!json)
+    fprintf (stderr,
+	     "-fself-test=bench: finished in %ld.%06ld seconds\n",
+	     elapsed_time / 1000000, elapsed_time % 1000000);
+}
+
 #endif /* #if CHECKING_P */
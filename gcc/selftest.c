@@ -118,6 +118,124 @@ assert_str_contains (const location &loc,
 	 desc_haystack, desc_needle, val_haystack, val_needle);
 }
 
+/* Minimum duration of a single timed run of a benchmark, in
+   microseconds, so that the resolution of the timer does not matter.  */
+
+static const long benchmark_min_run_time = 20000;
+
+/* The number of timed runs of each benchmark, of which the median is
+   reported.  Odd, so that the median is one of the runs.  */
+
+static const int benchmark_num_runs = 11;
+
+/* Whether run_benchmark prints JSON, and how many benchmarks it has
+   printed so far.  */
+
+static bool benchmark_json_p;
+static unsigned int num_benchmarks;
+
+/* Where benchmark_consume puts the values it is given.  */
+
+static volatile size_t benchmark_sink;
+
+/* Begin the report printed by run_benchmark, as JSON if JSON.  */
+
+void
+start_benchmarks (bool json)
+{
+  benchmark_json_p = json;
+  num_benchmarks = 0;
+  if (json)
+    fprintf (stderr, "{\n  \"benchmarks\": [");
+  else
+    fprintf (stderr, "%-32s %12s %12s %12s %12s\n",
+	     "Benchmark", "ns/op", "min ns/op", "max ns/op", "iterations");
+}
+
+/* End the report printed by run_benchmark.  */
+
+void
+finish_benchmarks ()
+{
+  if (benchmark_json_p)
+    fprintf (stderr, "%s]\n}\n", num_benchmarks ? "\n  " : "");
+}
+
+/* Prevent a benchmark's result VALUE from being optimized away.  */
+
+void
+benchmark_consume (size_t value)
+{
+  benchmark_sink = benchmark_sink + value;
+}
+
+/* Return the CPU time, in microseconds, taken by ITERATIONS
+   iterations of FN.  */
+
+static long
+time_benchmark (benchmark_fn fn, unsigned int iterations)
+{
+  long start_time = get_run_time ();
+  fn (iterations);
+  return get_run_time () - start_time;
+}
+
+/* qsort callback for sorting an array of doubles.  */
+
+static int
+compare_doubles (const void *p1, const void *p2)
+{
+  double d1 = *(const double *) p1;
+  double d2 = *(const double *) p2;
+  return d1 < d2 ? -1 : d1 > d2;
+}
+
+/* Time FN, and print its median cost per iteration under NAME, along
+   with the fastest and slowest runs.  */
+
+void
+run_benchmark (const char *name, benchmark_fn fn)
+{
+  /* Find an iteration count for which a run lasts at least
+     benchmark_min_run_time, aiming a little above it but growing by
+     no more than a factor of 10 at each step.  This also warms up
+     the caches and the allocators.  */
+  const unsigned int max_iterations = 1U << 30;
+  unsigned int iterations = 1;
+  for (;;)
+    {
+      long elapsed = time_benchmark (fn, iterations);
+      if (elapsed >= benchmark_min_run_time || iterations >= max_iterations)
+	break;
+      unsigned HOST_WIDE_INT next = iterations * (unsigned HOST_WIDE_INT) 10;
+      if (elapsed > 0)
+	next = MIN (next, ((unsigned HOST_WIDE_INT) iterations
+			   * benchmark_min_run_time * 6 / 5 / elapsed));
+      next = MAX (next, (unsigned HOST_WIDE_INT) iterations + 1);
+      iterations = MIN (next, max_iterations);
+    }
+
+  double ns_per_op[benchmark_num_runs];
+  for (int i = 0; i < benchmark_num_runs; i++)
+    ns_per_op[i] = time_benchmark (fn, iterations) * 1000.0 / iterations;
+  qsort (ns_per_op, benchmark_num_runs, sizeof (double), compare_doubles);
+
+  double median = ns_per_op[benchmark_num_runs / 2];
+  double fastest = ns_per_op[0];
+  double slowest = ns_per_op[benchmark_num_runs - 1];
+  if (benchmark_json_p)
+    fprintf (stderr,
+	     "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f,"
+	     " \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f,"
+	     " \"iterations\": %u, \"runs\": %d}",
+	     num_benchmarks ? "," : "", name, median, fastest, slowest,
+	     iterations, benchmark_num_runs);
+  else
+    fprintf (stderr, "%-32s %12.3f %12.3f %12.3f %12u\n",
+	     name, median, fastest, slowest, iterations);
+  num_benchmarks++;
+}
+
 /* Constructor.  Generate a name for the file.  */
 
 named_temp_file::named_temp_file (const char *suffix)
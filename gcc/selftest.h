@@ -50,6 +50,30 @@ struct location
 
 extern void run_tests ();
 
+/* The entrypoint for running all benchmarks, for -fself-test=bench.
+   Print the results as JSON if JSON is true, otherwise as text.  */
+
+extern void run_benchmarks (bool json);
+
+/* Begin and end the report printed by run_benchmark.  */
+
+extern void start_benchmarks (bool json);
+extern void finish_benchmarks ();
+
+/* A timing kernel for -fself-test=bench.  It should perform the
+   operation being measured ITERATIONS times, from a deterministic
+   starting state, so that results are repeatable.  */
+
+typedef void (*benchmark_fn) (unsigned int iterations);
+
+/* Time FN, reporting the median cost per iteration under NAME.  */
+
+extern void run_benchmark (const char *name, benchmark_fn fn);
+
+/* Prevent a benchmark's result VALUE from being optimized away.  */
+
+extern void benchmark_consume (size_t value);
+
 /* Record the successful outcome of some aspect of the test.  */
 
 extern void pass (const location &loc, const char *msg);
@@ -160,12 +184,16 @@ extern void gimple_c_tests ();
 extern void ggc_tests_c_tests ();
 extern void hash_map_tests_c_tests ();
 extern void hash_set_tests_c_tests ();
+extern void hash_table_tests_c_tests ();
 extern void input_c_tests ();
+extern void lto_compress_c_tests ();
 extern void pretty_print_c_tests ();
 extern void rtl_tests_c_tests ();
+extern void sbitmap_c_tests ();
 extern void selftest_c_tests ();
 extern void spellcheck_c_tests ();
 extern void spellcheck_tree_c_tests ();
+extern void timevar_c_tests ();
 extern void sreal_c_tests ();
 extern void typed_splay_tree_c_tests ();
 extern void tree_c_tests ();
@@ -173,6 +201,18 @@ extern void tree_cfg_c_tests ();
 extern void vec_c_tests ();
 extern void wide_int_cc_tests ();
 
+/* Declarations for the benchmarks of specific source files, in
+   alphabetical order.  */
+extern void alloc_pool_c_benchmarks ();
+extern void bitmap_c_benchmarks ();
+extern void ggc_tests_c_benchmarks ();
+extern void hash_map_tests_c_benchmarks ();
+extern void hash_table_tests_c_benchmarks ();
+extern void input_c_benchmarks ();
+extern void sbitmap_c_benchmarks ();
+extern void vec_c_benchmarks ();
+extern void wide_int_cc_benchmarks ();
+
 extern int num_passes;
 
 } /* end of namespace selftest.  */
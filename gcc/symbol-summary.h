@@ -250,4 +250,294 @@ gt_pch_nx(function_summary<T *>* const& summary, gt_pointer_operator op,
   gt_pch_nx (&summary->m_map, op, cookie);
 }
 
+/* Tell whether vectors with allocator V live in GC memory.  */
+
+template <typename V>
+struct summary_vec_ggc
+{
+  static const bool value = false;
+};
+
+template <>
+struct summary_vec_ggc <va_gc>
+{
+  static const bool value = true;
+};
+
+/* A function summary like function_summary, but stored in a vector
+   indexed by the summary uid of a node.  Summary uids of removed nodes are
+   recycled by the symbol table, so the vector stays about as long as the
+   number of nodes and a lookup is a single load.  V is the allocator of
+   the vector: va_gc for summaries allocated in GC memory, va_heap
+   otherwise.  */
+
+template <class T, class V = va_heap>
+class fast_function_summary
+{
+private:
+  fast_function_summary();
+};
+
+template <class T, class V>
+class GTY((user)) fast_function_summary <T *, V>
+{
+public:
+  /* Default construction takes SYMTAB as an argument.  */
+  fast_function_summary (symbol_table *symtab): m_vector (NULL),
+    m_elements (0), m_insertion_enabled (true), m_symtab (symtab)
+  {
+    m_symtab_insertion_hook =
+      symtab->add_cgraph_insertion_hook
+      (fast_function_summary::symtab_insertion, this);
+
+    m_symtab_removal_hook =
+      symtab->add_cgraph_removal_hook
+      (fast_function_summary::symtab_removal, this);
+    m_symtab_duplication_hook =
+      symtab->add_cgraph_duplication_hook
+      (fast_function_summary::symtab_duplication, this);
+  }
+
+  /* Destructor.  */
+  virtual ~fast_function_summary ()
+  {
+    release ();
+  }
+
+  /* Destruction method that can be called for GGT purpose.  */
+  void release ()
+  {
+    if (m_symtab_insertion_hook)
+      m_symtab->remove_cgraph_insertion_hook (m_symtab_insertion_hook);
+
+    if (m_symtab_removal_hook)
+      m_symtab->remove_cgraph_removal_hook (m_symtab_removal_hook);
+
+    if (m_symtab_duplication_hook)
+      m_symtab->remove_cgraph_duplication_hook (m_symtab_duplication_hook);
+
+    m_symtab_insertion_hook = NULL;
+    m_symtab_removal_hook = NULL;
+    m_symtab_duplication_hook = NULL;
+
+    /* Release all summaries.  */
+    for (unsigned i = 0; i < vec_safe_length (m_vector); i++)
+      if ((*m_vector)[i] != NULL)
+	release ((*m_vector)[i]);
+    vec_free (m_vector);
+    m_elements = 0;
+  }
+
+  /* Traverses all summarys with a function F called with
+     ARG as argument.  */
+  template<typename Arg, bool (*f)(const T &, Arg)>
+  void traverse (Arg a) const
+  {
+    for (unsigned i = 0; i < vec_safe_length (m_vector); i++)
+      if ((*m_vector)[i] != NULL && !f (*(*m_vector)[i], a))
+	break;
+  }
+
+  /* Basic implementation of insert operation.  */
+  virtual void insert (cgraph_node *, T *) {}
+
+  /* Basic implementation of removal operation.  */
+  virtual void remove (cgraph_node *, T *) {}
+
+  /* Basic implementation of duplication operation.  */
+  virtual void duplicate (cgraph_node *, cgraph_node *, T *, T *) {}
+
+  /* Allocates new data that are stored within the vector.  */
+  T* allocate_new ()
+  {
+    return is_ggc () ? new (ggc_alloc <T> ()) T() : new T () ;
+  }
+
+  /* Release an item that is stored within the vector.  */
+  void release (T *item)
+  {
+    if (is_ggc ())
+      {
+	item->~T ();
+	ggc_free (item);
+      }
+    else
+      delete item;
+  }
+
+  /* Getter for summary callgraph node pointer.  */
+  T* get (cgraph_node *node)
+  {
+    gcc_checking_assert (node->summary_uid);
+    return get (node->summary_uid);
+  }
+
+  /* Return true if NODE has a summary.  */
+  bool exists (cgraph_node *node)
+  {
+    int uid = node->summary_uid;
+    return (unsigned) uid < vec_safe_length (m_vector)
+	   && (*m_vector)[uid] != NULL;
+  }
+
+  /* Return number of elements handled by data structure.  */
+  size_t elements ()
+  {
+    return m_elements;
+  }
+
+  /* Enable insertion hook invocation.  */
+  void enable_insertion_hook ()
+  {
+    m_insertion_enabled = true;
+  }
+
+  /* Enable insertion hook invocation.  */
+  void disable_insertion_hook ()
+  {
+    m_insertion_enabled = false;
+  }
+
+  /* Symbol insertion hook that is registered to symbol table.  */
+  static void symtab_insertion (cgraph_node *node, void *data)
+  {
+    gcc_checking_assert (node->summary_uid);
+    fast_function_summary *summary = (fast_function_summary <T *, V> *) (data);
+
+    if (summary->m_insertion_enabled)
+      summary->insert (node, summary->get (node));
+  }
+
+  /* Symbol removal hook that is registered to symbol table.  */
+  static void symtab_removal (cgraph_node *node, void *data)
+  {
+    gcc_checking_assert (node->summary_uid);
+    fast_function_summary *summary = (fast_function_summary <T *, V> *) (data);
+
+    if (summary->exists (node))
+      {
+	T *v = (*summary->m_vector)[node->summary_uid];
+	summary->remove (node, v);
+
+	if (!is_ggc ())
+	  delete v;
+
+	(*summary->m_vector)[node->summary_uid] = NULL;
+	summary->m_elements--;
+      }
+  }
+
+  /* Symbol duplication hook that is registered to symbol table.  */
+  static void symtab_duplication (cgraph_node *node, cgraph_node *node2,
+				  void *data)
+  {
+    fast_function_summary *summary = (fast_function_summary <T *, V> *) (data);
+
+    gcc_checking_assert (node2->summary_uid > 0);
+
+    if (summary->exists (node))
+      {
+	/* This load is necessary, because the vector may be reallocated.  */
+	T *data = (*summary->m_vector)[node->summary_uid];
+	T *duplicate = summary->get (node2);
+	summary->duplicate (node, node2, data, duplicate);
+      }
+  }
+
+protected:
+  /* Return true if summaries are allocated in GC memory.  */
+  static bool is_ggc ()
+  {
+    return summary_vec_ggc <V>::value;
+  }
+
+private:
+  /* Getter for summary callgraph ID.  */
+  T* get (int uid)
+  {
+    if ((unsigned) uid >= vec_safe_length (m_vector))
+      {
+	/* Leave room for the uids that the symbol table hands out next.  */
+	unsigned len = MAX ((unsigned) uid + 1,
+			    (unsigned) m_symtab->cgraph_max_summary_uid);
+	vec_safe_grow_cleared (m_vector, len);
+      }
+
+    T **v = &(*m_vector)[uid];
+    if (*v == NULL)
+      {
+	*v = allocate_new ();
+	m_elements++;
+      }
+
+    return *v;
+  }
+
+  /* Main summary store, where summary ID is used as index.  */
+  vec <T *, V, vl_embed> *m_vector;
+  /* Number of summaries in the vector.  */
+  size_t m_elements;
+  /* Internal summary insertion hook pointer.  */
+  cgraph_node_hook_list *m_symtab_insertion_hook;
+  /* Internal summary removal hook pointer.  */
+  cgraph_node_hook_list *m_symtab_removal_hook;
+  /* Internal summary duplication hook pointer.  */
+  cgraph_2node_hook_list *m_symtab_duplication_hook;
+  /* Indicates if insertion hook is enabled.  */
+  bool m_insertion_enabled;
+  /* Symbol table the summary is registered to.  */
+  symbol_table *m_symtab;
+
+  template <typename U> friend void gt_ggc_mx (fast_function_summary <U *, va_gc> * const &);
+  template <typename U> friend void gt_pch_nx (fast_function_summary <U *, va_gc> * const &);
+  template <typename U> friend void gt_pch_nx (fast_function_summary <U *, va_gc> * const &,
+      gt_pointer_operator, void *);
+};
+
+template <typename T>
+void
+gt_ggc_mx(fast_function_summary<T *, va_heap>* const &)
+{
+}
+
+template <typename T>
+void
+gt_pch_nx(fast_function_summary<T *, va_heap>* const &)
+{
+  gcc_unreachable ();
+}
+
+template <typename T>
+void
+gt_pch_nx(fast_function_summary<T *, va_heap>* const &, gt_pointer_operator,
+	  void *)
+{
+  gcc_unreachable ();
+}
+
+template <typename T>
+void
+gt_ggc_mx(fast_function_summary<T *, va_gc>* const &summary)
+{
+  if (ggc_test_and_set_mark (summary->m_vector))
+    gt_ggc_mx (summary->m_vector);
+}
+
+template <typename T>
+void
+gt_pch_nx(fast_function_summary<T *, va_gc>* const &summary)
+{
+  if (summary->m_vector)
+    gt_pch_nx (summary->m_vector);
+}
+
+template <typename T>
+void
+gt_pch_nx(fast_function_summary<T *, va_gc>* const& summary,
+	  gt_pointer_operator op, void *cookie)
+{
+  if (summary->m_vector)
+    gt_pch_nx (summary->m_vector, op, cookie);
+}
+
 #endif  /* GCC_SYMBOL_SUMMARY_H  */
@@ -0,0 +1,21 @@
+/* Compile-time corpus: a single function consisting of a long chain of
+   20000 conditionals, and so of about 60000 basic blocks, as produced by
+   fully unrolled generated code.  */
+
+#define B1(x) if (v & (1u << (x % 31))) acc += x; else acc ^= acc >> (x % 7);
+#define B10(x) B1(x##0) B1(x##1) B1(x##2) B1(x##3) B1(x##4) \
+  B1(x##5) B1(x##6) B1(x##7) B1(x##8) B1(x##9)
+#define B100(x) B10(x##0) B10(x##1) B10(x##2) B10(x##3) B10(x##4) \
+  B10(x##5) B10(x##6) B10(x##7) B10(x##8) B10(x##9)
+#define B1000(x) B100(x##0) B100(x##1) B100(x##2) B100(x##3) B100(x##4) \
+  B100(x##5) B100(x##6) B100(x##7) B100(x##8) B100(x##9)
+#define B10000(x) B1000(x##0) B1000(x##1) B1000(x##2) B1000(x##3) \
+  B1000(x##4) B1000(x##5) B1000(x##6) B1000(x##7) B1000(x##8) B1000(x##9)
+
+unsigned int
+chain (unsigned int v)
+{
+  unsigned int acc = 0;
+  B10000(1) B10000(2)
+  return acc;
+}
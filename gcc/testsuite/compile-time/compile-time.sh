@@ -0,0 +1,260 @@
+#!/bin/sh
+
+# Compile the compile-time corpus and check for regressions in the time
+# and memory taken to do so.
+#
+# Copyright (C) 2016 Free Software Foundation, Inc.
+#
+# This file is part of GCC.
+#
+# GCC is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3, or (at your option)
+# any later version.
+#
+# GCC is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with GCC; see the file COPYING3.  If not see
+# <http://www.gnu.org/licenses/>.
+
+# Usage: compile-time.sh [OPTION]... COMPILER
+#
+# Compile each case in the corpus (the *.c and *.C files alongside this
+# script) with COMPILER, a driver command line such as "./xgcc -B./",
+# at each optimization level, with -ftime-report-format=json.  Record
+# the user, system and wall time, the peak resident set size and the
+# peak size of the garbage-collected heap of each compilation, taking
+# the best of several runs, in a results file.  If a baseline results
+# file is given, compare against it and report a FAIL for each time or
+# memory regression larger than the thresholds.
+#
+# Options:
+#   --baseline FILE        compare the results against FILE
+#   --update               then replace FILE with the new results
+#   --results FILE         write the results to FILE
+#                          (default compile-time.results)
+#   --runs N               compile each case N times (default 3)
+#   --options "OPTS..."    the optimization levels (default "-O0 -O2 -O3")
+#   --time-threshold PCT   report time regressions above PCT percent
+#                          (default 10)
+#   --mem-threshold PCT    report memory regressions above PCT percent
+#                          (default 5)
+#   --min-time SECS        ignore time changes smaller than SECS
+#                          (default 0.1)
+#
+# The exit status is 1 if any case failed to compile or regressed.
+#
+# The results file has a line for each case and optimization level:
+#   CASE OPTION USER SYS WALL MAX-RSS-KB GGC-HEAP-PEAK
+# Times are in seconds.  A memory figure is "-" if the host did not
+# provide it.  Baselines are specific to the host and to the checking
+# level the compiler was configured with; keep one per build directory,
+# e.g. by running "make check-compile-time-baseline" before a change
+# and "make check-compile-time" after it.
+
+srcdir=`dirname "$0"`
+baseline=
+update=no
+results=compile-time.results
+runs=3
+options="-O0 -O2 -O3"
+time_threshold=10
+mem_threshold=5
+min_time=0.1
+
+usage ()
+{
+  echo "usage: $0 [--baseline FILE [--update]] [--results FILE] [--runs N]" >&2
+  echo "       [--options \"OPTS...\"] [--time-threshold PCT]" >&2
+  echo "       [--mem-threshold PCT] [--min-time SECS] COMPILER" >&2
+  exit 2
+}
+
+while [ $# -gt 1 ]; do
+  case "$1" in
+    --baseline) baseline=$2; shift ;;
+    --update) update=yes ;;
+    --results) results=$2; shift ;;
+    --runs) runs=$2; shift ;;
+    --options) options=$2; shift ;;
+    --time-threshold) time_threshold=$2; shift ;;
+    --mem-threshold) mem_threshold=$2; shift ;;
+    --min-time) min_time=$2; shift ;;
+    -*) usage ;;
+    *) break ;;
+  esac
+  shift
+done
+[ $# -eq 1 ] || usage
+compiler=$1
+
+if [ $update = yes ] && [ -z "$baseline" ]; then
+  echo "$0: --update requires --baseline" >&2
+  exit 2
+fi
+
+tmpdir=${TMPDIR-/tmp}/compile-time.$$
+mkdir "$tmpdir" || exit 2
+trap 'rm -rf "$tmpdir"' 0 1 2 15
+
+# Print the measurements in the JSON time report in $1, as
+# "USER SYS WALL MAX-RSS-KB GGC-HEAP-PEAK".  The peak heap size is the
+# largest of those recorded after each pass.
+extract ()
+{
+  awk '
+    function field(line, name,    s) {
+      s = line
+      if (!sub(".*\"" name "\": ", "", s))
+	return "-"
+      sub("[,}].*", "", s)
+      return s
+    }
+    /"ggc_heap_peak": / {
+      peak = field($0, "ggc_heap_peak")
+      if (peak + 0 > max_peak + 0)
+	max_peak = peak
+    }
+    /^  "total": / {
+      user = field($0, "user"); sys = field($0, "sys")
+      wall = field($0, "wall"); rss = field($0, "max_rss_kb")
+      seen = 1
+    }
+    END {
+      if (!seen)
+	exit 1
+      if (max_peak == "")
+	max_peak = "-"
+      print user, sys, wall, rss, max_peak
+    }' "$1"
+}
+
+# Print the element-wise minimum of the measurements in $1 and $2.
+best ()
+{
+  echo "$1 $2" | awk '{
+    for (i = 1; i <= 5; i++)
+      {
+	if ($i == "-" || $(i + 5) == "-")
+	  m = "-"
+	else
+	  m = ($i + 0 <= $(i + 5) + 0) ? $i : $(i + 5)
+	printf "%s%s", m, (i < 5 ? " " : "\n")
+      }
+  }'
+}
+
+# Return success if the compiler can compile C++.
+cxx_supported ()
+{
+  cc1plus=`$compiler -print-prog-name=cc1plus 2>/dev/null`
+  case "$cc1plus" in
+    */*) [ -x "$cc1plus" ] ;;
+    *) false ;;
+  esac
+}
+
+status=0
+: > "$results.tmp"
+for src in "$srcdir"/*.c "$srcdir"/*.C; do
+  [ -f "$src" ] || continue
+  name=`basename "$src"`
+  case "$name" in
+    *.C)
+      if ! cxx_supported; then
+	echo "UNSUPPORTED: $name"
+	continue
+      fi ;;
+  esac
+  for opt in $options; do
+    measurements=
+    run=0
+    while [ $run -lt "$runs" ]; do
+      if ! $compiler $opt -S -o /dev/null -ftime-report \
+	  -ftime-report-format=json "$src" 2> "$tmpdir/report" \
+	 || ! this=`extract "$tmpdir/report"`; then
+	echo "FAIL: $name $opt (compilation failed)"
+	sed '/^{$/,$d' "$tmpdir/report"
+	status=1
+	measurements=
+	break
+      fi
+      if [ -z "$measurements" ]; then
+	measurements=$this
+      else
+	measurements=`best "$measurements" "$this"`
+      fi
+      run=`expr $run + 1`
+    done
+    [ -n "$measurements" ] && echo "$name $opt $measurements" >> "$results.tmp"
+  done
+done
+mv "$results.tmp" "$results"
+
+if [ -n "$baseline" ] && [ -s "$baseline" ]; then
+  awk -v time_threshold="$time_threshold" -v mem_threshold="$mem_threshold" \
+      -v min_time="$min_time" '
+    function pct(new, old) {
+      return old > 0 ? (new - old) * 100 / old : 0
+    }
+    # Report a regression of a time measurement, ignoring changes
+    # within the noise.
+    function check_time(what, new, old) {
+      if (new - old >= min_time && pct(new, old) > time_threshold)
+	{
+	  printf "FAIL: %s %s: %s time %.2fs -> %.2fs (%+.1f%%)\n", \
+	    key_case, key_opt, what, old, new, pct(new, old)
+	  failed = 1
+	}
+    }
+    function check_mem(what, new, old) {
+      if (new != "-" && old != "-" && pct(new, old) > mem_threshold)
+	{
+	  printf "FAIL: %s %s: %s %d -> %d (%+.1f%%)\n", \
+	    key_case, key_opt, what, old, new, pct(new, old)
+	  failed = 1
+	}
+    }
+    FNR == NR { old[$1 " " $2] = $0; next }
+    {
+      key_case = $1; key_opt = $2
+      if (!(($1 " " $2) in old))
+	{
+	  printf "NEW: %s %s\n", $1, $2
+	  next
+	}
+      split(old[$1 " " $2], o)
+      failed = 0
+      check_time("user", $3, o[3])
+      check_time("wall", $5, o[5])
+      check_mem("max RSS kB", $6, o[6])
+      check_mem("GC heap peak", $7, o[7])
+      if (failed)
+	nfail++
+      else
+	{
+	  printf "PASS: %s %s: user time %.2fs (%+.1f%%)\n", \
+	    $1, $2, $3, pct($3, o[3])
+	  npass++
+	}
+    }
+    END {
+      printf "\n# of expected passes\t\t%d\n", npass
+      if (nfail)
+	printf "# of unexpected failures\t%d\n", nfail
+      exit nfail != 0
+    }' "$baseline" "$results" || status=1
+else
+  awk '{ printf "RESULT: %s %s: user time %.2fs, max RSS %s kB\n", \
+	   $1, $2, $3, $6 }' "$results"
+fi
+
+if [ $update = yes ]; then
+  cp "$results" "$baseline"
+fi
+
+exit $status
@@ -0,0 +1,46 @@
+/* Compile-time corpus: large static initializers, as produced for
+   embedded data and generated lookup tables.  There are 200000 scalar
+   elements and 20000 structures with designated initializers.  */
+
+struct entry
+{
+  const char *name;
+  unsigned int code;
+  short flags;
+  double weight;
+};
+
+#define S(x) #x
+#define E1(x) x * 2654435761u,
+#define E10(x) E1(x##0) E1(x##1) E1(x##2) E1(x##3) E1(x##4) \
+  E1(x##5) E1(x##6) E1(x##7) E1(x##8) E1(x##9)
+#define E100(x) E10(x##0) E10(x##1) E10(x##2) E10(x##3) E10(x##4) \
+  E10(x##5) E10(x##6) E10(x##7) E10(x##8) E10(x##9)
+#define E1000(x) E100(x##0) E100(x##1) E100(x##2) E100(x##3) E100(x##4) \
+  E100(x##5) E100(x##6) E100(x##7) E100(x##8) E100(x##9)
+#define E10000(x) E1000(x##0) E1000(x##1) E1000(x##2) E1000(x##3) \
+  E1000(x##4) E1000(x##5) E1000(x##6) E1000(x##7) E1000(x##8) E1000(x##9)
+#define E100000(x) E10000(x##0) E10000(x##1) E10000(x##2) E10000(x##3) \
+  E10000(x##4) E10000(x##5) E10000(x##6) E10000(x##7) E10000(x##8) \
+  E10000(x##9)
+
+const unsigned int table[] = { E100000(1) E100000(2) };
+
+#define D1(x) { .name = S(x), .code = x, .flags = x % 5, .weight = x##.5 },
+#define D10(x) D1(x##0) D1(x##1) D1(x##2) D1(x##3) D1(x##4) \
+  D1(x##5) D1(x##6) D1(x##7) D1(x##8) D1(x##9)
+#define D100(x) D10(x##0) D10(x##1) D10(x##2) D10(x##3) D10(x##4) \
+  D10(x##5) D10(x##6) D10(x##7) D10(x##8) D10(x##9)
+#define D1000(x) D100(x##0) D100(x##1) D100(x##2) D100(x##3) D100(x##4) \
+  D100(x##5) D100(x##6) D100(x##7) D100(x##8) D100(x##9)
+#define D10000(x) D1000(x##0) D1000(x##1) D1000(x##2) D1000(x##3) \
+  D1000(x##4) D1000(x##5) D1000(x##6) D1000(x##7) D1000(x##8) D1000(x##9)
+
+struct entry entries[] = { D10000(1) D10000(2) };
+
+unsigned int
+lookup (unsigned int i)
+{
+  return table[i % (sizeof table / sizeof table[0])]
+	 + entries[i % (sizeof entries / sizeof entries[0])].code;
+}
@@ -0,0 +1,50 @@
+/* Compile-time corpus: a generated state machine, of the kind produced
+   by lexer and protocol generators, with 4000 states each dispatching
+   on the input character.  */
+
+#define NSTATES 4000
+#define NEXT(x, k) (1000 + ((x) * (k) + 17) % NSTATES)
+#define S1(x)						\
+  case x:						\
+    switch (c)						\
+      {							\
+      case 'a': case 'b': case 'c':			\
+	state = NEXT (x, 3);				\
+	break;						\
+      case '0': case '1':				\
+	count += x & 7;					\
+	state = NEXT (x, 5);				\
+	break;						\
+      case '\n':					\
+	if (count > x)					\
+	  return x;					\
+	state = NEXT (x, 11);				\
+	break;						\
+      default:						\
+	state = 1000 + (x + c) % NSTATES;		\
+	break;						\
+      }							\
+    break;
+#define S10(x) S1(x##0) S1(x##1) S1(x##2) S1(x##3) S1(x##4) \
+  S1(x##5) S1(x##6) S1(x##7) S1(x##8) S1(x##9)
+#define S100(x) S10(x##0) S10(x##1) S10(x##2) S10(x##3) S10(x##4) \
+  S10(x##5) S10(x##6) S10(x##7) S10(x##8) S10(x##9)
+#define S1000(x) S100(x##0) S100(x##1) S100(x##2) S100(x##3) S100(x##4) \
+  S100(x##5) S100(x##6) S100(x##7) S100(x##8) S100(x##9)
+
+int
+run (const char *p)
+{
+  int state = 1000;
+  int count = 0;
+  int c;
+
+  while ((c = *p++) != 0)
+    switch (state)
+      {
+	S1000(1) S1000(2) S1000(3) S1000(4)
+      default:
+	return -1;
+      }
+  return state;
+}
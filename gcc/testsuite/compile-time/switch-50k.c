@@ -0,0 +1,28 @@
+/* Compile-time corpus: a switch statement with 50000 cases, of the kind
+   produced by generated dispatch tables.  The cases are built by
+   pasting digits onto their arguments, giving the values 10000 to
+   59999.  */
+
+#define C1(x) case x: r = x * 7 + (v >> (x & 15)); break;
+#define C10(x) C1(x##0) C1(x##1) C1(x##2) C1(x##3) C1(x##4) \
+  C1(x##5) C1(x##6) C1(x##7) C1(x##8) C1(x##9)
+#define C100(x) C10(x##0) C10(x##1) C10(x##2) C10(x##3) C10(x##4) \
+  C10(x##5) C10(x##6) C10(x##7) C10(x##8) C10(x##9)
+#define C1000(x) C100(x##0) C100(x##1) C100(x##2) C100(x##3) C100(x##4) \
+  C100(x##5) C100(x##6) C100(x##7) C100(x##8) C100(x##9)
+#define C10000(x) C1000(x##0) C1000(x##1) C1000(x##2) C1000(x##3) \
+  C1000(x##4) C1000(x##5) C1000(x##6) C1000(x##7) C1000(x##8) C1000(x##9)
+
+int
+dispatch (int x, int v)
+{
+  int r;
+  switch (x)
+    {
+      C10000(1) C10000(2) C10000(3) C10000(4) C10000(5)
+    default:
+      r = -1;
+      break;
+    }
+  return r;
+}
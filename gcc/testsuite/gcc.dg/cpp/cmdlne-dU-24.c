@@ -0,0 +1,11 @@
+/* { dg-do preprocess } */
+/* { dg-options "-nostdinc -P -M -fdirectives-only -dU" } */
+/* { dg-final { scan-file cmdlne-dU-24.i "^\n*#define B 1\n#undef A\n\[^\n\]*cmdlne-dU-24.o:( *\\\\\\n)?\[^\n\]*cmdlne-dU-24.c\n*$" } } */
+/* Test that -dU lists the macros the directives used with -M and
+   -fdirectives-only, before the dependencies.  */
+#define B 1
+#ifdef A
+#endif
+#if B
+#endif
+A B C
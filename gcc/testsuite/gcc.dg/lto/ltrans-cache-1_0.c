@@ -0,0 +1,13 @@
+/* Also linked twice against the same -flto-cache by lto.exp, which checks
+   that the second link reuses the LTRANS objects of the first.  */
+
+extern int ltrans_cache_1 (int);
+extern void abort (void);
+
+int
+main (void)
+{
+  if (ltrans_cache_1 (20) != 42)
+    abort ();
+  return 0;
+}
@@ -0,0 +1,11 @@
+static int __attribute__ ((noinline))
+twice (int x)
+{
+  return 2 * x;
+}
+
+int
+ltrans_cache_1 (int x)
+{
+  return twice (x) + 2;
+}
@@ -0,0 +1,4 @@
+/* Scanned for dependencies together with deps-batch-2.c and
+   deps-batch-3.c by deps-batch.exp.  */
+
+int deps_batch_1;
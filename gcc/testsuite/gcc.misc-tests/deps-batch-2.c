@@ -0,0 +1,5 @@
+/* Scanned for dependencies together with deps-batch-1.c and
+   deps-batch-3.c by deps-batch.exp, which checks that the error loses
+   only the rule of this file.  */
+
+#error deps-batch-2.c fails
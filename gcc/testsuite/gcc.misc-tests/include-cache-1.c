@@ -0,0 +1,9 @@
+/* Test -finclude-cache.  This file is compiled several times against the
+   same cache by include-cache.exp, which defines EXPECT to the version of
+   the header that should be found.  */
+
+#include <include-cache-1.h>
+
+#if V != EXPECT
+#error wrong include-cache-1.h
+#endif
@@ -0,0 +1,14 @@
+/* Test -finclude-cache with a header reached through a symbolic link to a
+   directory.  This file is compiled several times against the same cache
+   by include-cache.exp, which defines EXPECT to the version of the header
+   that should be found, or to 0 if there should be none.  */
+
+#if __has_include (<sub/include-cache-1.h>)
+#include <sub/include-cache-1.h>
+#else
+#define V 0
+#endif
+
+#if V != EXPECT
+#error wrong sub/include-cache-1.h
+#endif
@@ -0,0 +1,11 @@
+/* Test -fpch-cache.  This file is compiled several times against the same
+   cache by pch-cache.exp, which checks that the header is precompiled and
+   then reused.  */
+
+#include "pch-cache-1.h"
+
+int
+main (void)
+{
+  return pch_cache_1 ();
+}
@@ -0,0 +1,5 @@
+static inline int
+pch_cache_1 (void)
+{
+  return 0;
+}
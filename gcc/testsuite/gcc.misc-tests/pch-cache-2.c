@@ -0,0 +1,12 @@
+/* Test -fpch-cache with a header that draws a warning.  This file is
+   compiled several times against the same cache by pch-cache.exp, which
+   checks that the warning is given each time, and that -Werror makes it
+   an error.  */
+
+#include "pch-cache-2.h"
+
+int
+main (void)
+{
+  return pch_cache_2 ();
+}
@@ -0,0 +1,7 @@
+#warning pch-cache-2.h warns
+
+static inline int
+pch_cache_2 (void)
+{
+  return 0;
+}
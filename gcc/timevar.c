@@ -23,6 +23,8 @@ along with GCC; see the file COPYING3.  If not see
 #include "coretypes.h"
 #include "timevar.h"
 #include "options.h"
+#include "obstack.h"
+#include "selftest.h"
 
 #ifndef HAVE_CLOCK_T
 typedef int clock_t;
@@ -209,6 +211,448 @@ timer::named_items::print (FILE *fp, const timevar_time_def *total)
     }
 }
 
+/* The implementation of the per-pass statistics printed by
+   -ftime-report-format=json.  */
+
+class timer::pass_items
+{
+ public:
+  void push (const char *name, int id, bool function_p);
+  void pop (size_t ggc_heap_peak);
+  void print_json (FILE *fp);
+
+ private:
+  /* The statistics accumulated for one pass.  */
+  struct pass_def
+  {
+    /* The name and static pass number of the pass.  */
+    const char *name;
+    int id;
+
+    /* Time elapsed while executing the pass, including any passes
+       executed from within it.  */
+    timevar_time_def elapsed;
+
+    /* The largest size of the GC heap while the pass was executing.  */
+    size_t ggc_heap_peak;
+
+    /* The number of times the pass was executed, and the number of
+       those executions that were for a single function.  */
+    unsigned executions;
+    unsigned functions;
+  };
+
+  /* An execution of a pass that is in progress.  */
+  struct pass_frame
+  {
+    /* The index of the pass in M_PASSES.  */
+    unsigned index;
+    timevar_time_def start_time;
+  };
+
+  unsigned lookup (const char *name, int id);
+
+  /* The statistics for each pass, in the order in which the passes were
+     first executed.  */
+  auto_vec<pass_def> m_passes;
+
+  /* One more than the index in M_PASSES of each pass, indexed by static
+     pass number, or zero if it has not been executed yet.  */
+  auto_vec<unsigned> m_index_by_id;
+
+  /* The executions in progress; IPA passes may execute others.  */
+  auto_vec<pass_frame> m_stack;
+};
+
+/* Return the index in M_PASSES of the pass NAME, whose static pass
+   number is ID, adding it if necessary.  Passes without a static pass
+   number are looked up by name.  */
+
+unsigned
+timer::pass_items::lookup (const char *name, int id)
+{
+  if (id > 0 && (unsigned) id < m_index_by_id.length ()
+      && m_index_by_id[id])
+    return m_index_by_id[id] - 1;
+
+  if (id <= 0)
+    {
+      unsigned int i;
+      pass_def *def;
+      FOR_EACH_VEC_ELT (m_passes, i, def)
+	if (def->id <= 0 && strcmp (def->name, name) == 0)
+	  return i;
+    }
+
+  pass_def def;
+  memset (&def, 0, sizeof (def));
+  def.name = name;
+  def.id = id;
+  m_passes.safe_push (def);
+
+  if (id > 0)
+    {
+      if ((unsigned) id >= m_index_by_id.length ())
+	m_index_by_id.safe_grow_cleared (id + 1);
+      m_index_by_id[id] = m_passes.length ();
+    }
+  return m_passes.length () - 1;
+}
+
+/* Start the execution of the pass NAME, whose static pass number is ID.
+   FUNCTION_P is true if the pass is executed for a single function.  */
+
+void
+timer::pass_items::push (const char *name, int id, bool function_p)
+{
+  pass_frame frame;
+  frame.index = lookup (name, id);
+
+  pass_def *def = &m_passes[frame.index];
+  def->executions++;
+  if (function_p)
+    def->functions++;
+
+  get_time (&frame.start_time);
+  m_stack.safe_push (frame);
+}
+
+/* Finish the execution of the innermost pass, during which the GC heap
+   reached GGC_HEAP_PEAK bytes.  */
+
+void
+timer::pass_items::pop (size_t ggc_heap_peak)
+{
+  pass_frame frame = m_stack.pop ();
+  pass_def *def = &m_passes[frame.index];
+  timevar_time_def now;
+
+  get_time (&now);
+  timevar_accumulate (&def->elapsed, &frame.start_time, &now);
+  def->ggc_heap_peak = MAX (def->ggc_heap_peak, ggc_heap_peak);
+}
+
+/* Print the statistics of the passes that were executed, as the
+   elements of a JSON array.  */
+
+void
+timer::pass_items::print_json (FILE *fp)
+{
+  unsigned int i;
+  pass_def *def;
+
+  FOR_EACH_VEC_ELT (m_passes, i, def)
+    {
+      fprintf (fp, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+      print_json_string (fp, def->name);
+      fprintf (fp, ", \"id\": %d, ", def->id);
+      print_json_times (fp, def->elapsed);
+      fprintf (fp, ", \"ggc_heap_peak\": %lu, \"executions\": %u,"
+	       " \"functions\": %u}",
+	       (unsigned long) def->ggc_heap_peak, def->executions,
+	       def->functions);
+    }
+}
+
+/* The implementation of the counts of events printed at the end of
+   the report, for statistics that are not times.  */
+
+class timer::count_items
+{
+ public:
+  void add (const char *name, long value);
+  void print (FILE *fp);
+  void print_json (FILE *fp);
+
+ private:
+  struct count_def
+  {
+    const char *name;
+    long value;
+  };
+
+  /* The counts, in the order in which they were first recorded.  */
+  auto_vec<count_def> m_counts;
+};
+
+/* Add VALUE to the count NAME.  */
+
+void
+timer::count_items::add (const char *name, long value)
+{
+  unsigned int i;
+  count_def *def;
+
+  FOR_EACH_VEC_ELT (m_counts, i, def)
+    if (strcmp (def->name, name) == 0)
+      {
+	def->value += value;
+	return;
+      }
+
+  count_def new_def;
+  new_def.name = name;
+  new_def.value = value;
+  m_counts.safe_push (new_def);
+}
+
+/* Print the counts.  Helper function for timer::print.  */
+
+void
+timer::count_items::print (FILE *fp)
+{
+  unsigned int i;
+  count_def *def;
+
+  fputs ("Counts:\n", fp);
+  FOR_EACH_VEC_ELT (m_counts, i, def)
+    fprintf (fp, " %s: %ld\n", def->name, def->value);
+}
+
+/* Print the counts as the elements of a JSON array.  */
+
+void
+timer::count_items::print_json (FILE *fp)
+{
+  unsigned int i;
+  count_def *def;
+
+  FOR_EACH_VEC_ELT (m_counts, i, def)
+    {
+      fprintf (fp, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+      print_json_string (fp, def->name);
+      fprintf (fp, ", \"value\": %ld}", def->value);
+    }
+}
+
+/* The threads of the trace written for -fself-profile.  Events on each
+   of them nest properly.  */
+
+enum trace_lane
+{
+  /* The timing stack, the execution of passes and template
+     instantiations.  */
+  TRACE_LANE_COMPILER,
+
+  /* The source files being read.  */
+  TRACE_LANE_FILES,
+
+  /* The timing variables timed independently of the timing stack.  */
+  TRACE_LANE_PHASES,
+
+  TRACE_LANES
+};
+
+static const char *const trace_lane_names[TRACE_LANES] = {
+  "compiler", "files", "phases"
+};
+
+/* The implementation of -fself-profile.  The trace is written in the
+   JSON array form of the Trace Event Format, with a complete ("X")
+   event for each interval, so that events shorter than a minimum
+   duration can be dropped when they end.  */
+
+class timer::trace_writer
+{
+ public:
+  trace_writer (FILE *file, unsigned min_duration);
+  ~trace_writer ();
+
+  void begin (trace_lane lane, const char *category, const char *name,
+	      const char *function, bool copy_p);
+  void end (trace_lane lane);
+  bool open_p (trace_lane lane) const { return !m_lanes[lane].is_empty (); }
+  void start_standalone (timevar_id_t id);
+  void stop_standalone (timevar_id_t id, const char *name);
+
+ private:
+  /* An interval that has not ended yet.  */
+  struct frame
+  {
+    const char *category;
+    const char *name;
+    const char *function;
+    HOST_WIDE_INT start;
+
+    /* If non-NULL, the copies of the strings above, on the obstack of
+       the lane.  */
+    char *copies;
+  };
+
+  static HOST_WIDE_INT now ();
+  void emit (trace_lane lane, const char *category, const char *name,
+	     const char *function, HOST_WIDE_INT start, HOST_WIDE_INT end);
+
+  FILE *m_file;
+
+  /* The time at which the trace started.  */
+  HOST_WIDE_INT m_base;
+
+  /* Intervals shorter than this many microseconds are not written.  */
+  unsigned m_min_duration;
+
+  int m_pid;
+
+  /* The intervals that have begun but not ended, for each lane.  */
+  auto_vec<frame> m_lanes[TRACE_LANES];
+
+  /* Copies of strings that may not outlive the call to begin.  They are
+     released in the order they were allocated.  */
+  struct obstack m_strings[TRACE_LANES];
+
+  /* When each timing variable running as a standalone timer started.  */
+  HOST_WIDE_INT m_standalone_start[TIMEVAR_LAST];
+};
+
+/* Finish the trace of the compiler's timer if it exits without deleting
+   the timer, as after a fatal error or an internal compiler error, so
+   that the trace is still well formed when it is most wanted.  */
+
+static void
+finish_trace_at_exit (void)
+{
+  if (g_timer)
+    g_timer->finish_trace ();
+}
+
+/* Start writing a trace to FILE, dropping intervals that are shorter
+   than MIN_DURATION microseconds.  */
+
+timer::trace_writer::trace_writer (FILE *file, unsigned min_duration)
+: m_file (file),
+  m_base (now ()),
+  m_min_duration (min_duration),
+  m_pid ((int) getpid ())
+{
+  fputs ("[", m_file);
+  for (int lane = 0; lane < TRACE_LANES; lane++)
+    {
+      gcc_obstack_init (&m_strings[lane]);
+      fprintf (m_file, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\","
+	       " \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+	       lane ? "," : "", m_pid, lane, trace_lane_names[lane]);
+    }
+  memset (m_standalone_start, 0, sizeof (m_standalone_start));
+}
+
+/* End the intervals that are still open and finish the trace.  */
+
+timer::trace_writer::~trace_writer ()
+{
+  for (int lane = 0; lane < TRACE_LANES; lane++)
+    {
+      while (open_p ((trace_lane) lane))
+	end ((trace_lane) lane);
+      obstack_free (&m_strings[lane], NULL);
+    }
+  fputs ("\n]\n", m_file);
+  fclose (m_file);
+}
+
+/* Return the current time in microseconds.  */
+
+HOST_WIDE_INT
+timer::trace_writer::now ()
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return (HOST_WIDE_INT) tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+  return get_run_time ();
+#endif
+}
+
+/* Write the interval NAME of CATEGORY on LANE from START to END, unless
+   it is too short.  FUNCTION, if non-NULL, is the function that was
+   being compiled.  */
+
+void
+timer::trace_writer::emit (trace_lane lane, const char *category,
+			   const char *name, const char *function,
+			   HOST_WIDE_INT start, HOST_WIDE_INT end)
+{
+  if (end - start < (HOST_WIDE_INT) m_min_duration)
+    return;
+
+  fputs (",\n{\"name\": ", m_file);
+  print_json_string (m_file, name);
+  fprintf (m_file, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": "
+	   HOST_WIDE_INT_PRINT_DEC ", \"dur\": " HOST_WIDE_INT_PRINT_DEC
+	   ", \"pid\": %d, \"tid\": %d",
+	   category, start - m_base, end - start, m_pid, (int) lane);
+  if (function)
+    {
+      fputs (", \"args\": {\"function\": ", m_file);
+      print_json_string (m_file, function);
+      putc ('}', m_file);
+    }
+  putc ('}', m_file);
+}
+
+/* Begin the interval NAME of CATEGORY on LANE, for FUNCTION if it is
+   non-NULL, or else for the function of the enclosing interval.  If
+   COPY_P, NAME and FUNCTION may not outlive this call.  */
+
+void
+timer::trace_writer::begin (trace_lane lane, const char *category,
+			    const char *name, const char *function,
+			    bool copy_p)
+{
+  frame f;
+
+  if (!function && !m_lanes[lane].is_empty ())
+    function = m_lanes[lane].last ().function;
+
+  f.copies = NULL;
+  if (copy_p)
+    {
+      f.copies = XOBNEWVEC (&m_strings[lane], char, 0);
+      name = (const char *) obstack_copy0 (&m_strings[lane], name,
+					   strlen (name));
+      if (function)
+	function = (const char *) obstack_copy0 (&m_strings[lane], function,
+						 strlen (function));
+    }
+
+  f.category = category;
+  f.name = name;
+  f.function = function;
+  f.start = now ();
+  m_lanes[lane].safe_push (f);
+}
+
+/* End the innermost interval on LANE.  */
+
+void
+timer::trace_writer::end (trace_lane lane)
+{
+  frame f = m_lanes[lane].pop ();
+
+  emit (lane, f.category, f.name, f.function, f.start, now ());
+  if (f.copies)
+    obstack_free (&m_strings[lane], f.copies);
+}
+
+/* Record that the timing variable ID has started as a standalone
+   timer.  */
+
+void
+timer::trace_writer::start_standalone (timevar_id_t id)
+{
+  m_standalone_start[id] = now ();
+}
+
+/* Write the interval for which the timing variable ID, called NAME, ran
+   as a standalone timer.  */
+
+void
+timer::trace_writer::stop_standalone (timevar_id_t id, const char *name)
+{
+  emit (TRACE_LANE_PHASES, "timevar", name, NULL, m_standalone_start[id],
+	now ());
+}
+
 /* Fill the current times into TIME.  The definition of this function
    also defines any or all of the HAVE_USER_TIME, HAVE_SYS_TIME, and
    HAVE_WALL_TIME macros.  */
@@ -259,7 +703,10 @@ timer::timer () :
   m_stack (NULL),
   m_unused_stack_instances (NULL),
   m_start_time (),
-  m_jit_client_items (NULL)
+  m_jit_client_items (NULL),
+  m_pass_items (NULL),
+  m_trace (NULL),
+  m_count_items (NULL)
 {
   /* Zero all elapsed times.  */
   memset (m_timevars, 0, sizeof (m_timevars));
@@ -300,6 +747,9 @@ timer::~timer ()
     delete m_timevars[i].children;
 
   delete m_jit_client_items;
+  delete m_pass_items;
+  delete m_trace;
+  delete m_count_items;
 }
 
 /* Initialize timing variables.  */
@@ -370,6 +820,9 @@ timer::push_internal (struct timevar_def *tv)
   context->timevar = tv;
   context->next = m_stack;
   m_stack = context;
+
+  if (m_trace)
+    m_trace->begin (TRACE_LANE_COMPILER, "timevar", tv->name, NULL, false);
 }
 
 /* Pop the topmost timing variable element off the timing stack.  The
@@ -401,6 +854,9 @@ timer::pop_internal ()
   /* Attribute the elapsed time to the element we're popping.  */
   timevar_accumulate (&popped->timevar->elapsed, &m_start_time, &now);
 
+  if (m_trace)
+    m_trace->end (TRACE_LANE_COMPILER);
+
   /* Take the item off the stack.  */
   m_stack = m_stack->next;
 
@@ -456,6 +912,10 @@ timer::start (timevar_id_t timevar)
   tv->standalone = 1;
 
   get_time (&tv->start_time);
+
+  /* The concurrent timing variables are too frequent to trace.  */
+  if (m_trace && tv->name[0] != '|')
+    m_trace->start_standalone (timevar);
 }
 
 /* Stop timing TIMEVAR.  Time elapsed since timevar_start was called
@@ -484,6 +944,9 @@ timer::stop (timevar_id_t timevar)
 
   get_time (&now);
   timevar_accumulate (&tv->elapsed, &tv->start_time, &now);
+
+  if (m_trace && tv->name[0] != '|')
+    m_trace->stop_standalone (timevar, tv->name);
 }
 
 
@@ -520,6 +983,8 @@ timer::cond_start (timevar_id_t timevar)
   tv->standalone = 1;
 
   get_time (&tv->start_time);
+  if (m_trace && tv->name[0] != '|')
+    m_trace->start_standalone (timevar);
   return false;  /* The timevar was not already running.  */
 }
 
@@ -553,6 +1018,9 @@ timer::cond_stop (timevar_id_t timevar)
 
   get_time (&now);
   timevar_accumulate (&tv->elapsed, &tv->start_time, &now);
+
+  if (m_trace && tv->name[0] != '|')
+    m_trace->stop_standalone (timevar, tv->name);
 }
 
 /* Push the named item onto the timing stack.  */
@@ -578,10 +1046,119 @@ timer::pop_client_item ()
   m_jit_client_items->pop ();
 }
 
-/* Validate that phase times are consistent.  */
+/* Record that the pass NAME, whose static pass number is ID, has started
+   executing.  FUNCTION is the name of the function it is executing for,
+   or NULL if it is executing for the whole translation unit.  */
 
 void
-timer::validate_phases (FILE *fp) const
+timer::push_pass (const char *name, int id, const char *function)
+{
+  /* Lazily create the pass_items instance.  */
+  if (!m_pass_items)
+    m_pass_items = new pass_items ();
+
+  m_pass_items->push (name, id, function != NULL);
+  if (m_trace)
+    m_trace->begin (TRACE_LANE_COMPILER, "pass", name, function, true);
+}
+
+/* Record that the pass last passed to push_pass has finished, and that
+   the GC heap reached GGC_HEAP_PEAK bytes while it was executing.  */
+
+void
+timer::pop_pass (size_t ggc_heap_peak)
+{
+  gcc_assert (m_pass_items);
+  m_pass_items->pop (ggc_heap_peak);
+  if (m_trace)
+    m_trace->end (TRACE_LANE_COMPILER);
+}
+
+/* Start writing the trace requested by -fself-profile to FILENAME,
+   leaving out intervals shorter than MIN_DURATION microseconds.  Return
+   false if the file cannot be opened.  */
+
+bool
+timer::start_trace (const char *filename, unsigned min_duration)
+{
+  gcc_assert (!m_trace);
+
+  FILE *file = fopen (filename, "w");
+  if (!file)
+    return false;
+
+  m_trace = new trace_writer (file, min_duration);
+
+  static bool registered_p;
+  if (!registered_p)
+    {
+      atexit (finish_trace_at_exit);
+      registered_p = true;
+    }
+  return true;
+}
+
+/* End the open intervals and finish the trace, if one is being
+   written.  */
+
+void
+timer::finish_trace ()
+{
+  delete m_trace;
+  m_trace = NULL;
+}
+
+/* Begin a trace interval NAME of CATEGORY, within the innermost item on
+   the timing stack, to be ended by trace_pop.  NAME need not outlive
+   this call.  */
+
+void
+timer::trace_push (const char *category, const char *name)
+{
+  if (m_trace)
+    m_trace->begin (TRACE_LANE_COMPILER, category, name, NULL, true);
+}
+
+/* End the trace interval begun by the last trace_push.  */
+
+void
+timer::trace_pop ()
+{
+  if (m_trace)
+    m_trace->end (TRACE_LANE_COMPILER);
+}
+
+/* Record in the trace that FILENAME has been entered, if ENTER_P, or
+   else that the current file has been left.  */
+
+void
+timer::trace_file_change (const char *filename, bool enter_p)
+{
+  if (!m_trace)
+    return;
+
+  if (enter_p)
+    m_trace->begin (TRACE_LANE_FILES, "file", filename, NULL, false);
+  else if (m_trace->open_p (TRACE_LANE_FILES))
+    m_trace->end (TRACE_LANE_FILES);
+}
+
+/* Add VALUE to the count of events NAME, which is shown at the end of
+   the report.  NAME is not copied.  */
+
+void
+timer::add_count (const char *name, long value)
+{
+  if (!m_count_items)
+    m_count_items = new count_items ();
+  m_count_items->add (name, value);
+}
+
+/* Sum the times of the phase timing variables into *PHASES.  Return
+   whether they stay within the total time.  */
+
+bool
+timer::sum_phases (timevar_time_def *phases) const
 {
   unsigned int /* timevar_id_t */ id;
   const timevar_time_def *total = &m_timevars[TV_TOTAL].elapsed;
@@ -609,21 +1186,36 @@ timer::validate_phases (FILE *fp) const
 	}
     }
 
-  if (phase_user > total->user * tolerance
-      || phase_sys > total->sys * tolerance
-      || phase_wall > total->wall * tolerance
-      || phase_ggc_mem > total->ggc_mem * tolerance)
+  phases->user = phase_user;
+  phases->sys = phase_sys;
+  phases->wall = phase_wall;
+  phases->ggc_mem = phase_ggc_mem;
+  return !(phase_user > total->user * tolerance
+	   || phase_sys > total->sys * tolerance
+	   || phase_wall > total->wall * tolerance
+	   || phase_ggc_mem > total->ggc_mem * tolerance);
+}
+
+/* Validate that phase times are consistent.  */
+
+void
+timer::validate_phases (FILE *fp) const
+{
+  const timevar_time_def *total = &m_timevars[TV_TOTAL].elapsed;
+  timevar_time_def phases;
+
+  if (!sum_phases (&phases))
     {
 
       fprintf (fp, "Timing error: total of phase timers exceeds total time.\n");
-      if (phase_user > total->user)
-	fprintf (fp, "user    %24.18e > %24.18e\n", phase_user, total->user);
-      if (phase_sys > total->sys)
-	fprintf (fp, "sys     %24.18e > %24.18e\n", phase_sys, total->sys);
-      if (phase_wall > total->wall)
-	fprintf (fp, "wall    %24.18e > %24.18e\n", phase_wall, total->wall);
-      if (phase_ggc_mem > total->ggc_mem)
-	fprintf (fp, "ggc_mem %24lu > %24lu\n", (unsigned long)phase_ggc_mem,
+      if (phases.user > total->user)
+	fprintf (fp, "user    %24.18e > %24.18e\n", phases.user, total->user);
+      if (phases.sys > total->sys)
+	fprintf (fp, "sys     %24.18e > %24.18e\n", phases.sys, total->sys);
+      if (phases.wall > total->wall)
+	fprintf (fp, "wall    %24.18e > %24.18e\n", phases.wall, total->wall);
+      if (phases.ggc_mem > total->ggc_mem)
+	fprintf (fp, "ggc_mem %24lu > %24lu\n", (unsigned long)phases.ggc_mem,
 		 (unsigned long)total->ggc_mem);
       gcc_unreachable ();
     }
@@ -670,6 +1262,110 @@ timer::print_row (FILE *fp,
   putc ('\n', fp);
 }
 
+/* Print STR to FP as a JSON string.  */
+
+void
+timer::print_json_string (FILE *fp, const char *str)
+{
+  putc ('"', fp);
+  for (const unsigned char *p = (const unsigned char *) str; *p; p++)
+    if (*p == '"' || *p == '\\')
+      fprintf (fp, "\\%c", *p);
+    else if (*p < ' ')
+      fprintf (fp, "\\u%04x", *p);
+    else
+      putc (*p, fp);
+  putc ('"', fp);
+}
+
+/* Print the members of a JSON object describing ELAPSED to FP.  */
+
+void
+timer::print_json_times (FILE *fp, const timevar_time_def &elapsed)
+{
+  fprintf (fp, "\"user\": %.6f, \"sys\": %.6f, \"wall\": %.6f,"
+	   " \"ggc_mem\": %lu",
+	   elapsed.user, elapsed.sys, elapsed.wall,
+	   (unsigned long) elapsed.ggc_mem);
+}
+
+/* Summarize timing variables to FP as a JSON object, for
+   -ftime-report-format=json.  Unlike the text report, every timing
+   variable that was used is included, even if no time was attributed
+   to it, so that reports from many compilations can be combined.
+   The "concurrent" timing variables (whose names begin with "|") are
+   timed independently of the timing stack and so overlap the
+   others.  Children are listed in the order of timevar.def, so that
+   identical runs give identical reports, and whether the phases add up
+   is reported rather than checked, so that the report stays valid
+   JSON.  */
+
+void
+timer::print_json (FILE *fp)
+{
+  unsigned int /* timevar_id_t */ id, child_id;
+  bool first = true;
+  timevar_time_def phases;
+
+  fputs ("{\n  \"timevars\": [", fp);
+  for (id = 0; id < (unsigned int) TIMEVAR_LAST; ++id)
+    {
+      const timevar_def *tv = &m_timevars[(timevar_id_t) id];
+
+      if ((timevar_id_t) id == TV_TOTAL || !tv->used)
+	continue;
+
+      fprintf (fp, "%s\n    {\"name\": ", first ? "" : ",");
+      print_json_string (fp, tv->name);
+      fprintf (fp, ", \"concurrent\": %s, ",
+	       tv->name[0] == '|' ? "true" : "false");
+      print_json_times (fp, tv->elapsed);
+      first = false;
+
+      if (tv->children)
+	{
+	  bool first_child = true;
+	  fputs (", \"children\": [", fp);
+	  for (child_id = 0; child_id < (unsigned int) TIMEVAR_LAST;
+	       ++child_id)
+	    {
+	      timevar_def *child = &m_timevars[child_id];
+	      timevar_time_def *elapsed = tv->children->get (child);
+	      if (!elapsed)
+		continue;
+	      fprintf (fp, "%s\n      {\"name\": ", first_child ? "" : ",");
+	      print_json_string (fp, child->name);
+	      fputs (", ", fp);
+	      print_json_times (fp, *elapsed);
+	      putc ('}', fp);
+	      first_child = false;
+	    }
+	  fputs ("]", fp);
+	}
+      putc ('}', fp);
+    }
+  fputs ("],\n  \"passes\": [", fp);
+  if (m_pass_items)
+    m_pass_items->print_json (fp);
+  fputs ("],\n  \"counts\": [", fp);
+  if (m_count_items)
+    m_count_items->print_json (fp);
+  fputs ("],\n  \"total\": {", fp);
+  print_json_times (fp, m_timevars[TV_TOTAL].elapsed);
+#if defined HAVE_GETRUSAGE && defined HAVE_SYS_RESOURCE_H
+  /* The peak resident set size of the whole process, which unlike
+     ggc_mem includes memory not allocated by the garbage collector.
+     ru_maxrss is in kilobytes on most hosts.  */
+  struct rusage rusage;
+  if (getrusage (RUSAGE_SELF, &rusage) == 0)
+    fprintf (fp, ", \"max_rss_kb\": %ld", (long) rusage.ru_maxrss);
+#endif
+  fprintf (fp, "},\n  \"phases_consistent\": %s",
+	   sum_phases (&phases) ? "true" : "false");
+  fprintf (fp, ",\n  \"checking\": %s\n}\n",
+	   CHECKING_P || flag_checking ? "true" : "false");
+}
+
 /* Return whether ELAPSED is all zero.  */
 
 bool
@@ -712,6 +1408,12 @@ timer::print (FILE *fp)
      TIMEVAR.  */
   m_start_time = now;
 
+  if (flag_time_report_format == TIME_REPORT_FORMAT_JSON)
+    {
+      print_json (fp);
+      return;
+    }
+
   fputs ("\nExecution times (seconds)\n", fp);
   if (m_jit_client_items)
     fputs ("GCC items:\n", fp);
@@ -777,6 +1479,9 @@ timer::print (FILE *fp)
 #endif
   fprintf (fp, "%8u kB\n", (unsigned) (total->ggc_mem >> 10));
 
+  if (m_count_items)
+    m_count_items->print (fp);
+
   if (CHECKING_P || flag_checking)
     fprintf (fp, "Extra diagnostic checks enabled; compiler may run slowly.\n");
   if (CHECKING_P)
@@ -816,3 +1521,194 @@ print_time (const char *str, long total)
 	   all_time == 0 ? 0
 	   : (long) (((100.0 * (double) total) / (double) all_time) + .5));
 }
+
+#if CHECKING_P
+
+namespace selftest {
+
+static bool skip_json_value (const char **p);
+
+/* Skip the blanks at *P.  */
+
+static void
+skip_json_blanks (const char **p)
+{
+  while (ISSPACE (**p))
+    (*p)++;
+}
+
+/* Skip the JSON string at *P, and return whether it is well formed.  */
+
+static bool
+skip_json_string (const char **p)
+{
+  const char *s = *p;
+
+  if (*s++ != '"')
+    return false;
+  for (; *s != '"'; s++)
+    if ((unsigned char) *s < ' ')
+      return false;
+    else if (*s == '\\' && !*++s)
+      return false;
+  *p = s + 1;
+  return true;
+}
+
+/* Skip the elements of the JSON array or members of the JSON object at
+   *P, which is an object if OBJECT, and return whether they are well
+   formed.  */
+
+static bool
+skip_json_members (const char **p, bool object)
+{
+  const char close = object ? '}' : ']';
+
+  (*p)++;
+  skip_json_blanks (p);
+  if (**p == close)
+    {
+      (*p)++;
+      return true;
+    }
+  for (;;)
+    {
+      if (object)
+	{
+	  if (!skip_json_string (p))
+	    return false;
+	  skip_json_blanks (p);
+	  if (*(*p)++ != ':')
+	    return false;
+	}
+      if (!skip_json_value (p))
+	return false;
+      skip_json_blanks (p);
+      if (**p == close)
+	{
+	  (*p)++;
+	  return true;
+	}
+      if (*(*p)++ != ',')
+	return false;
+      skip_json_blanks (p);
+    }
+}
+
+/* Skip the JSON value at *P, and return whether it is well formed.  */
+
+static bool
+skip_json_value (const char **p)
+{
+  char *end;
+
+  skip_json_blanks (p);
+  switch (**p)
+    {
+    case '{':
+    case '[':
+      return skip_json_members (p, **p == '{');
+    case '"':
+      return skip_json_string (p);
+    case 't':
+    case 'n':
+      if (strncmp (*p, "true", 4) && strncmp (*p, "null", 4))
+	return false;
+      *p += 4;
+      return true;
+    case 'f':
+      if (strncmp (*p, "false", 5))
+	return false;
+      *p += 5;
+      return true;
+    default:
+      if (**p != '-' && !ISDIGIT (**p))
+	return false;
+      strtod (*p, &end);
+      *p = end;
+      return true;
+    }
+}
+
+/* Return the JSON report of timer T.  */
+
+static char *
+print_json_report (timer *t)
+{
+  enum time_report_format saved_format = flag_time_report_format;
+  FILE *f = tmpfile ();
+  long len;
+  char *buf;
+
+  ASSERT_TRUE (f != NULL);
+  flag_time_report_format = TIME_REPORT_FORMAT_JSON;
+  t->print (f);
+  flag_time_report_format = saved_format;
+  len = ftell (f);
+  rewind (f);
+  buf = XNEWVEC (char, len + 1);
+  ASSERT_EQ (fread (buf, 1, len, f), (size_t) len);
+  buf[len] = '\0';
+  fclose (f);
+  return buf;
+}
+
+/* Verify that the JSON report is well formed, lists children in the
+   order of timevar.def, and says whether the phases add up rather than
+   printing an error in the middle of it.  */
+
+static void
+test_print_json ()
+{
+  timer t;
+  char *report, *children;
+  const char *p;
+  bool saved_details = time_report_details;
+
+  time_report_details = true;
+  t.start (TV_TOTAL);
+  t.push (TV_PHASE_PARSING);
+  t.push (TV_CGRAPH);
+  t.pop (TV_CGRAPH);
+  t.push (TV_GC);
+  t.pop (TV_GC);
+  t.pop (TV_PHASE_PARSING);
+  t.stop (TV_TOTAL);
+  time_report_details = saved_details;
+
+  report = print_json_report (&t);
+  p = report;
+  ASSERT_TRUE (skip_json_value (&p));
+  skip_json_blanks (&p);
+  ASSERT_EQ (*p, '\0');
+  ASSERT_STR_CONTAINS (report, "\"phases_consistent\": true");
+  children = strstr (report, "\"children\"");
+  ASSERT_TRUE (children != NULL);
+  ASSERT_TRUE (strstr (children, "\"garbage collection\"")
+	       < strstr (children, "\"callgraph construction\""));
+  free (report);
+
+  /* Phases that take longer than the total, which is not timed at all
+     here, are reported rather than fatal.  */
+  timer t2;
+  t2.push (TV_PHASE_PARSING);
+  for (volatile unsigned i = 0; i < 1000000; i++)
+    ;
+  t2.pop (TV_PHASE_PARSING);
+  report = print_json_report (&t2);
+  p = report;
+  ASSERT_TRUE (skip_json_value (&p));
+  free (report);
+}
+
+/* Run all of the selftests within this file.  */
+
+void
+timevar_c_tests ()
+{
+  test_print_json ();
+}
+
+} // namespace selftest
+
+#endif /* CHECKING_P */
@@ -118,12 +118,25 @@ class timer
   void push_client_item (const char *item_name);
   void pop_client_item ();
 
+  void push_pass (const char *name, int id, const char *function);
+  void pop_pass (size_t ggc_heap_peak);
+
+  bool start_trace (const char *filename, unsigned min_duration);
+  void finish_trace ();
+  bool tracing_p () const { return m_trace != NULL; }
+  void trace_push (const char *category, const char *name);
+  void trace_pop ();
+  void trace_file_change (const char *filename, bool enter_p);
+
+  void add_count (const char *name, long value);
+
   void print (FILE *fp);
 
   const char *get_topmost_item_name () const;
 
  private:
   /* Private member functions.  */
+  bool sum_phases (timevar_time_def *phases) const;
   void validate_phases (FILE *fp) const;
 
   struct timevar_def;
@@ -133,6 +146,9 @@ class timer
 			 const timevar_time_def *total,
 			 const char *name, const timevar_time_def &elapsed);
   static bool all_zero (const timevar_time_def &elapsed);
+  void print_json (FILE *fp);
+  static void print_json_string (FILE *fp, const char *str);
+  static void print_json_times (FILE *fp, const timevar_time_def &elapsed);
 
  private:
   typedef hash_map<timevar_def *, timevar_time_def> child_map_t;
@@ -179,6 +195,19 @@ class timer
      from needing vec and hash_map.  */
   class named_items;
 
+  /* A class for accumulating the times and memory use of each
+     optimization pass, for -ftime-report-format=json.  Also declared
+     inside timevar.c.  */
+  class pass_items;
+
+  /* A class for writing the trace requested by -fself-profile.  Also
+     declared inside timevar.c.  */
+  class trace_writer;
+
+  /* A class for the event counts recorded by add_count.  Also declared
+     inside timevar.c.  */
+  class count_items;
+
  private:
 
   /* Data members (all private).  */
@@ -202,7 +231,19 @@ class timer
   /* If non-NULL, for use when timing libgccjit's client code.  */
   named_items *m_jit_client_items;
 
+  /* If non-NULL, the statistics recorded by push_pass and pop_pass.  */
+  pass_items *m_pass_items;
+
+  /* If non-NULL, the trace being written for -fself-profile.  */
+  trace_writer *m_trace;
+
+  /* If non-NULL, the counts recorded by add_count.  */
+  count_items *m_count_items;
+
   friend class named_items;
+  friend class pass_items;
+  friend class trace_writer;
+  friend class count_items;
 };
 
 /* Provided for backward compatibility.  */
@@ -220,6 +261,13 @@ timevar_pop (timevar_id_t tv)
     g_timer->pop (tv);
 }
 
+/* Return true if a trace is being written for -fself-profile.  */
+static inline bool
+timevar_trace_p (void)
+{
+  return g_timer && g_timer->tracing_p ();
+}
+
 // This is a simple timevar wrapper class that pushes a timevar in its
 // constructor and pops the timevar in its destructor.
 class auto_timevar
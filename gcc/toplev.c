@@ -172,6 +172,12 @@ FILE *asm_out_file;
 FILE *aux_info_file;
 FILE *stack_usage_file = NULL;
 
+/* Size of the stdio buffer used for ASM_OUT_FILE.  The assembly for a
+   large translation unit runs to many megabytes, and with the default
+   BUFSIZ-sized buffer final spends a noticeable amount of time in
+   write system calls.  */
+#define ASM_OUTPUT_BUFFER_SIZE (256 * 1024)
+
 /* The current working directory of a translation.  It's generally the
    directory from which compilation was initiated, but a preprocessed
    file may specify the original directory in which it was
@@ -899,6 +905,10 @@ init_asm_output (const char *name)
 		     "can%'t open %qs for writing: %m", asm_file_name);
     }
 
+  /* Nothing has been written to ASM_OUT_FILE yet, so we are still
+     allowed to replace its buffer.  */
+  setvbuf (asm_out_file, NULL, _IOFBF, ASM_OUTPUT_BUFFER_SIZE);
+
   if (!flag_syntax_only)
     {
       targetm.asm_out.file_start ();
@@ -2037,7 +2047,8 @@ toplev::~toplev ()
   if (g_timer && m_use_TV_TOTAL)
     {
       g_timer->stop (TV_TOTAL);
-      g_timer->print (stderr);
+      if (time_report || !quiet_flag || flag_detailed_statistics)
+	g_timer->print (stderr);
       delete g_timer;
       g_timer = NULL;
     }
@@ -2049,9 +2060,16 @@ toplev::~toplev ()
 void
 toplev::start_timevars ()
 {
-  if (time_report || !quiet_flag  || flag_detailed_statistics)
+  if (time_report || !quiet_flag  || flag_detailed_statistics
+      || flag_self_profile)
     timevar_init ();
 
+  if (flag_self_profile
+      && !g_timer->start_trace (flag_self_profile,
+				PARAM_VALUE (PARAM_SELF_PROFILE_MIN_DURATION)))
+    fatal_error (UNKNOWN_LOCATION, "can%'t open %s for writing: %m",
+		 flag_self_profile);
+
   timevar_start (TV_TOTAL);
 }
 
@@ -2070,9 +2088,14 @@ toplev::run_self_tests ()
   input_location = UNKNOWN_LOCATION;
   bitmap_obstack_initialize (NULL);
 
-  /* Run the tests; any failures will lead to an abort of the process.
-     Use "make selftests-gdb" to run under the debugger.  */
-  ::selftest::run_tests ();
+  if (flag_self_test == SELF_TEST_BENCH)
+    /* Time the benchmarks instead; "make selftest-bench" does this.  */
+    ::selftest::run_benchmarks (flag_time_report_format
+				== TIME_REPORT_FORMAT_JSON);
+  else
+    /* Run the tests; any failures will lead to an abort of the process.
+       Use "make selftests-gdb" to run under the debugger.  */
+    ::selftest::run_tests ();
 
   /* Cleanup.  */
   bitmap_obstack_release (NULL);
@@ -149,7 +149,12 @@ vn_nary_op_hasher::equal (const vn_nary_op_s *vno1, const vn_nary_op_s *vno2)
   return vn_nary_op_eq (vno1, vno2);
 }
 
-typedef hash_table<vn_nary_op_hasher> vn_nary_op_table_type;
+/* The equality functions of the value-numbering tables start by comparing
+   the hashcodes, so tagged tables can reject mismatches without touching
+   the entries.  */
+
+typedef hash_table<vn_nary_op_hasher, xcallocator, true>
+  vn_nary_op_table_type;
 typedef vn_nary_op_table_type::iterator vn_nary_op_iterator_type;
 
 
@@ -189,7 +194,7 @@ vn_phi_hasher::remove (vn_phi_s *phi)
   phi->phiargs.release ();
 }
 
-typedef hash_table<vn_phi_hasher> vn_phi_table_type;
+typedef hash_table<vn_phi_hasher, xcallocator, true> vn_phi_table_type;
 typedef vn_phi_table_type::iterator vn_phi_iterator_type;
 
 
@@ -251,7 +256,8 @@ vn_reference_hasher::remove (vn_reference_s *v)
   free_reference (v);
 }
 
-typedef hash_table<vn_reference_hasher> vn_reference_table_type;
+typedef hash_table<vn_reference_hasher, xcallocator, true>
+  vn_reference_table_type;
 typedef vn_reference_table_type::iterator vn_reference_iterator_type;
 
 
@@ -376,6 +376,35 @@ vec_c_tests ()
   test_qsort ();
 }
 
+/* Benchmark: safe_push onto a heap vector, which is emptied and freed
+   every 4096 elements so that growth is included.  */
+
+static void
+bench_safe_push (unsigned int iterations)
+{
+  vec <int> v = vNULL;
+  size_t sum = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      v.safe_push ((int) i);
+      if (v.length () == 4096)
+	{
+	  sum += v.last ();
+	  v.release ();
+	}
+    }
+  benchmark_consume (sum + v.length ());
+  v.release ();
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+vec_c_benchmarks ()
+{
+  run_benchmark ("vec/safe_push", bench_safe_push);
+}
+
 } // namespace selftest
 
 #endif /* #if CHECKING_P */
@@ -2312,5 +2312,59 @@ wide_int_cc_tests ()
  run_all_wide_int_tests <widest_int> ();
 }
 
+/* Return a 128-bit wide_int built from LOW and HIGH, with both halves
+   significant so that the multi-word code paths are timed.  */
+
+static wide_int
+bench_value (unsigned HOST_WIDE_INT low, unsigned HOST_WIDE_INT high)
+{
+  HOST_WIDE_INT elts[] = { (HOST_WIDE_INT) low, (HOST_WIDE_INT) high };
+  return wide_int::from_array (elts, 2, 128);
+}
+
+/* Benchmark: a 128-bit multiply-accumulate, x = x * a + b.  */
+
+static void
+bench_mul_add (unsigned int iterations)
+{
+  wide_int x = bench_value (1, 0);
+  wide_int a = bench_value (HOST_WIDE_INT_UC (0x5851f42d4c957f2d),
+			    HOST_WIDE_INT_UC (0x14057b7ef767814f));
+  wide_int b = bench_value (HOST_WIDE_INT_UC (0x9e3779b97f4a7c15), 1);
+  for (unsigned int i = 0; i < iterations; i++)
+    x = wi::add (wi::mul (x, a), b);
+  benchmark_consume (x.elt (0));
+}
+
+/* Benchmark: 128-bit unsigned division with remainder.  */
+
+static void
+bench_divmod (unsigned int iterations)
+{
+  wide_int x = bench_value (HOST_WIDE_INT_UC (0x0123456789abcdef),
+			    HOST_WIDE_INT_UC (0xfedcba9876543210));
+  wide_int d = bench_value (HOST_WIDE_INT_UC (0x9e3779b97f4a7c15), 3);
+  wide_int one = wi::one (128);
+  size_t sum = 0;
+  for (unsigned int i = 0; i < iterations; i++)
+    {
+      wide_int rem;
+      wide_int quot = wi::divmod_trunc (x, d, UNSIGNED, &rem);
+      sum += quot.elt (0);
+      /* Vary the dividend so that each division does real work.  */
+      x = wi::add (x, rem) | one;
+    }
+  benchmark_consume (sum);
+}
+
+/* Run all of the benchmarks within this file.  */
+
+void
+wide_int_cc_benchmarks ()
+{
+  run_benchmark ("wide_int/mul_add", bench_mul_add);
+  run_benchmark ("wide_int/divmod", bench_divmod);
+}
+
 } // namespace selftest
 #endif /* CHECKING_P */
@@ -31,6 +31,21 @@ along with this program; see the file COPYING3.  If not see
 #define DO_LINE_SPECIAL (DO_STRING | DO_CHAR | DO_LINE_COMMENT)
 #define DO_SPECIAL	(DO_LINE_SPECIAL | DO_BLOCK_COMMENT)
 
+/* Return true if C can only be stepped over by the scanner: it cannot
+   start or end a comment, a string or character constant, a line or a
+   directive.  */
+static inline bool
+do_plain_char_p (cppchar_t c)
+{
+  switch (c)
+    {
+    case '\\': case '/': case '*': case '\'': case '"': case '\n': case '#':
+      return false;
+    default:
+      return true;
+    }
+}
+
 /* Writes out the preprocessed file, handling spacing and paste
    avoidance issues.  */
 void
@@ -215,6 +230,35 @@ _cpp_preprocess_dir_only (cpp_reader *pfile,
 	    }
 	  break;
 	}
+
+      /* Step over a run of plain characters at once; most of the text
+	 is made of them.  A plain character following '#' or '/' still
+	 has to be looked at by the code above.  */
+      if (c != '#' && c != '/')
+	{
+	  const unsigned char *run = cur + 1;
+	  bool blank = true;
+
+	  if (flags & DO_SPECIAL)
+	    while (run < rlimit && do_plain_char_p (*run))
+	      run++;
+	  else
+	    for (; run < rlimit && do_plain_char_p (*run); run++)
+	      if (!is_nvspace (*run))
+		blank = false;
+
+	  if (run != cur + 1)
+	    {
+	      if (!blank)
+		{
+		  flags &= ~DO_BOL;
+		  pfile->mi_valid = false;
+		}
+	      col += run - cur - 1;
+	      cur = run - 1;
+	      c = *cur;
+	    }
+	}
     }
 
   if (flags & DO_BLOCK_COMMENT)
@@ -238,3 +282,28 @@ _cpp_preprocess_dir_only (cpp_reader *pfile,
   if (pfile->buffer)
     goto restart;
 }
+
+/* Output callbacks of cpp_scan_directives_only, which has none.  */
+static void
+ignore_lines (int lines ATTRIBUTE_UNUSED, const void *buf ATTRIBUTE_UNUSED,
+	      size_t size ATTRIBUTE_UNUSED)
+{
+}
+
+static void
+ignore_line (source_location loc ATTRIBUTE_UNUSED)
+{
+}
+
+/* Process the directives of the current buffer and of everything it
+   includes, discarding the rest of the text.  Macros are only
+   expanded within directives, so this is enough to find the
+   dependencies of a file, and much faster than cpp_scan_nooutput.  */
+void
+cpp_scan_directives_only (cpp_reader *pfile)
+{
+  static const struct _cpp_dir_only_callbacks cb
+    = { ignore_lines, ignore_line };
+
+  _cpp_preprocess_dir_only (pfile, &cb);
+}
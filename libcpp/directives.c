@@ -842,8 +842,16 @@ do_include_common (cpp_reader *pfile, enum include_type type)
     return;
   }
 
+  /* Skip the includes a -fpch-cache header has already done.  */
+  if (type == IT_INCLUDE
+      && CPP_OPTION (pfile, skip_primary_includes)
+      && cpp_in_primary_file (pfile))
+    {
+      CPP_OPTION (pfile, skip_primary_includes)--;
+      skip_rest_of_line (pfile);
+    }
   /* Prevent #include recursion.  */
-  if (pfile->line_table->depth >= CPP_STACK_MAX)
+  else if (pfile->line_table->depth >= CPP_STACK_MAX)
     cpp_error (pfile, CPP_DL_ERROR, "#include nested too deeply");
   else
     {
@@ -201,6 +201,9 @@ static bool validate_pch (cpp_reader *, _cpp_file *file, const char *pchname);
 static int pchf_save_compare (const void *e1, const void *e2);
 static int pchf_compare (const void *d_p, const void *e_p);
 static bool check_file_against_entries (cpp_reader *, _cpp_file *, bool);
+static struct include_cache *get_include_cache (cpp_reader *);
+static bool include_cache_absent_p (cpp_reader *, const char *path);
+static void include_cache_note_absent (cpp_reader *, const char *path);
 
 /* Given a filename in FILE->PATH, with the empty string interpreted
    as <stdin>, open it.
@@ -422,16 +425,23 @@ find_file_in_dir (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch,
 	}
 
       file->path = path;
-      if (pch_open_file (pfile, file, invalid_pch))
-	return true;
+      if (include_cache_absent_p (pfile, path))
+	file->err_no = ENOENT;
+      else
+	{
+	  if (pch_open_file (pfile, file, invalid_pch))
+	    return true;
 
-      if (open_file (file))
-	return true;
+	  if (open_file (file))
+	    return true;
 
-      if (file->err_no != ENOENT)
-	{
-	  open_file_failed (pfile, file, 0, loc);
-	  return true;
+	  if (file->err_no != ENOENT)
+	    {
+	      open_file_failed (pfile, file, 0, loc);
+	      return true;
+	    }
+
+	  include_cache_note_absent (pfile, path);
 	}
 
       /* We copy the path name onto an obstack partly so that we don't
@@ -1340,6 +1350,579 @@ cpp_clear_file_cache (cpp_reader *pfile)
   _cpp_init_files (pfile);
 }
 
+/* Make the parser forget which files have been included, and the
+   dependencies recorded for them, so that another main file can be
+   read with cpp_read_main_file.  Unlike cpp_clear_file_cache, this
+   keeps the results of looking files up in the search path, which
+   saves most of the system calls when preprocessing many files in
+   turn.  */
+void
+cpp_forget_included_files (cpp_reader *pfile)
+{
+  _cpp_file *f;
+
+  for (f = pfile->all_files; f; f = f->next_file)
+    {
+      f->stack_count = 0;
+      f->once_only = false;
+    }
+  pfile->seen_once_only = false;
+  pfile->counter = 0;
+
+  if (pfile->deps)
+    {
+      deps_free (pfile->deps);
+      pfile->deps = NULL;
+    }
+}
+
+/* The include cache remembers, in a file shared between compilations,
+   the paths that were looked for in vain in the search path, so that
+   later compilations need not probe for them again.  Each such path is
+   recorded against the nearest directory above it that exists,
+   together with the modification time and inode number of that
+   directory: creating the missing path, or any directory leading to
+   it, changes the modification time and so invalidates what was
+   recorded.  A directory is checked with a single stat the first time
+   one of its paths is looked up, which saves the failed opens of all
+   its other missing paths and of their PCH files.  A path that leads
+   through a symbolic link to nothing, or to something other than a
+   directory, is not recorded: the target of the link can appear without
+   any directory above the path changing.
+
+   Compilations that share the file merge what they found with what is
+   on disk just before they write it, so that each one adds to the
+   file rather than replacing what the others recorded.
+
+   The file is text, of the form
+
+     GCC include cache 1
+     d MTIME INODE DIRECTORY
+     a PATH
+     ...
+
+   where each "a" line gives a missing path recorded against the
+   directory of the "d" line before it.  All names are absolute.  */
+
+#define INCLUDE_CACHE_MAGIC "GCC include cache 1\n"
+
+enum include_cache_state
+{
+  /* Read from the file but not compared with the disk yet.  */
+  IC_UNCHECKED,
+  /* Unchanged on disk, so the paths recorded against it are missing.  */
+  IC_VALID,
+  /* Modified so recently that a further change might not show in its
+     modification time, not stat'able, or a symbolic link to something
+     other than a directory.  Nothing is recorded against it.  */
+  IC_UNSURE,
+  /* Not a directory, or not there at all.  */
+  IC_GONE
+};
+
+/* A directory of the include cache.  */
+struct include_cache_dir
+{
+  /* This must be the first field; see include_cache_hash.  */
+  const char *name;
+  long mtime;
+  unsigned long ino;
+  enum include_cache_state state;
+  /* The paths recorded against this directory.  */
+  struct include_cache_entry *entries;
+  struct include_cache_dir *next;
+};
+
+/* A missing path of the include cache.  */
+struct include_cache_entry
+{
+  /* This must be the first field; see include_cache_hash.  */
+  const char *path;
+  /* The directory the path is recorded against, or NULL if that
+     directory has changed.  */
+  struct include_cache_dir *dir;
+  struct include_cache_entry *next;
+};
+
+struct include_cache
+{
+  /* The include_cache_entry of each path and the include_cache_dir of
+     each directory, hashed by name.  */
+  htab_t entries;
+  htab_t dirs;
+  /* All the directories, in the order they were entered.  */
+  struct include_cache_dir *dir_list;
+  struct include_cache_dir **dir_tail;
+  struct obstack ob;
+  /* The current directory, to make relative paths absolute, or NULL
+     if it is not known.  */
+  const char *pwd;
+  /* When this compilation started.  */
+  time_t now;
+  /* True if the file needs to be written out again.  */
+  bool dirty;
+  /* The number of lookups answered by the cache, and the number of
+     times a directory was stat'ed to keep it up to date.  */
+  unsigned long hits;
+  unsigned long checks;
+};
+
+/* Hash and compare the entries and directories of the include cache,
+   whose first field is their name, against a name.  */
+static hashval_t
+include_cache_hash (const void *p)
+{
+  return htab_hash_string (*(const char *const *) p);
+}
+
+static int
+include_cache_eq (const void *p, const void *q)
+{
+  return filename_cmp (*(const char *const *) p, (const char *) q) == 0;
+}
+
+/* Return the directory named NAME in CACHE, or NULL if there is none.
+   If INSERT, make a new directory of that name instead, in state
+   IC_GONE, and return it.  */
+static struct include_cache_dir *
+include_cache_dir (struct include_cache *cache, const char *name, bool insert)
+{
+  struct include_cache_dir *dir;
+  void **slot;
+
+  slot = htab_find_slot_with_hash (cache->dirs, name, htab_hash_string (name),
+				   insert ? INSERT : NO_INSERT);
+  if (slot == NULL || *slot != NULL || !insert)
+    return slot ? (struct include_cache_dir *) *slot : NULL;
+
+  dir = XOBNEW (&cache->ob, struct include_cache_dir);
+  dir->name = (const char *) obstack_copy0 (&cache->ob, name, strlen (name));
+  dir->mtime = 0;
+  dir->ino = 0;
+  dir->state = IC_GONE;
+  dir->entries = NULL;
+  dir->next = NULL;
+  *cache->dir_tail = dir;
+  cache->dir_tail = &dir->next;
+  *slot = dir;
+  return dir;
+}
+
+/* Return the entry for PATH in CACHE, making it if INSERT; otherwise
+   return NULL if there is none.  */
+static struct include_cache_entry *
+include_cache_entry (struct include_cache *cache, const char *path,
+		     bool insert)
+{
+  struct include_cache_entry *entry;
+  void **slot;
+
+  slot = htab_find_slot_with_hash (cache->entries, path,
+				   htab_hash_string (path),
+				   insert ? INSERT : NO_INSERT);
+  if (slot == NULL || *slot != NULL || !insert)
+    return slot ? (struct include_cache_entry *) *slot : NULL;
+
+  entry = XOBNEW (&cache->ob, struct include_cache_entry);
+  entry->path = (const char *) obstack_copy0 (&cache->ob, path,
+					      strlen (path));
+  entry->dir = NULL;
+  entry->next = NULL;
+  *slot = entry;
+  return entry;
+}
+
+/* Record ENTRY as missing from DIR.  */
+static void
+include_cache_add (struct include_cache_entry *entry,
+		   struct include_cache_dir *dir)
+{
+  entry->dir = dir;
+  entry->next = dir->entries;
+  dir->entries = entry;
+}
+
+/* Forget the paths recorded against DIR.  */
+static void
+include_cache_forget (struct include_cache *cache,
+		      struct include_cache_dir *dir)
+{
+  struct include_cache_entry *entry;
+
+  for (entry = dir->entries; entry; entry = entry->next)
+    entry->dir = NULL;
+  if (dir->entries)
+    cache->dirty = true;
+  dir->entries = NULL;
+}
+
+/* Return true if NAME is a symbolic link.  */
+static bool
+include_cache_symlink_p (const char *name)
+{
+#ifdef S_ISLNK
+  struct stat st;
+
+  return lstat (name, &st) == 0 && S_ISLNK (st.st_mode);
+#else
+  return false;
+#endif
+}
+
+/* Stat DIR, which was either read from the file or has just been
+   made, and bring its state up to date.  If it has changed since it
+   was recorded, forget the paths recorded against it.  */
+static void
+include_cache_check_dir (struct include_cache *cache,
+			 struct include_cache_dir *dir)
+{
+  struct stat st;
+
+  cache->checks++;
+  if (stat (dir->name, &st) != 0)
+    {
+      include_cache_forget (cache, dir);
+      dir->state = ((errno == ENOENT || errno == ENOTDIR)
+		    && !include_cache_symlink_p (dir->name)
+		    ? IC_GONE : IC_UNSURE);
+      return;
+    }
+  if (!S_ISDIR (st.st_mode))
+    {
+      include_cache_forget (cache, dir);
+      dir->state = include_cache_symlink_p (dir->name) ? IC_UNSURE : IC_GONE;
+      return;
+    }
+
+  if (dir->state == IC_UNCHECKED
+      && dir->mtime == (long) st.st_mtime
+      && dir->ino == (unsigned long) st.st_ino)
+    {
+      dir->state = IC_VALID;
+      return;
+    }
+
+  include_cache_forget (cache, dir);
+  dir->mtime = (long) st.st_mtime;
+  dir->ino = (unsigned long) st.st_ino;
+  /* Allow for file systems that keep modification times to the nearest
+     two seconds.  */
+  dir->state = st.st_mtime >= cache->now - 2 ? IC_UNSURE : IC_VALID;
+}
+
+/* Read the include cache file of PFILE into CACHE, merging it with
+   what CACHE already holds.  A missing or unreadable file is an empty
+   cache, and whatever follows a line that does not parse is ignored.
+
+   The paths the file records against a directory that CACHE has not
+   checked yet are added to it; if the file and CACHE disagree about
+   the directory, the file is taken to be newer.  The paths recorded
+   against a directory that CACHE has checked are added only if the
+   file saw the directory as CACHE did.  */
+static void
+read_include_cache (cpp_reader *pfile, struct include_cache *cache)
+{
+  size_t magic_len = strlen (INCLUDE_CACHE_MAGIC);
+  struct include_cache_dir *dir = NULL;
+  struct include_cache_entry *entry;
+  bool skip = false;
+  struct stat st;
+  char *buf, *p, *q, *eol;
+  size_t size = 0;
+  ssize_t count;
+  int fd;
+
+  fd = open (CPP_OPTION (pfile, include_cache),
+	     O_RDONLY | O_NOCTTY | O_BINARY, 0666);
+  if (fd == -1)
+    return;
+  if (fstat (fd, &st) != 0 || st.st_size < (off_t) magic_len)
+    {
+      close (fd);
+      return;
+    }
+
+  buf = XNEWVEC (char, st.st_size + 1);
+  while (size < (size_t) st.st_size
+	 && (count = read (fd, buf + size, st.st_size - size)) > 0)
+    size += count;
+  close (fd);
+  buf[size] = '\0';
+
+  if (size < magic_len || memcmp (buf, INCLUDE_CACHE_MAGIC, magic_len) != 0)
+    {
+      free (buf);
+      return;
+    }
+
+  for (p = buf + magic_len;
+       (eol = (char *) memchr (p, '\n', buf + size - p)) != NULL;
+       p = eol + 1)
+    {
+      *eol = '\0';
+      if (p[0] == 'd' && p[1] == ' ')
+	{
+	  long mtime = strtol (p + 2, &q, 10);
+	  unsigned long ino;
+
+	  if (*q != ' ')
+	    break;
+	  ino = strtoul (q + 1, &q, 10);
+	  if (*q != ' ' || !IS_ABSOLUTE_PATH (q + 1))
+	    break;
+	  dir = include_cache_dir (cache, q + 1, false);
+	  if (dir == NULL)
+	    {
+	      dir = include_cache_dir (cache, q + 1, true);
+	      dir->state = IC_UNCHECKED;
+	    }
+	  skip = false;
+	  if (dir->mtime == mtime && dir->ino == ino)
+	    skip = dir->state != IC_UNCHECKED && dir->state != IC_VALID;
+	  else if (dir->state == IC_UNCHECKED)
+	    {
+	      include_cache_forget (cache, dir);
+	      dir->mtime = mtime;
+	      dir->ino = ino;
+	    }
+	  else
+	    skip = true;
+	}
+      else if (p[0] == 'a' && p[1] == ' ' && dir
+	       && IS_ABSOLUTE_PATH (p + 2))
+	{
+	  if (skip)
+	    continue;
+	  entry = include_cache_entry (cache, p + 2, true);
+	  if (entry->dir == NULL)
+	    include_cache_add (entry, dir);
+	}
+      else
+	break;
+    }
+
+  free (buf);
+}
+
+/* Return the include cache of PFILE, reading it in the first time, or
+   NULL if there is none.  */
+static struct include_cache *
+get_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+
+  if (cache || CPP_OPTION (pfile, include_cache) == NULL)
+    return cache;
+
+  cache = XNEW (struct include_cache);
+  cache->entries = htab_create_alloc (127, include_cache_hash,
+				      include_cache_eq, NULL, xcalloc, free);
+  cache->dirs = htab_create_alloc (127, include_cache_hash,
+				   include_cache_eq, NULL, xcalloc, free);
+  cache->dir_list = NULL;
+  cache->dir_tail = &cache->dir_list;
+  obstack_specify_allocation (&cache->ob, 0, 0, xmalloc, free);
+  cache->pwd = getpwd ();
+  cache->now = time (NULL);
+  cache->dirty = false;
+  cache->hits = 0;
+  cache->checks = 0;
+  read_include_cache (pfile, cache);
+
+  pfile->include_cache = cache;
+  return cache;
+}
+
+/* Make *PATH absolute for CACHE, and return false if that cannot be
+   done.  If a new string was needed, *COPY points to it as well, and
+   is otherwise NULL.  */
+static bool
+include_cache_absolute (struct include_cache *cache, const char **path,
+			char **copy)
+{
+  *copy = NULL;
+  if (IS_ABSOLUTE_PATH (*path))
+    return true;
+  if (cache->pwd == NULL || **path == '\0')
+    return false;
+  *path = *copy = concat (cache->pwd, "/", *path, NULL);
+  return true;
+}
+
+/* Return true if the include cache of PFILE knows PATH to be missing,
+   so that there is no need to look for it.  */
+static bool
+include_cache_absent_p (cpp_reader *pfile, const char *path)
+{
+  struct include_cache *cache = get_include_cache (pfile);
+  struct include_cache_entry *entry;
+  bool absent = false;
+  char *copy;
+
+  if (cache == NULL || !include_cache_absolute (cache, &path, &copy))
+    return false;
+
+  entry = include_cache_entry (cache, path, false);
+  if (entry && entry->dir && entry->dir->state == IC_UNCHECKED)
+    include_cache_check_dir (cache, entry->dir);
+  /* The check forgets ENTRY if its directory has changed.  */
+  if (entry && entry->dir && entry->dir->state == IC_VALID)
+    {
+      cache->hits++;
+      absent = true;
+    }
+
+  free (copy);
+  return absent;
+}
+
+/* Record in the include cache of PFILE that PATH, which was just
+   looked for, is missing.  */
+static void
+include_cache_note_absent (cpp_reader *pfile, const char *path)
+{
+  struct include_cache *cache = get_include_cache (pfile);
+  struct include_cache_entry *entry;
+  struct include_cache_dir *dir = NULL;
+  char *copy, *name, *sep;
+
+  if (cache == NULL || !include_cache_absolute (cache, &path, &copy))
+    return;
+
+  /* The target of a symbolic link can appear without any directory above
+     the link changing.  */
+  if (include_cache_symlink_p (path))
+    {
+      free (copy);
+      return;
+    }
+
+  /* Find the nearest directory above PATH that exists.  */
+  name = xstrdup (path);
+  for (;;)
+    {
+      sep = name + strlen (name);
+      while (sep > name && !IS_DIR_SEPARATOR (sep[-1]))
+	sep--;
+      if (sep == name)
+	break;
+      /* Keep the separator of a root directory.  */
+      if (sep - 1 != name && sep[-2] != ':')
+	sep--;
+      if (*sep == '\0')
+	break;
+      *sep = '\0';
+
+      dir = include_cache_dir (cache, name, false);
+      if (dir == NULL)
+	{
+	  dir = include_cache_dir (cache, name, true);
+	  include_cache_check_dir (cache, dir);
+	}
+      else if (dir->state == IC_UNCHECKED)
+	include_cache_check_dir (cache, dir);
+      if (dir->state != IC_GONE)
+	break;
+    }
+
+  if (dir && dir->state == IC_VALID)
+    {
+      entry = include_cache_entry (cache, path, true);
+      if (entry->dir == NULL)
+	{
+	  include_cache_add (entry, dir);
+	  cache->dirty = true;
+	}
+    }
+
+  free (name);
+  free (copy);
+}
+
+/* Write out the include cache of PFILE if it has changed.  */
+void
+_cpp_save_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+  struct include_cache_dir *dir;
+  struct include_cache_entry *entry;
+  const char *fname;
+  char *tmp;
+  FILE *f;
+  bool ok;
+
+  if (cache == NULL || !cache->dirty)
+    return;
+
+  /* Pick up what other compilations sharing the file have written since
+     it was read.  Then write a new file and rename it over the old one,
+     so that they never see it half written.  */
+  read_include_cache (pfile, cache);
+  cache->dirty = false;
+  fname = CPP_OPTION (pfile, include_cache);
+  tmp = xasprintf ("%s.%ld", fname, (long) getpid ());
+  f = fopen (tmp, "wb");
+  if (f == NULL)
+    {
+      cpp_errno_filename (pfile, CPP_DL_WARNING, tmp, 0);
+      free (tmp);
+      return;
+    }
+
+  fputs (INCLUDE_CACHE_MAGIC, f);
+  for (dir = cache->dir_list; dir; dir = dir->next)
+    if (dir->entries && strchr (dir->name, '\n') == NULL)
+      {
+	fprintf (f, "d %ld %lu %s\n", dir->mtime, dir->ino, dir->name);
+	for (entry = dir->entries; entry; entry = entry->next)
+	  if (strchr (entry->path, '\n') == NULL)
+	    fprintf (f, "a %s\n", entry->path);
+      }
+
+  ok = !ferror (f);
+  if (fclose (f) != 0)
+    ok = false;
+  if (!ok)
+    cpp_errno_filename (pfile, CPP_DL_WARNING, tmp, 0);
+  else if (rename (tmp, fname) != 0)
+    {
+      cpp_errno_filename (pfile, CPP_DL_WARNING, fname, 0);
+      ok = false;
+    }
+  if (!ok)
+    unlink (tmp);
+  free (tmp);
+}
+
+/* Free the include cache of PFILE.  */
+void
+_cpp_free_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+
+  if (cache == NULL)
+    return;
+
+  htab_delete (cache->entries);
+  htab_delete (cache->dirs);
+  obstack_free (&cache->ob, 0);
+  free (cache);
+  pfile->include_cache = NULL;
+}
+
+/* Set *HITS to the number of times the include cache of PFILE made
+   looking for a file unnecessary, and *CHECKS to the number of times
+   it had to stat a directory to be sure of that.  */
+void
+cpp_get_include_cache_stats (cpp_reader *pfile, unsigned long *hits,
+			     unsigned long *checks)
+{
+  struct include_cache *cache = pfile->include_cache;
+
+  *hits = cache ? cache->hits : 0;
+  *checks = cache ? cache->checks : 0;
+}
+
 /* Enter a file name in the hash for the sake of cpp_included.  */
 void
 _cpp_fake_include (cpp_reader *pfile, const char *fname)
@@ -1859,6 +2442,11 @@ _cpp_save_file_entries (cpp_reader *pfile, FILE *fp)
       if (f->stack_count == 0)
 	continue;
 
+      /* Standard input cannot be read again, and being the main file
+	 nothing can include it.  */
+      if (!f->buffer_valid && f->path[0] == '\0')
+	continue;
+
       count = result->count++;
 
       result->entries[count].once_only = f->once_only;
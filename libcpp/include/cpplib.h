@@ -489,6 +489,15 @@ struct cpp_options
   /* True if dependencies should be restored from a precompiled header.  */
   bool restore_pch_deps;
 
+  /* Number of leading #include directives of the primary source file
+     to ignore, because a header read with -include has already
+     included the same files.  */
+  unsigned int skip_primary_includes;
+
+  /* File in which to remember the include files that were looked for
+     in vain between runs, or NULL.  */
+  const char *include_cache;
+
   /* True if warn about differences between C90 and C99.  */
   signed char cpp_warn_c90_c99_compat;
 
@@ -1157,6 +1166,12 @@ extern cpp_buffer *cpp_get_buffer (cpp_reader *);
 extern struct _cpp_file *cpp_get_file (cpp_buffer *);
 extern cpp_buffer *cpp_get_prev (cpp_buffer *);
 extern void cpp_clear_file_cache (cpp_reader *);
+extern void cpp_forget_included_files (cpp_reader *);
+extern void cpp_get_include_cache_stats (cpp_reader *, unsigned long *,
+					 unsigned long *);
+
+/* In directives-only.c */
+extern void cpp_scan_directives_only (cpp_reader *);
 
 /* In pch.c */
 struct save_macro_data;
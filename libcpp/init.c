@@ -311,6 +311,7 @@ cpp_destroy (cpp_reader *pfile)
 
   _cpp_destroy_hashtable (pfile);
   _cpp_cleanup_files (pfile);
+  _cpp_free_include_cache (pfile);
   _cpp_destroy_iconv (pfile);
 
   _cpp_free_buff (pfile->a_buff);
@@ -759,6 +760,9 @@ cpp_finish (cpp_reader *pfile, FILE *deps_stream)
   /* Report on headers that could use multiple include guards.  */
   if (CPP_OPTION (pfile, print_include_names))
     _cpp_report_missing_guards (pfile);
+
+  /* Remember for later runs the headers that were looked for in vain.  */
+  _cpp_save_include_cache (pfile);
 }
 
 static void
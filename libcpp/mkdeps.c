@@ -43,6 +43,7 @@ struct deps
 };
 
 static const char *munge (const char *);
+static bool has_dep_p (struct deps *, const char *);
 
 /* Given a filename, quote characters in that filename which are
    significant to Make.  Note that it's not possible to quote all such
@@ -265,6 +266,22 @@ deps_add_dep (struct deps *d, const char *t)
   d->depv[d->ndeps++] = t;
 }
 
+/* Return true if T, named as deps_add_dep would name it, is among the
+   dependencies of D already.  */
+static bool
+has_dep_p (struct deps *d, const char *t)
+{
+  const char *m = munge (apply_vpath (d, t));
+  unsigned int i;
+  bool found = false;
+
+  for (i = 0; i < d->ndeps && !found; i++)
+    found = strcmp (d->depv[i], m) == 0;
+
+  free ((char *) m);
+  return found;
+}
+
 void
 deps_add_vpath (struct deps *d, const char *vpath)
 {
@@ -427,8 +444,11 @@ deps_restore (struct deps *deps, FILE *fd, const char *self)
 	}
       buf[num_to_read] = '\0';
 
-      /* Generate makefile dependencies from .pch if -nopch-deps.  */
-      if (self != NULL && filename_cmp (buf, self) != 0)
+      /* Generate makefile dependencies from .pch if -nopch-deps.  Leave
+	 out those listed already, such as a header that both the .pch and
+	 this compilation included implicitly.  */
+      if (self != NULL && filename_cmp (buf, self) != 0
+	  && !has_dep_p (deps, buf))
         deps_add_dep (deps, buf);
     }
 
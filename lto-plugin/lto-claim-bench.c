@@ -0,0 +1,292 @@
+/* Benchmark for the claim_file handler of the LTO plugin.
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3, or (at your option)
+any later version.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING3.  If not see
+<http://www.gnu.org/licenses/>.  */
+
+/* This program plays the part of the linker: it loads the plugin and
+   asks it to claim every member of an archive in order, the way the
+   linker does for --whole-archive, and reports how long that took.
+   It is not built by default:
+
+     gcc -O2 -DHAVE_STDINT_H -I../include -o lto-claim-bench \
+       lto-claim-bench.c -ldl
+
+   To make a synthetic archive of N members cycling through some LTO
+   objects, compiled with -flto:
+
+     lto-claim-bench -n 10000 -o synth.a a.o b.o c.o
+
+   To time claiming its members with the plugin using J helper threads
+   to read symbol tables ahead (0 to read them on the calling thread):
+
+     lto-claim-bench -j J path/to/liblto_plugin.so synth.a  */
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "plugin-api.h"
+
+static ld_plugin_claim_file_handler claim_file_handler;
+static ld_plugin_cleanup_handler cleanup_handler;
+
+/* The number of symbols the plugin added.  */
+static unsigned long num_symbols;
+
+static enum ld_plugin_status
+register_claim_file (ld_plugin_claim_file_handler handler)
+{
+  claim_file_handler = handler;
+  return LDPS_OK;
+}
+
+static enum ld_plugin_status
+register_cleanup (ld_plugin_cleanup_handler handler)
+{
+  cleanup_handler = handler;
+  return LDPS_OK;
+}
+
+static enum ld_plugin_status
+add_symbols (void *handle, int nsyms, const struct ld_plugin_symbol *syms)
+{
+  num_symbols += nsyms;
+  return LDPS_OK;
+}
+
+static enum ld_plugin_status
+message (int level, const char *format, ...)
+{
+  va_list ap;
+
+  va_start (ap, format);
+  vfprintf (stderr, format, ap);
+  va_end (ap);
+  fputc ('\n', stderr);
+  if (level == LDPL_FATAL)
+    exit (1);
+  return LDPS_OK;
+}
+
+/* Write an archive named NAME with NMEMBERS members, which cycle through
+   the NFILES files in FILES.  Every other member has a name too long for
+   its header, which goes in the long name table the way GNU ar does.  */
+
+static void
+write_archive (const char *name, unsigned nmembers, char **files,
+	       unsigned nfiles)
+{
+  FILE *out = fopen (name, "wb");
+  char **data = calloc (nfiles, sizeof (char *));
+  long *size = calloc (nfiles, sizeof (long));
+  char *names = malloc (nmembers / 2 * 32 + 2);
+  long names_size = 0;
+  unsigned i;
+
+  assert (out && data && size && names);
+  for (i = 0; i < nfiles; i++)
+    {
+      FILE *in = fopen (files[i], "rb");
+      assert (in);
+      fseek (in, 0, SEEK_END);
+      size[i] = ftell (in);
+      rewind (in);
+      data[i] = malloc (size[i]);
+      assert (data[i] && fread (data[i], 1, size[i], in) == size[i]);
+      fclose (in);
+    }
+
+  fputs ("!<arch>\n", out);
+  for (i = 1; i < nmembers; i += 2)
+    names_size += sprintf (names + names_size, "long_member_%010u.o/\n", i);
+  if (names_size & 1)
+    names[names_size++] = '\n';
+  if (names_size)
+    {
+      fprintf (out, "%-16s%-12s%-6s%-6s%-8s%-10ld`\n", "//", "", "", "", "",
+	       names_size);
+      fwrite (names, 1, names_size, out);
+    }
+
+  names_size = 0;
+  for (i = 0; i < nmembers; i++)
+    {
+      unsigned f = i % nfiles;
+      char member[17];
+
+      if (i & 1)
+	{
+	  snprintf (member, sizeof (member), "/%ld", names_size);
+	  names_size += strlen ("long_member_0000000000.o/\n");
+	}
+      else
+	snprintf (member, sizeof (member), "m%u.o/", i);
+      fprintf (out, "%-16s%-12s%-6s%-6s%-8s%-10ld`\n", member, "0", "0", "0",
+	       "644", size[f]);
+      fwrite (data[f], 1, size[f], out);
+      if (size[f] & 1)
+	fputc ('\n', out);
+    }
+  assert (fclose (out) == 0);
+}
+
+/* Load the plugin named NAME with option OPTION.  */
+
+static void
+load_plugin (const char *name, const char *option)
+{
+  struct ld_plugin_tv tv[] = {
+    {LDPT_MESSAGE, {.tv_message = message}},
+    {LDPT_REGISTER_CLAIM_FILE_HOOK,
+     {.tv_register_claim_file = register_claim_file}},
+    {LDPT_ADD_SYMBOLS, {.tv_add_symbols = add_symbols}},
+    {LDPT_REGISTER_CLEANUP_HOOK, {.tv_register_cleanup = register_cleanup}},
+    {LDPT_OPTION, {.tv_string = option}},
+    {0, {0}}
+  };
+  void *handle = dlopen (name, RTLD_NOW);
+  ld_plugin_onload onload;
+
+  if (!handle)
+    {
+      fprintf (stderr, "%s\n", dlerror ());
+      exit (1);
+    }
+  onload = (ld_plugin_onload) dlsym (handle, "onload");
+  assert (onload);
+  assert (onload (tv) == LDPS_OK && claim_file_handler);
+}
+
+/* Return the current time in seconds.  */
+
+static double
+now (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Ask the plugin to claim the members of the archive named NAME, and
+   return the number of members and of claimed members in *NMEMBERS and
+   *NCLAIMED.  */
+
+static void
+claim_archive (const char *name, unsigned *nmembers, unsigned *nclaimed)
+{
+  int fd = open (name, O_RDONLY);
+  struct stat st;
+  char magic[8];
+  off_t offset = 8;
+
+  assert (fd >= 0 && fstat (fd, &st) == 0);
+  assert (read (fd, magic, 8) == 8 && memcmp (magic, "!<arch>\n", 8) == 0);
+  *nmembers = *nclaimed = 0;
+  while (offset + 60 <= st.st_size)
+    {
+      struct ld_plugin_input_file file;
+      char hdr[61];
+      long size;
+      int claimed;
+
+      assert (pread (fd, hdr, 60, offset) == 60);
+      hdr[58] = '\0';
+      size = strtol (hdr + 48, NULL, 10);
+      /* Skip the symbol table and the long name table.  */
+      if (hdr[0] != '/' || (hdr[1] != ' ' && hdr[1] != '/'))
+	{
+	  file.name = name;
+	  file.fd = fd;
+	  file.offset = offset + 60;
+	  file.filesize = size;
+	  file.handle = NULL;
+	  claim_file_handler (&file, &claimed);
+	  (*nmembers)++;
+	  *nclaimed += claimed;
+	}
+      offset += 60 + size + (size & 1);
+    }
+  close (fd);
+}
+
+static void
+usage (void)
+{
+  fprintf (stderr, "usage: lto-claim-bench -n N -o ARCHIVE OBJECT...\n"
+	   "       lto-claim-bench [-j THREADS] PLUGIN ARCHIVE\n");
+  exit (2);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *threads = "4";
+  const char *output = NULL;
+  unsigned nmembers = 0, nclaimed;
+  char option[64];
+  double start, wall;
+  clock_t cpu;
+  int c;
+
+  while ((c = getopt (argc, argv, "j:n:o:")) != -1)
+    switch (c)
+      {
+      case 'j':
+	threads = optarg;
+	break;
+      case 'n':
+	nmembers = atoi (optarg);
+	break;
+      case 'o':
+	output = optarg;
+	break;
+      default:
+	usage ();
+      }
+
+  if (output)
+    {
+      if (!nmembers || optind >= argc)
+	usage ();
+      write_archive (output, nmembers, argv + optind, argc - optind);
+      return 0;
+    }
+
+  if (argc - optind != 2)
+    usage ();
+  snprintf (option, sizeof (option), "-symtab-threads=%s", threads);
+  load_plugin (argv[optind], option);
+
+  start = now ();
+  cpu = clock ();
+  claim_archive (argv[optind + 1], &nmembers, &nclaimed);
+  if (cleanup_handler)
+    cleanup_handler ();
+  wall = now () - start;
+  cpu = clock () - cpu;
+
+  printf ("%u members, %u claimed, %lu symbols: %.3fs elapsed, %.3fs CPU\n",
+	  nmembers, nclaimed, num_symbols, wall, (double) cpu / CLOCKS_PER_SEC);
+  return 0;
+}
@@ -27,10 +27,12 @@ along with this program; see the file COPYING3.  If not see
    More information at http://gcc.gnu.org/wiki/whopr/driver.
 
    This plugin should be passed the lto-wrapper options and will forward them.
-   It also has 2 options of its own:
+   It also has 3 options of its own:
    -debug: Print the command line used to run lto-wrapper.
    -nop: Instead of running lto-wrapper, pass the original to the plugin. This
-   only works if the input files are hybrid.  */
+   only works if the input files are hybrid.
+   -symtab-threads=N: Read the symbol tables of archive members ahead on N
+   helper threads (4 by default, 0 to disable, at most 1024).  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -57,6 +59,9 @@ along with this program; see the file COPYING3.  If not see
 #ifndef WEXITSTATUS
 #define WEXITSTATUS(S) (((S) & 0xff00) >> 8)
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include <libiberty.h>
 #include <hashtab.h>
 #include "../gcc/lto/common.h"
@@ -117,6 +122,10 @@ struct plugin_objfile
   simple_object_read *objfile;
   struct plugin_symtab *out;
   const struct ld_plugin_input_file *file;
+  /* Nonzero when scanning ahead on a helper thread, which must not call
+     the linker.  Errors are then not reported but left for
+     claim_file_handler to find again.  */
+  int prefetch;
 };
 
 /* All that we have to remember about a file. */
@@ -195,6 +204,10 @@ static int gold_version = -1;
    (in fact, only first letter of style arg is checked.)  */
 static enum symbol_style sym_style = ss_none;
 
+#ifdef HAVE_PTHREAD
+static void stop_prefetch (void);
+#endif
+
 static void
 check_1 (int gate, enum ld_plugin_level level, const char *text)
 {
@@ -219,11 +232,12 @@ check_1 (int gate, enum ld_plugin_level level, const char *text)
 
 /* Parse an entry of the IL symbol table. The data to be parsed is pointed
    by P and the result is written in ENTRY. The slot number is stored in SLOT.
-   Returns the address of the next entry. */
+   Returns the address of the next entry, or NULL and an error message in
+   *ERRMSG if the entry is invalid. */
 
 static char *
 parse_table_entry (char *p, struct ld_plugin_symbol *entry, 
-		   struct sym_aux *aux)
+		   struct sym_aux *aux, const char **errmsg)
 {
   unsigned char t;
   enum ld_plugin_symbol_kind translate_kind[] =
@@ -278,12 +292,20 @@ parse_table_entry (char *p, struct ld_plugin_symbol *entry,
     entry->comdat_key = xstrdup (entry->comdat_key);
 
   t = *p;
-  check (t <= 4, LDPL_FATAL, "invalid symbol kind found");
+  if (t > 4)
+    {
+      *errmsg = "invalid symbol kind found";
+      return NULL;
+    }
   entry->def = translate_kind[t];
   p++;
 
   t = *p;
-  check (t <= 3, LDPL_FATAL, "invalid symbol visibility found");
+  if (t > 3)
+    {
+      *errmsg = "invalid symbol visibility found";
+      return NULL;
+    }
   entry->visibility = translate_visibility[t];
   p++;
 
@@ -301,11 +323,13 @@ parse_table_entry (char *p, struct ld_plugin_symbol *entry,
 }
 
 /* Translate the IL symbol table located between DATA and END. Append the
-   slots and symbols to OUT. */
+   slots and symbols to OUT.  Return NULL, or an error message if the
+   table is invalid. */
 
-static void
+static const char *
 translate (char *data, char *end, struct plugin_symtab *out)
 {
+  const char *errmsg = NULL;
   struct sym_aux *aux;
   struct ld_plugin_symbol *syms = NULL;
   int n, len;
@@ -320,7 +344,14 @@ translate (char *data, char *end, struct plugin_symtab *out)
   for (n = out->nsyms; data < end; n++) 
     { 
       aux[n].id = out->id; 
-      data = parse_table_entry (data, &syms[n], &aux[n]);
+      data = parse_table_entry (data, &syms[n], &aux[n], &errmsg);
+      if (!data)
+	{
+	  /* The entry is not counted, so free what it got.  */
+	  free (syms[n].name);
+	  free (syms[n].comdat_key);
+	  break;
+	}
     }
 
   assert(n < len);
@@ -328,6 +359,7 @@ translate (char *data, char *end, struct plugin_symtab *out)
   out->nsyms = n;
   out->syms = syms;
   out->aux = aux;
+  return errmsg;
 }
 
 /* Free all memory that is no longer needed after writing the symbol
@@ -641,6 +673,11 @@ all_symbols_read_handler (void)
   char **lto_argv;
   const char *linker_output_str = NULL;
   const char **lto_arg_ptr;
+
+#ifdef HAVE_PTHREAD
+  /* The linker has read all its inputs.  */
+  stop_prefetch ();
+#endif
   if (num_claimed_files + num_offload_files == 0)
     return LDPS_OK;
 
@@ -750,6 +787,9 @@ cleanup_handler (void)
   unsigned int i;
   int t;
 
+#ifdef HAVE_PTHREAD
+  stop_prefetch ();
+#endif
   if (debug)
     return LDPS_OK;
 
@@ -901,6 +941,7 @@ process_symtab (void *data, const char *name, off_t offset, off_t length)
   struct plugin_objfile *obj = (struct plugin_objfile *)data;
   char *s;
   char *secdatastart, *secdata;
+  const char *errmsg;
 
   if (strncmp (name, LTO_SECTION_PREFIX, LTO_SECTION_PREFIX_LEN) != 0)
     return 1;
@@ -930,16 +971,25 @@ process_symtab (void *data, const char *name, off_t offset, off_t length)
   if (length > 0)
     goto err;
 
-  translate (secdatastart, secdata, obj->out);
+  errmsg = translate (secdatastart, secdata, obj->out);
+  if (errmsg)
+    {
+      if (!obj->prefetch)
+	check (0, LDPL_FATAL, errmsg);
+      /* Make scan_file report the failure.  */
+      obj->found = -1;
+      free (secdatastart);
+      return 0;
+    }
   obj->found++;
   free (secdatastart);
   return 1;
 
 err:
-  if (message)
+  if (message && !obj->prefetch)
     message (LDPL_FATAL, "%s: corrupt object file", obj->file->name);
   /* Force claim_file_handler to abandon this file.  */
-  obj->found = 0;
+  obj->found = obj->prefetch ? -1 : 0;
   free (secdatastart);
   return 0;
 }
@@ -959,6 +1009,411 @@ process_offload_section (void *data, const char *name, off_t offset, off_t len)
   return 1;
 }
 
+/* Read the LTO symbol tables of FILE into LTO_FILE and set *OFFLOAD if
+   FILE has offload sections.  PREFETCH is as in struct plugin_objfile.
+   Return the number of symbol tables found, or -1 on error.  */
+
+static int
+scan_file (const struct ld_plugin_input_file *file,
+	   struct plugin_file_info *lto_file, int *offload, int prefetch)
+{
+  struct plugin_objfile obj;
+  int err;
+  const char *errmsg;
+
+  obj.file = file;
+  obj.found = 0;
+  obj.offload = 0;
+  obj.out = &lto_file->symtab;
+  obj.prefetch = prefetch;
+  errmsg = NULL;
+  obj.objfile = simple_object_start_read (file->fd, file->offset, LTO_SEGMENT_NAME,
+			&errmsg, &err);
+  /* No file, but also no error code means unrecognized format; just skip it.  */
+  if (!obj.objfile && !err)
+    {
+      *offload = 0;
+      return 0;
+    }
+
+  if (obj.objfile)
+    errmsg = simple_object_find_sections (obj.objfile, process_symtab, &obj, &err);
+
+  if (!obj.objfile || errmsg || obj.found < 0)
+    {
+      /* process_symtab reported its own errors.  */
+      if (!prefetch && obj.found >= 0)
+	{
+	  if (err && message)
+	    message (LDPL_FATAL, "%s: %s: %s", file->name, errmsg,
+		     xstrerror (err));
+	  else if (message)
+	    message (LDPL_FATAL, "%s: %s", file->name, errmsg);
+	}
+      if (obj.objfile)
+	simple_object_release_read (obj.objfile);
+      return -1;
+    }
+
+  simple_object_find_sections (obj.objfile, process_offload_section,
+			       &obj, &err);
+  simple_object_release_read (obj.objfile);
+
+  if (obj.found > 1)
+    resolve_conflicts (&lto_file->symtab, &lto_file->conflicts);
+
+  *offload = obj.offload;
+  return obj.found;
+}
+
+/* Free the symbol tables of INFO.  */
+
+static void
+free_file_info_symtabs (struct plugin_file_info *info)
+{
+  int i;
+
+  for (i = 0; i < info->symtab.nsyms; i++)
+    {
+      free (info->symtab.syms[i].name);
+      free (info->symtab.syms[i].comdat_key);
+    }
+  for (i = 0; i < info->conflicts.nsyms; i++)
+    {
+      free (info->conflicts.syms[i].name);
+      free (info->conflicts.syms[i].comdat_key);
+    }
+  free_symtab (&info->symtab);
+  free_symtab (&info->conflicts);
+}
+
+#ifdef HAVE_PTHREAD
+/* The linker asks about the members of an archive one at a time and
+   mostly in order, and decoding their symbol tables is a visible part of
+   the link when there are thousands of them.  So when asked about a
+   member, queue the next members of the archive, and let helper threads
+   scan them while the linker works on the current one.  */
+
+enum prefetch_state
+{
+  PREFETCH_QUEUED,
+  PREFETCH_RUNNING,
+  PREFETCH_DONE,
+  /* Not wanted anymore while running; the helper frees it.  */
+  PREFETCH_ABANDONED
+};
+
+struct plugin_prefetch
+{
+  /* The member; NAME is the archive's and FD is the helper's own.  */
+  struct ld_plugin_input_file file;
+  enum prefetch_state state;
+  /* The result of scan_file.  */
+  int found;
+  int offload;
+  struct plugin_file_info info;
+  struct plugin_prefetch *next;
+};
+
+/* The number of helper threads, and how many members per thread may be
+   scanned ahead.  */
+static unsigned symtab_threads = 4;
+#define PREFETCH_WINDOW_PER_THREAD 4
+
+static pthread_t *prefetch_threads;
+static unsigned num_prefetch_threads;
+static pthread_mutex_t prefetch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prefetch_cond = PTHREAD_COND_INITIALIZER;
+static int prefetch_stop;
+
+/* The members queued, in archive order, and their number.  */
+static struct plugin_prefetch *prefetch_head, *prefetch_tail;
+static unsigned num_prefetches;
+
+/* The archive being read ahead, and where the header of the next member
+   to queue is, or -1 once its end has been reached.  */
+static char *prefetch_archive;
+static off_t prefetch_next_header = -1;
+
+/* Free PREFETCH, which is not in the queue anymore, and whatever it
+   read of the symbol tables, also when the scan failed half way.  */
+
+static void
+free_prefetch (struct plugin_prefetch *prefetch)
+{
+  free_file_info_symtabs (&prefetch->info);
+  free (prefetch);
+}
+
+/* Remove the first member from the queue.  Called with PREFETCH_LOCK
+   held.  */
+
+static void
+drop_first_prefetch (void)
+{
+  struct plugin_prefetch *prefetch = prefetch_head;
+
+  prefetch_head = prefetch->next;
+  if (!prefetch_head)
+    prefetch_tail = NULL;
+  num_prefetches--;
+  if (prefetch->state == PREFETCH_RUNNING)
+    prefetch->state = PREFETCH_ABANDONED;
+  else
+    free_prefetch (prefetch);
+}
+
+/* Body of the helper threads: scan the queued members.  */
+
+static void *
+prefetch_thread (void *arg ATTRIBUTE_UNUSED)
+{
+  int fd = -1;
+  char *fd_name = NULL;
+
+  pthread_mutex_lock (&prefetch_lock);
+  for (;;)
+    {
+      struct plugin_prefetch *prefetch;
+
+      for (prefetch = prefetch_head; prefetch; prefetch = prefetch->next)
+	if (prefetch->state == PREFETCH_QUEUED)
+	  break;
+      if (prefetch_stop)
+	break;
+      if (!prefetch)
+	{
+	  pthread_cond_wait (&prefetch_cond, &prefetch_lock);
+	  continue;
+	}
+      prefetch->state = PREFETCH_RUNNING;
+      pthread_mutex_unlock (&prefetch_lock);
+
+      if (!fd_name || strcmp (fd_name, prefetch->file.name) != 0)
+	{
+	  if (fd != -1)
+	    close (fd);
+	  free (fd_name);
+	  fd_name = xstrdup (prefetch->file.name);
+	  fd = open (fd_name, O_RDONLY | O_BINARY);
+	}
+      prefetch->file.fd = fd;
+      if (fd == -1)
+	prefetch->found = -1;
+      else
+	prefetch->found = scan_file (&prefetch->file, &prefetch->info,
+				     &prefetch->offload, 1);
+
+      pthread_mutex_lock (&prefetch_lock);
+      if (prefetch->state == PREFETCH_ABANDONED)
+	free_prefetch (prefetch);
+      else
+	prefetch->state = PREFETCH_DONE;
+      pthread_cond_broadcast (&prefetch_cond);
+    }
+  pthread_mutex_unlock (&prefetch_lock);
+
+  if (fd != -1)
+    close (fd);
+  free (fd_name);
+  return NULL;
+}
+
+/* Read COUNT bytes at OFFSET in FD into BUF, like pread.  FD may be the
+   linker's, so its file position is left alone.  */
+
+static ssize_t
+read_at (int fd, void *buf, size_t count, off_t offset)
+{
+#ifdef HAVE_PREAD
+  return pread (fd, buf, count, offset);
+#else
+  off_t pos = lseek (fd, 0, SEEK_CUR);
+  ssize_t got;
+
+  if (pos == -1 || lseek (fd, offset, SEEK_SET) != offset)
+    return -1;
+  got = read (fd, buf, count);
+  if (lseek (fd, pos, SEEK_SET) != pos)
+    return -1;
+  return got;
+#endif
+}
+
+/* Read the archive member header at OFFSET in FD and set *DATA and *SIZE
+   to the location of the member's contents.  Return the offset of the
+   next header, or -1 at the end of the archive or if the header is not
+   understood.  Set *DATA to -1 for the archive's own members.  */
+
+static off_t
+read_member_header (int fd, off_t offset, off_t *data, off_t *size)
+{
+  char hdr[60 + 1];
+  unsigned long namelen;
+
+  if (read_at (fd, hdr, 60, offset) != 60
+      || hdr[58] != '`' || hdr[59] != '\n')
+    return -1;
+  hdr[58] = '\0';
+  *size = strtoll (hdr + 48, NULL, 10);
+  *data = offset + 60;
+  offset = *data + *size + (*size & 1);
+
+  if ((hdr[0] == '/'
+       && (hdr[1] == ' ' || hdr[1] == '/' || !strncmp (hdr, "/SYM64/", 7)))
+      || !strncmp (hdr, "__.SYMDEF", 9))
+    /* Symbol index or long name table.  Other names starting with '/'
+       refer to a long name in that table.  */
+    *data = -1;
+  else if (!strncmp (hdr, "#1/", 3))
+    {
+      /* BSD name stored at the start of the contents.  */
+      namelen = strtoul (hdr + 3, NULL, 10);
+      *data += namelen;
+      *size -= namelen;
+    }
+  return offset;
+}
+
+/* Queue the members of the archive FILE is a member of that follow FILE,
+   up to the window size, and start the helper threads if needed.  Called
+   with PREFETCH_LOCK held.  */
+
+static void
+queue_prefetches (const struct ld_plugin_input_file *file)
+{
+  off_t end = file->offset + file->filesize;
+  unsigned window = symtab_threads * PREFETCH_WINDOW_PER_THREAD;
+
+  end += end & 1;
+  if (!prefetch_archive || strcmp (prefetch_archive, file->name) != 0)
+    {
+      char magic[8];
+
+      while (prefetch_head)
+	drop_first_prefetch ();
+      free (prefetch_archive);
+      prefetch_archive = xstrdup (file->name);
+      /* Members of thin archives are separate files.  */
+      if (read_at (file->fd, magic, 8, 0) != 8
+	  || memcmp (magic, "!<arch>\n", 8) != 0)
+	prefetch_next_header = -1;
+      else
+	prefetch_next_header = end;
+    }
+  else if (prefetch_next_header != -1 && end > prefetch_next_header)
+    prefetch_next_header = end;
+
+  while (num_prefetches < window && prefetch_next_header != -1)
+    {
+      off_t data, size;
+      struct plugin_prefetch *prefetch;
+
+      prefetch_next_header = read_member_header (file->fd,
+						 prefetch_next_header,
+						 &data, &size);
+      if (prefetch_next_header == -1 || data == -1)
+	continue;
+
+      prefetch = xmalloc (sizeof (struct plugin_prefetch));
+      memset (prefetch, 0, sizeof (struct plugin_prefetch));
+      prefetch->file.name = prefetch_archive;
+      prefetch->file.fd = -1;
+      prefetch->file.offset = data;
+      prefetch->file.filesize = size;
+      prefetch->state = PREFETCH_QUEUED;
+      if (prefetch_tail)
+	prefetch_tail->next = prefetch;
+      else
+	prefetch_head = prefetch;
+      prefetch_tail = prefetch;
+      num_prefetches++;
+    }
+
+  if (!prefetch_threads && prefetch_head)
+    {
+      prefetch_threads = xmalloc (symtab_threads * sizeof (pthread_t));
+      while (num_prefetch_threads < symtab_threads
+	     && pthread_create (&prefetch_threads[num_prefetch_threads], NULL,
+				prefetch_thread, NULL) == 0)
+	num_prefetch_threads++;
+      if (!num_prefetch_threads)
+	{
+	  /* Scan everything on the linker's thread.  */
+	  symtab_threads = 0;
+	  while (prefetch_head)
+	    drop_first_prefetch ();
+	}
+    }
+  pthread_cond_broadcast (&prefetch_cond);
+}
+
+/* If FILE was scanned ahead, move the result into LTO_FILE and *OFFLOAD
+   and return what scan_file returned.  Otherwise, or if the scan failed,
+   return -1.  Then queue the members that follow FILE.  */
+
+static int
+take_prefetched (const struct ld_plugin_input_file *file,
+		 struct plugin_file_info *lto_file, int *offload)
+{
+  int found = -1;
+
+  if (!symtab_threads || prefetch_stop || file->offset == 0)
+    return -1;
+
+  pthread_mutex_lock (&prefetch_lock);
+  if (prefetch_archive && strcmp (prefetch_archive, file->name) == 0)
+    {
+      /* Forget the members the linker skipped.  */
+      while (prefetch_head && prefetch_head->file.offset < file->offset)
+	drop_first_prefetch ();
+
+      if (prefetch_head && prefetch_head->file.offset == file->offset)
+	{
+	  struct plugin_prefetch *prefetch = prefetch_head;
+
+	  while (prefetch->state != PREFETCH_DONE)
+	    pthread_cond_wait (&prefetch_cond, &prefetch_lock);
+	  if (prefetch->found >= 0)
+	    {
+	      found = prefetch->found;
+	      *offload = prefetch->offload;
+	      lto_file->symtab = prefetch->info.symtab;
+	      lto_file->conflicts = prefetch->info.conflicts;
+	      memset (&prefetch->info, 0, sizeof (prefetch->info));
+	    }
+	  drop_first_prefetch ();
+	}
+    }
+  queue_prefetches (file);
+  pthread_mutex_unlock (&prefetch_lock);
+  return found;
+}
+
+/* Stop the helper threads and forget the queued members.  */
+
+static void
+stop_prefetch (void)
+{
+  unsigned i;
+
+  pthread_mutex_lock (&prefetch_lock);
+  prefetch_stop = 1;
+  while (prefetch_head)
+    drop_first_prefetch ();
+  pthread_cond_broadcast (&prefetch_cond);
+  pthread_mutex_unlock (&prefetch_lock);
+
+  for (i = 0; i < num_prefetch_threads; i++)
+    pthread_join (prefetch_threads[i], NULL);
+  free (prefetch_threads);
+  prefetch_threads = NULL;
+  num_prefetch_threads = 0;
+  free (prefetch_archive);
+  prefetch_archive = NULL;
+}
+#endif
+
 /* Callback used by gold to check if the plugin will claim FILE. Writes
    the result in CLAIMED. */
 
@@ -966,10 +1421,9 @@ static enum ld_plugin_status
 claim_file_handler (const struct ld_plugin_input_file *file, int *claimed)
 {
   enum ld_plugin_status status;
-  struct plugin_objfile obj;
   struct plugin_file_info lto_file;
-  int err;
-  const char *errmsg;
+  int found = -1;
+  int offload = 0;
 
   memset (&lto_file, 0, sizeof (struct plugin_file_info));
 
@@ -994,41 +1448,16 @@ claim_file_handler (const struct ld_plugin_input_file *file, int *claimed)
   lto_file.handle = file->handle;
 
   *claimed = 0;
-  obj.file = file;
-  obj.found = 0;
-  obj.offload = 0;
-  obj.out = &lto_file.symtab;
-  errmsg = NULL;
-  obj.objfile = simple_object_start_read (file->fd, file->offset, LTO_SEGMENT_NAME,
-			&errmsg, &err);
-  /* No file, but also no error code means unrecognized format; just skip it.  */
-  if (!obj.objfile && !err)
-    goto err;
-
-  if (obj.objfile)
-    errmsg = simple_object_find_sections (obj.objfile, process_symtab, &obj, &err);
-
-  if (!obj.objfile || errmsg)
-    {
-      if (err && message)
-	message (LDPL_FATAL, "%s: %s: %s", file->name, errmsg,
-		xstrerror (err));
-      else if (message)
-	message (LDPL_FATAL, "%s: %s", file->name, errmsg);
-      goto err;
-    }
-
-  if (obj.objfile)
-    simple_object_find_sections (obj.objfile, process_offload_section,
-				 &obj, &err);
+#ifdef HAVE_PTHREAD
+  found = take_prefetched (file, &lto_file, &offload);
+#endif
+  if (found < 0)
+    found = scan_file (file, &lto_file, &offload, 0);
 
-  if (obj.found == 0 && obj.offload == 0)
+  if (found <= 0 && offload == 0)
     goto err;
 
-  if (obj.found > 1)
-    resolve_conflicts (&lto_file.symtab, &lto_file.conflicts);
-
-  if (obj.found > 0)
+  if (found > 0)
     {
       status = add_symbols (file->handle, lto_file.symtab.nsyms,
 			    lto_file.symtab.syms);
@@ -1055,10 +1484,10 @@ claim_file_handler (const struct ld_plugin_input_file *file, int *claimed)
   /* If this is an LTO file without offload, and it is the first LTO file, save
      the pointer to the last offload file in the list.  Further offload LTO
      files will be inserted after it, if any.  */
-  if (*claimed && obj.offload == 0 && offload_files_last_lto == NULL)
+  if (*claimed && offload == 0 && offload_files_last_lto == NULL)
     offload_files_last_lto = offload_files_last;
 
-  if (obj.offload == 1)
+  if (offload == 1)
     {
       /* Add file to the list.  The order must be exactly the same as the final
 	 order after recompilation and linking, otherwise host and target tables
@@ -1106,15 +1535,10 @@ claim_file_handler (const struct ld_plugin_input_file *file, int *claimed)
       num_offload_files++;
     }
 
-  goto cleanup;
+  return LDPS_OK;
 
  err:
   free (lto_file.name);
-
- cleanup:
-  if (obj.objfile)
-    simple_object_release_read (obj.objfile);
-
   return LDPS_OK;
 }
 
@@ -1135,6 +1559,22 @@ process_option (const char *option)
       pass_through_items[num_pass_through_items - 1] =
           xstrdup (option + strlen ("-pass-through="));
     }
+#ifdef HAVE_PTHREAD
+  else if (!strncmp (option, "-symtab-threads=",
+		     sizeof ("-symtab-threads=") - 1))
+    {
+      const char *arg = option + sizeof ("-symtab-threads=") - 1;
+      char *end;
+      long n;
+
+      errno = 0;
+      n = strtol (arg, &end, 10);
+      check (*arg && !*end && !errno && n >= 0 && n <= 1024, LDPL_FATAL,
+	     "-symtab-threads= wants a number of threads from 0 to 1024");
+      if (n >= 0 && n <= 1024)
+	symtab_threads = n;
+    }
+#endif
   else if (!strncmp (option, "-sym-style=", sizeof ("-sym-style=") - 1))
     {
       switch (option[sizeof ("-sym-style=") - 1])